@@ -0,0 +1,186 @@
+#include "CANBcmSocket.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/bcm.h>
+#include <poll.h>
+
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+// limit of the kernel for the frames of one job
+const unsigned MAX_FRAMES = 256;
+
+static_assert( int(CANBcmSocket::Notification::TX_EXPIRED) == int(TX_EXPIRED), "opcode does not match the kernel");
+static_assert( int(CANBcmSocket::Notification::RX_TIMEOUT) == int(RX_TIMEOUT), "opcode does not match the kernel");
+static_assert( int(CANBcmSocket::Notification::RX_CHANGED) == int(RX_CHANGED), "opcode does not match the kernel");
+
+canid_t toCanId( const NET::can_id& id)
+{
+	canid_t ret;
+	std::memcpy( &ret, &id, sizeof(ret));
+	return ret;
+}
+
+NET::can_id fromCanId( canid_t id)
+{
+	NET::can_id ret;
+	std::memcpy( &ret, &id, sizeof(ret));
+	return ret;
+}
+
+bcm_timeval toTimeval( unsigned long usec)
+{
+	bcm_timeval ret;
+	ret.tv_sec = static_cast<long>(usec / 1000000);
+	ret.tv_usec = static_cast<long>(usec % 1000000);
+	return ret;
+}
+
+//! A message to the broadcast manager, the head followed by the frames
+class BcmMessage
+{
+public:
+	BcmMessage( uint32_t opcode, uint32_t flags, const NET::can_id& id)
+	{
+		std::memset( m_buffer, 0, sizeof(bcm_msg_head));
+		head().opcode = opcode;
+		head().flags = flags;
+		head().can_id = toCanId(id);
+	}
+
+	bcm_msg_head& head() { return *reinterpret_cast<bcm_msg_head*>(m_buffer); }
+
+	void setFrames( const NET::can_frame* frames, unsigned nframes)
+	{
+		head().nframes = nframes;
+		std::memcpy( m_buffer + sizeof(bcm_msg_head), frames, nframes * sizeof(NET::can_frame));
+	}
+
+	void write( int socket, const char* message)
+	{
+		size_t len = sizeof(bcm_msg_head) + head().nframes * sizeof(NET::can_frame);
+		if( TEMP_FAILURE_RETRY (::write( socket, m_buffer, len)) != static_cast<ssize_t>(len))
+			throw SocketException(message);
+	}
+
+private:
+	alignas(bcm_msg_head) uint8_t m_buffer[sizeof(bcm_msg_head) + MAX_FRAMES * sizeof(NET::can_frame)];
+};
+
+} // namespace
+
+CANBcmSocket::CANBcmSocket()
+: CANSocket( DATAGRAM, CAN_BCM)
+{}
+
+void CANBcmSocket::startCyclic( const can_frame& frame, unsigned long interval)
+{
+	startCyclic( &frame, 1, interval);
+}
+
+void CANBcmSocket::startCyclic( const can_frame* frames, unsigned nframes, unsigned long interval,
+                                unsigned count /* = 0 */, unsigned long initialInterval /* = 0 */)
+{
+	if( nframes == 0 || nframes > MAX_FRAMES)
+		throw SocketException("Number of frames has to be between 1 and 256", false);
+
+	BcmMessage msg( TX_SETUP, SETTIMER | STARTTIMER, frames[0].id);
+	if( count)
+	{
+		msg.head().flags |= TX_COUNTEVT;
+		msg.head().count = count;
+		msg.head().ival1 = toTimeval(initialInterval);
+	}
+	msg.head().ival2 = toTimeval(interval);
+	msg.setFrames( frames, nframes);
+	msg.write( m_socket, "Setup of cyclic transmission failed (write)");
+}
+
+void CANBcmSocket::updateCyclic( const can_frame* frames, unsigned nframes, bool sendNow /* = false */)
+{
+	if( nframes == 0 || nframes > MAX_FRAMES)
+		throw SocketException("Number of frames has to be between 1 and 256", false);
+
+	// without SETTIMER and STARTTIMER the timer of the job keeps running
+	BcmMessage msg( TX_SETUP, sendNow ? TX_ANNOUNCE : 0, frames[0].id);
+	msg.setFrames( frames, nframes);
+	msg.write( m_socket, "Update of cyclic transmission failed (write)");
+}
+
+void CANBcmSocket::stopCyclic( const can_id& id)
+{
+	BcmMessage msg( TX_DELETE, 0, id);
+	msg.write( m_socket, "Stop of cyclic transmission failed (write)");
+}
+
+void CANBcmSocket::sendOnce( const can_frame& frame)
+{
+	BcmMessage msg( TX_SEND, 0, frame.id);
+	msg.setFrames( &frame, 1);
+	msg.write( m_socket, "Send failed (write)");
+}
+
+void CANBcmSocket::subscribe( const can_id& id, unsigned long timeout /* = 0 */)
+{
+	BcmMessage msg( RX_SETUP, RX_FILTER_ID, id);
+	if( timeout)
+	{
+		msg.head().flags |= SETTIMER | STARTTIMER;
+		msg.head().ival1 = toTimeval(timeout);
+	}
+	msg.write( m_socket, "Subscription failed (write)");
+}
+
+void CANBcmSocket::subscribeChanges( const can_frame& mask, unsigned long timeout /* = 0 */, unsigned long throttle /* = 0 */)
+{
+	BcmMessage msg( RX_SETUP, RX_CHECK_DLC, mask.id);
+	if( timeout || throttle)
+	{
+		msg.head().flags |= SETTIMER | STARTTIMER;
+		msg.head().ival1 = toTimeval(timeout);
+		msg.head().ival2 = toTimeval(throttle);
+	}
+	msg.setFrames( &mask, 1);
+	msg.write( m_socket, "Subscription failed (write)");
+}
+
+void CANBcmSocket::unsubscribe( const can_id& id)
+{
+	BcmMessage msg( RX_DELETE, 0, id);
+	msg.write( m_socket, "Unsubscription failed (write)");
+}
+
+bool CANBcmSocket::receiveNotification( Notification& notification, int timeout)
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return false;
+	if( ret < 0)  throw SocketException("Receive failed (poll)");
+
+	// notifications carry at most one frame
+	alignas(bcm_msg_head) uint8_t buffer[sizeof(bcm_msg_head) + sizeof(NET::can_frame)];
+	const size_t frameLen = sizeof(buffer);
+
+	ssize_t len = TEMP_FAILURE_RETRY (::read( m_socket, buffer, sizeof(buffer)));
+	if( len < static_cast<ssize_t>(sizeof(bcm_msg_head)))
+		throw SocketException("Receive failed (read)");
+
+	const bcm_msg_head* head = reinterpret_cast<const bcm_msg_head*>(buffer);
+	notification.type = static_cast<Notification::Type>(head->opcode);
+	notification.id = fromCanId(head->can_id);
+	if( head->nframes && static_cast<size_t>(len) == frameLen)
+		std::memcpy( &notification.frame, buffer + sizeof(bcm_msg_head), sizeof(notification.frame));
+	else
+		std::memset( &notification.frame, 0, sizeof(notification.frame));
+
+	return true;
+}
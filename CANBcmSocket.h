@@ -0,0 +1,157 @@
+#ifndef NET_CANBcmSocket_h__
+#define NET_CANBcmSocket_h__
+
+#include "CANSocket.h"
+#include "CANFrame.h"
+
+#include <cstdint>
+
+namespace NET
+{
+	//! CAN broadcast manager socket class
+	/*!
+	 * CANBcmSocket hands cyclic transmission and content filtering of CAN
+	 * frames to the broadcast manager of the kernel (CAN_BCM). The kernel
+	 * sends cyclic frames by its own high resolution timers, and wakes the
+	 * receiver only if the relevant content of a frame changed or a frame
+	 * did not arrive in time.
+	 *
+	 * All jobs of a socket belong to the interface it is connected to,
+	 * connect() has to be called before any job is set up. Jobs end when
+	 * the socket is closed. Intervals are given in microseconds.
+	 *
+	 * Usage example:
+	 * \code
+	 * CANBcmSocket socket;
+	 * socket.connect("can0");
+	 * socket.startCyclic( frame, 10000);
+	 * frame[0] = 42;
+	 * socket.updateCyclic( &frame, 1);
+	 * \endcode
+	 */
+	class CANBcmSocket : public CANSocket
+	{
+	public:
+		//! Notification sent by the broadcast manager
+		struct Notification
+		{
+			//! Cause of a notification, values of the kernel
+			enum Type
+			{
+				TX_EXPIRED = 9,  ///< a cyclic transmission with a limited count ended
+				RX_TIMEOUT = 11, ///< a subscribed frame did not arrive in time
+				RX_CHANGED = 12  ///< a subscribed frame arrived with changed content
+			};
+
+			Type type;
+			can_id id;       ///< id of the job
+			can_frame frame; ///< received frame, valid for RX_CHANGED only
+		};
+
+		/*!
+		 * Construct a broadcast manager socket
+		 * \exception SocketException thrown if unable to create the socket
+		 */
+		CANBcmSocket();
+
+		/*!
+		 * Start to send a frame cyclically. A running job for the same id
+		 * is replaced.
+		 *
+		 * \param frame frame to send
+		 * \param interval time between two frames in microseconds
+		 * \exception SocketException thrown if unable to set up the job
+		 */
+		void startCyclic( const can_frame& frame, unsigned long interval);
+
+		/*!
+		 * Start to send a sequence of frames cyclically, one frame per
+		 * interval. All frames belong to the job of the id of the first
+		 * frame. A running job for that id is replaced.
+		 *
+		 * If count is not zero, the first count frames are sent with
+		 * initialInterval, followed by a notification of type TX_EXPIRED.
+		 * Sending then goes on with interval, if that is not zero.
+		 *
+		 * \param frames frames to send, at most 256
+		 * \param nframes number of frames
+		 * \param interval time between two frames in microseconds
+		 * \param count number of frames sent with initialInterval
+		 * \param initialInterval time between the first count frames in microseconds
+		 * \exception SocketException thrown if unable to set up the job
+		 */
+		void startCyclic( const can_frame* frames, unsigned nframes, unsigned long interval,
+		                  unsigned count = 0, unsigned long initialInterval = 0);
+
+		/*!
+		 * Replace the payload of a running cyclic job. The kernel swaps
+		 * the frames between two transmissions, so no frame is sent with
+		 * partly updated content and the timing is not disturbed.
+		 *
+		 * A job stays in the kernel until stopCyclic(), even after its count
+		 * ran out. If there is no job for the id, the kernel sets up one
+		 * without a timer, which only sends the frame if sendNow is given.
+		 *
+		 * \param frames new frames, the id of the first selects the job
+		 * \param nframes number of frames, at most the number of the running job
+		 * \param sendNow send the first new frame immediately
+		 * \exception SocketException thrown if unable to update the job
+		 */
+		void updateCyclic( const can_frame* frames, unsigned nframes, bool sendNow = false);
+
+		/*!
+		 * Stop a cyclic job.
+		 * \param id id of the job
+		 * \exception SocketException thrown if there is no such job
+		 */
+		void stopCyclic( const can_id& id);
+
+		/*!
+		 * Send a single frame through the broadcast manager.
+		 * \param frame frame to send
+		 * \exception SocketException thrown if unable to send
+		 */
+		void sendOnce( const can_frame& frame);
+
+		/*!
+		 * Subscribe to all frames of an id. Every received frame is
+		 * delivered as notification of type RX_CHANGED.
+		 *
+		 * \param id id of the frames
+		 * \param timeout report RX_TIMEOUT if no frame arrived within this time in microseconds, 0 to disable
+		 * \exception SocketException thrown if unable to set up the job
+		 */
+		void subscribe( const can_id& id, unsigned long timeout = 0);
+
+		/*!
+		 * Subscribe to changes of the content of frames of an id. A
+		 * notification of type RX_CHANGED is only delivered if bits set in
+		 * the mask or the length of the frame changed.
+		 *
+		 * \param mask id of the frames, data contains the bits to watch
+		 * \param timeout report RX_TIMEOUT if no frame arrived within this time in microseconds, 0 to disable
+		 * \param throttle minimum time between two notifications in microseconds, 0 to disable
+		 * \exception SocketException thrown if unable to set up the job
+		 */
+		void subscribeChanges( const can_frame& mask, unsigned long timeout = 0, unsigned long throttle = 0);
+
+		/*!
+		 * End a subscription.
+		 * \param id id of the frames
+		 * \exception SocketException thrown if there is no such subscription
+		 */
+		void unsubscribe( const can_id& id);
+
+		/*!
+		 * Wait for the next notification of the broadcast manager.
+		 * \param notification set to the received notification
+		 * \param timeout timeout in milliseconds, -1 to wait forever
+		 * \return false on timeout
+		 * \exception SocketException thrown if unable to receive
+		 */
+		bool receiveNotification( Notification& notification, int timeout);
+	};
+
+} // namespace NET
+
+#endif // NET_CANBcmSocket_h__
@@ -0,0 +1,116 @@
+#include "CANFilterTable.h"
+
+#include <algorithm>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace NET;
+
+namespace {
+
+const uint32_t EXTENDED_FLAG = 0x80000000U;
+const uint32_t REMOTE_FLAG = 0x40000000U;
+const uint32_t INVERT_FLAG = 0x20000000U;
+
+// number of filters compared at once
+const size_t LANES = 4;
+
+} // namespace
+
+CANFilterTable::CANFilterTable()
+: m_filterCount(0)
+{}
+
+void CANFilterTable::assign( const can_filter* filters, size_t len)
+{
+	m_filterCount = len;
+	m_exact.clear();
+	m_ids.clear();
+	m_masks.clear();
+	m_invertedIds.clear();
+	m_invertedMasks.clear();
+
+	for( size_t i = 0; i < len; ++i)
+	{
+		uint32_t id = raw_id(filters[i].id);
+		uint32_t mask = raw_id(filters[i].mask) & ~INVERT_FLAG;
+		bool inverted = id & INVERT_FLAG;
+		id &= mask;
+
+		if( inverted)
+		{
+			m_invertedIds.push_back(id);
+			m_invertedMasks.push_back(mask);
+			continue;
+		}
+
+		// a filter covering all id bits of its format and the format
+		// itself passes one id, or two if the remote flag is ignored
+		uint32_t idBits = (id & EXTENDED_FLAG) ? CAN_EXTENDED_MASK : CAN_STANDARD_MASK;
+		if( (mask & (EXTENDED_FLAG | idBits)) == (EXTENDED_FLAG | idBits))
+		{
+			m_exact.push_back(id);
+			if( !(mask & REMOTE_FLAG))
+				m_exact.push_back( id | REMOTE_FLAG);
+			continue;
+		}
+
+		m_ids.push_back(id);
+		m_masks.push_back(mask);
+	}
+
+	std::sort( m_exact.begin(), m_exact.end());
+	m_exact.erase( std::unique( m_exact.begin(), m_exact.end()), m_exact.end());
+
+	// pad to full SIMD lanes with entries that never match
+	while( m_ids.size() % LANES)
+	{
+		m_ids.push_back(1);
+		m_masks.push_back(0);
+	}
+}
+
+bool CANFilterTable::matches( const can_id& id) const
+{
+	// the error flag is not part of the id of a frame passing filters
+	uint32_t raw = raw_id(id) & ~INVERT_FLAG;
+
+	if( std::binary_search( m_exact.begin(), m_exact.end(), raw))
+		return true;
+
+	if( matchesMasked(raw))
+		return true;
+
+	for( size_t i = 0; i < m_invertedIds.size(); ++i)
+		if( (raw & m_invertedMasks[i]) != m_invertedIds[i])
+			return true;
+
+	return false;
+}
+
+bool CANFilterTable::matchesMasked( uint32_t id) const
+{
+	const uint32_t* ids = m_ids.data();
+	const uint32_t* masks = m_masks.data();
+	size_t count = m_ids.size();
+
+#ifdef __SSE2__
+	__m128i frame = _mm_set1_epi32( static_cast<int>(id));
+	for( size_t i = 0; i < count; i += LANES)
+	{
+		__m128i mask = _mm_loadu_si128( reinterpret_cast<const __m128i*>(masks + i));
+		__m128i filter = _mm_loadu_si128( reinterpret_cast<const __m128i*>(ids + i));
+		__m128i equal = _mm_cmpeq_epi32( _mm_and_si128( frame, mask), filter);
+		if( _mm_movemask_epi8(equal))
+			return true;
+	}
+#else
+	for( size_t i = 0; i < count; ++i)
+		if( (id & masks[i]) == ids[i])
+			return true;
+#endif
+
+	return false;
+}
@@ -0,0 +1,61 @@
+#ifndef NET_CANFilterTable_h__
+#define NET_CANFilterTable_h__
+
+#include "CANFrame.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace NET
+{
+	//! Matches CAN ids against a large set of filters in user space
+	/*!
+	 * The kernel checks every filter that is not a single exact id one
+	 * by one for every frame on the bus, and limits the number of filters
+	 * of a socket. CANFilterTable compiles any number of filters into a
+	 * sorted table of exact ids, looked up by binary search, and arrays of
+	 * ids and masks, compared four at a time with SIMD instructions if
+	 * available. It follows the semantics of the kernel filters, including
+	 * inverted filters.
+	 */
+	class CANFilterTable
+	{
+	public:
+		//! construct an empty table, passing no frames
+		CANFilterTable();
+
+		/*!
+		 * Replace the filters of the table.
+		 * \param filters filters to compile
+		 * \param len number of filters
+		 */
+		void assign( const can_filter* filters, size_t len);
+
+		/*!
+		 * Check a frame against all filters.
+		 * \param id id of the frame
+		 * \return true if any filter passes the frame
+		 */
+		bool matches( const can_id& id) const;
+
+		//! return true if no filter is set
+		bool empty() const { return m_filterCount == 0; }
+
+		//! return the number of filters
+		size_t size() const { return m_filterCount; }
+
+	private:
+		bool matchesMasked( uint32_t id) const;
+
+		size_t m_filterCount;
+		std::vector<uint32_t> m_exact;
+		std::vector<uint32_t> m_ids;
+		std::vector<uint32_t> m_masks;
+		std::vector<uint32_t> m_invertedIds;
+		std::vector<uint32_t> m_invertedMasks;
+	};
+
+} // namespace NET
+
+#endif // NET_CANFilterTable_h__
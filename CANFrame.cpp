@@ -3,8 +3,22 @@
 #include <sys/socket.h>
 #include <linux/can.h>
 
-#include <stdexcept>
-#include <cstring>
+#include <cstddef>
 
 using namespace NET;
 
+// The frames are passed to the kernel without conversion
+static_assert( sizeof(NET::can_id) == sizeof(canid_t), "can_id does not match the kernel");
+static_assert( sizeof(NET::can_frame) == sizeof(::can_frame), "can_frame does not match the kernel");
+static_assert( offsetof(NET::can_frame, dlc) == offsetof(::can_frame, can_dlc), "can_frame does not match the kernel");
+static_assert( offsetof(NET::can_frame, data) == offsetof(::can_frame, data), "can_frame does not match the kernel");
+static_assert( sizeof(NET::canfd_frame) == sizeof(::canfd_frame), "canfd_frame does not match the kernel");
+static_assert( offsetof(NET::canfd_frame, len) == offsetof(::canfd_frame, len), "canfd_frame does not match the kernel");
+static_assert( offsetof(NET::canfd_frame, flags) == offsetof(::canfd_frame, flags), "canfd_frame does not match the kernel");
+static_assert( offsetof(NET::canfd_frame, data) == offsetof(::canfd_frame, data), "canfd_frame does not match the kernel");
+static_assert( sizeof(NET::can_filter) == sizeof(::can_filter), "can_filter does not match the kernel");
+static_assert( NET::canfd_frame::BIT_RATE_SWITCH == CANFD_BRS && NET::canfd_frame::ERROR_STATE == CANFD_ESI, "flags do not match the kernel");
+
+// bit fields are allocated starting at the least significant bit
+static_assert( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "can_id requires a little endian target");
+static_assert( CAN_STANDARD_MASK == CAN_SFF_MASK && CAN_EXTENDED_MASK == CAN_EFF_MASK, "masks do not match the kernel");
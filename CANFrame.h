@@ -5,10 +5,15 @@
 
 namespace NET
 {
-	// TODO This classes are just simple prototypes for now
-	// TODO You must not forget to initialize the CAN structs!
+	// The structs share their layout with the ones of linux/can.h, so
+	// frames can be passed to the kernel without copying. They are plain
+	// aggregates and have to be initialized by the user.
 
 	//! Represents any possible CAN id or mask
+	/*!
+	 * Within a filter, error_flag of the id inverts the filter
+	 * (CAN_INV_FILTER).
+	 */
 	struct can_id
 	{
 		uint32_t value : 29;
@@ -17,6 +22,30 @@ namespace NET
 		uint32_t ext_format : 1;
 	};
 
+	//! bits of a standard id
+	const uint32_t CAN_STANDARD_MASK = 0x7ff;
+
+	//! bits of an extended id
+	const uint32_t CAN_EXTENDED_MASK = 0x1fffffff;
+
+	//! build a standard (11 bit) id
+	constexpr can_id standard_id( uint32_t id)
+	{
+		return can_id{ id & CAN_STANDARD_MASK, 0, 0, 0 };
+	}
+
+	//! build an extended (29 bit) id
+	constexpr can_id extended_id( uint32_t id)
+	{
+		return can_id{ id & CAN_EXTENDED_MASK, 0, 0, 1 };
+	}
+
+	//! return the id with all flags as used by the kernel (canid_t)
+	constexpr uint32_t raw_id( can_id id)
+	{
+		return id.value | uint32_t(id.error_flag) << 29 | uint32_t(id.rtr_flag) << 30 | uint32_t(id.ext_format) << 31;
+	}
+
 	//! Structure to represent a CAN 2.0 Frame.
 	struct can_frame
 	{
@@ -35,13 +64,72 @@ namespace NET
 		uint8_t& operator[]( unsigned index) { return data[index]; }
 	};
 
+	//! Structure to represent a CAN FD Frame.
+	/*!
+	 * The layout matches can_frame up to the data, so a classic frame
+	 * received into a canfd_frame has its dlc in len.
+	 */
+	struct canfd_frame
+	{
+		//! Values of flags
+		enum Flags
+		{
+			BIT_RATE_SWITCH = 0x01, ///< data is sent with the higher bit rate
+			ERROR_STATE = 0x02      ///< the sender is error passive
+		};
+
+		can_id id;
+		uint8_t len;
+		uint8_t flags;
+		uint8_t _res0_;
+		uint8_t _res1_;
+		uint8_t data[64];
+
+		//! Cast-Operator for use with sockets
+		operator void* () { return this; }
+
+		//! Constant Cast-Operator for use with sockets
+		operator const void* () const { return this; }
+
+		//! Access to all data bytes
+		uint8_t& operator[]( unsigned index) { return data[index]; }
+	};
+
+	//! size of a classic CAN frame on the socket
+	const unsigned CAN_FRAME_SIZE = sizeof(can_frame);
+
+	//! size of a CAN FD frame on the socket
+	const unsigned CANFD_FRAME_SIZE = sizeof(canfd_frame);
+
 	//! Structure of id and mask used by filters
+	/*!
+	 * A frame passes the filter if its id, including the flags, equals
+	 * the id of the filter in all bits set in the mask.
+	 */
 	struct can_filter
 	{
 		can_id id;
 		can_id mask;
 	};
 
+	//! filter passing data and remote frames of exactly the given id
+	constexpr can_filter exact_filter( can_id id)
+	{
+		return can_filter{ id, can_id{ id.ext_format ? CAN_EXTENDED_MASK : CAN_STANDARD_MASK, 0, 0, 1 } };
+	}
+
+	//! filter passing all ids of the same format that equal id in the bits set in mask
+	constexpr can_filter mask_filter( can_id id, uint32_t mask)
+	{
+		return can_filter{ id, can_id{ mask & CAN_EXTENDED_MASK, 0, 0, 1 } };
+	}
+
+	//! filter passing all frames the given filter does not pass
+	constexpr can_filter inverted_filter( can_filter filter)
+	{
+		return can_filter{ can_id{ filter.id.value, 1, filter.id.rtr_flag, filter.id.ext_format }, filter.mask };
+	}
+
 } // namespace NET
 
 #endif // NET_CANFrame_h__
@@ -0,0 +1,85 @@
+#include "CANIsoTpSocket.h"
+
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/isotp.h>
+
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+canid_t toCanId( const NET::can_id& id)
+{
+	canid_t ret;
+	std::memcpy( &ret, &id, sizeof(ret));
+	return ret;
+}
+
+// the options are only set as a whole
+can_isotp_options getOptions( int socket)
+{
+	can_isotp_options opts;
+	socklen_t len = sizeof(opts);
+
+	if( getsockopt( socket, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &opts, &len) < 0)
+		throw SocketException("Fetch of options failed (getsockopt)");
+
+	return opts;
+}
+
+void setOptions( int socket, const can_isotp_options& opts)
+{
+	if( setsockopt( socket, SOL_CAN_ISOTP, CAN_ISOTP_OPTS, &opts, sizeof(opts)) < 0)
+		throw SocketException("Set of options failed (setsockopt)");
+}
+
+} // namespace
+
+CANIsoTpSocket::CANIsoTpSocket()
+: CANSocket( DATAGRAM, CAN_ISOTP)
+{}
+
+void CANIsoTpSocket::bind( const std::string& interface, const can_id& txId, const can_id& rxId)
+{
+	sockaddr_can addr;
+	std::memset( &addr, 0, sizeof(addr));
+	addr.can_family = AF_CAN;
+	addr.can_ifindex = getInterfaceIndex(interface);
+	addr.can_addr.tp.tx_id = toCanId(txId);
+	addr.can_addr.tp.rx_id = toCanId(rxId);
+
+	if( ::bind( m_socket, (sockaddr*) &addr, sizeof(addr)) < 0)
+		throw SocketException("Set of interface failed (bind)");
+}
+
+void CANIsoTpSocket::setFlowControl( uint8_t blockSize, uint8_t separationTime, uint8_t maxWaitFrames /* = 0 */)
+{
+	can_isotp_fc_options fc;
+	fc.bs = blockSize;
+	fc.stmin = separationTime;
+	fc.wftmax = maxWaitFrames;
+
+	if( setsockopt( m_socket, SOL_CAN_ISOTP, CAN_ISOTP_RECV_FC, &fc, sizeof(fc)) < 0)
+		throw SocketException("Set flow control failed (setsockopt)");
+}
+
+void CANIsoTpSocket::setTransmitSeparationTime( uint32_t nsec)
+{
+	if( setsockopt( m_socket, SOL_CAN_ISOTP, CAN_ISOTP_TX_STMIN, &nsec, sizeof(nsec)) < 0)
+		throw SocketException("Set separation time failed (setsockopt)");
+
+	can_isotp_options opts = getOptions(m_socket);
+	opts.flags |= CAN_ISOTP_FORCE_TXSTMIN;
+	setOptions( m_socket, opts);
+}
+
+void CANIsoTpSocket::setPadding( bool enable, uint8_t content /* = 0xcc */)
+{
+	can_isotp_options opts = getOptions(m_socket);
+	if( enable) opts.flags |= CAN_ISOTP_TX_PADDING;
+	else        opts.flags &= ~static_cast<uint32_t>(CAN_ISOTP_TX_PADDING);
+	opts.txpad_content = content;
+	setOptions( m_socket, opts);
+}
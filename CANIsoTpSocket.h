@@ -0,0 +1,82 @@
+#ifndef NET_CANIsoTpSocket_h__
+#define NET_CANIsoTpSocket_h__
+
+#include "CANSocket.h"
+#include "CANFrame.h"
+
+#include <cstdint>
+
+namespace NET
+{
+	//! CAN ISO-TP socket class
+	/*!
+	 * CANIsoTpSocket transfers PDUs of up to 4095 bytes according to
+	 * ISO 15765-2 (CAN_ISOTP). Segmentation into single, first and
+	 * consecutive frames as well as flow control are done by the kernel,
+	 * a whole PDU is passed with one call to send() or receive().
+	 *
+	 * A socket is bound to one pair of CAN ids, one for sending and one
+	 * for receiving. All options have to be set before bind().
+	 *
+	 * Usage example:
+	 * \code
+	 * CANIsoTpSocket socket;
+	 * socket.setFlowControl( 8, 0);
+	 * socket.bind( "can0", txId, rxId);
+	 * socket.send( request, requestLen);
+	 * int len = socket.timedReceive( response, 4095, 1000);
+	 * \endcode
+	 */
+	class CANIsoTpSocket : public CANSocket
+	{
+	public:
+		/*!
+		 * Construct an ISO-TP socket
+		 * \exception SocketException thrown if unable to create the socket
+		 */
+		CANIsoTpSocket();
+
+		/*!
+		 * Bind the socket to an interface and a pair of CAN ids.
+		 * \param interface specifies the CAN interface to bind to
+		 * \param txId id of the frames sent
+		 * \param rxId id of the frames received
+		 * \exception SocketException thrown if binding fails
+		 */
+		void bind( const std::string& interface, const can_id& txId, const can_id& rxId);
+
+		/*!
+		 * Set the flow control parameters announced to the sender of a
+		 * segmented PDU.
+		 *
+		 * The separation time is coded as defined by ISO 15765-2: values
+		 * up to 0x7f are milliseconds, 0xf1 to 0xf9 are 100 to 900
+		 * microseconds.
+		 *
+		 * \param blockSize number of consecutive frames between two flow control frames, 0 for no limit
+		 * \param separationTime minimum time between two consecutive frames
+		 * \param maxWaitFrames maximum number of wait frames, 0 to never send one
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setFlowControl( uint8_t blockSize, uint8_t separationTime, uint8_t maxWaitFrames = 0);
+
+		/*!
+		 * Send consecutive frames with the given separation time instead
+		 * of the one requested by the receiver.
+		 * \param nsec minimum time between two consecutive frames in nanoseconds
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setTransmitSeparationTime( uint32_t nsec);
+
+		/*!
+		 * Pad all sent frames to 8 bytes.
+		 * \param enable true to pad frames
+		 * \param content value of the padding bytes
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setPadding( bool enable, uint8_t content = 0xcc);
+	};
+
+} // namespace NET
+
+#endif // NET_CANIsoTpSocket_h__
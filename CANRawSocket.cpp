@@ -5,11 +5,63 @@
 #include <linux/can.h>
 #include <linux/can/raw.h>
 #include <poll.h>
+#include <ctime>
+#include <cstring>
+#include <vector>
 
 using namespace NET;
 
+namespace {
+
+// number of frames passed to one recvmmsg() or sendmmsg() call
+const unsigned BATCH_SIZE = 64;
+
+// CAN_RAW_FILTER_MAX of the kernel
+const size_t MAX_FILTERS = 512;
+
+// filter of one id, which the kernel looks up instead of checking it for every frame
+bool isExactFilter( const NET::can_filter& filter)
+{
+	uint32_t id = raw_id(filter.id);
+	uint32_t mask = raw_id(filter.mask);
+	uint32_t idBits = (id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK;
+	return !(id & CAN_INV_FILTER) && !(mask & CAN_ERR_FLAG) &&
+	       (mask & (CAN_EFF_FLAG | idBits)) == (CAN_EFF_FLAG | idBits);
+}
+
+// one filter passing at least all frames of the given masked filters,
+// it keeps the mask bits in which all filters agree
+::can_filter coveringFilter( const std::vector<NET::can_filter>& filters)
+{
+	uint32_t mask = CAN_EFF_FLAG | CAN_RTR_FLAG | CAN_EFF_MASK;
+	uint32_t anyBits = 0;
+	uint32_t allBits = ~0U;
+	for( size_t i = 0; i < filters.size(); ++i)
+	{
+		uint32_t id = raw_id(filters[i].id);
+		uint32_t filterMask = raw_id(filters[i].mask) & ~CAN_ERR_FLAG;
+
+		// an inverted filter passes almost everything
+		if( id & CAN_INV_FILTER)
+			return ::can_filter();
+
+		mask &= filterMask;
+		anyBits |= id & filterMask;
+		allBits &= id & filterMask;
+	}
+	mask &= ~(anyBits ^ allBits);
+
+	::can_filter cover;
+	cover.can_id = allBits & mask;
+	cover.can_mask = mask;
+	return cover;
+}
+
+} // namespace
+
 CANRawSocket::CANRawSocket()
 : CANSocket( RAW, CAN_RAW)
+, m_timestamps(false)
 {}
 
 void CANRawSocket::sendTo( const void* buffer, size_t len, const std::string& interface)
@@ -28,16 +80,56 @@ void CANRawSocket::sendTo( const void* buffer, size_t len, const std::string& in
 int CANRawSocket::receiveFrom( void* buffer, size_t len, std::string& interface)
 {
 	sockaddr_can clientAddr;
-	socklen_t addrLen = sizeof(clientAddr);
-
-	int ret = TEMP_FAILURE_RETRY (::recvfrom( m_socket, (raw_type*)buffer, len, 0, (sockaddr*)&clientAddr, &addrLen));
-	if( ret < 0)
-		throw SocketException("Receive failed (recvfrom)");
+	int ret = receiveFrame( buffer, len, clientAddr, 0);
 
 	interface = getInterfaceName(clientAddr);
 	return ret;
 }
 
+int CANRawSocket::receive( void* buffer, size_t len)
+{
+	sockaddr_can clientAddr;
+	return receiveFrame( buffer, len, clientAddr, 0);
+}
+
+int CANRawSocket::timedReceive( void* buffer, size_t len, int timeout)
+{
+	if( !waitForFrames(timeout)) return 0;
+
+	// do not block if the user space filter dropped the frame
+	sockaddr_can clientAddr;
+	return receiveFrame( buffer, len, clientAddr, MSG_DONTWAIT);
+}
+
+int CANRawSocket::receiveFrame( void* buffer, size_t len, sockaddr_can& addr, int flags)
+{
+	int ret;
+	do
+	{
+		socklen_t addrLen = sizeof(addr);
+		ret = TEMP_FAILURE_RETRY (::recvfrom( m_socket, (raw_type*)buffer, len, flags, (sockaddr*)&addr, &addrLen));
+		if( ret < 0)
+		{
+			if( flags & MSG_DONTWAIT && errno == EAGAIN)
+				return 0;
+			throw SocketException("Receive failed (recvfrom)");
+		}
+	}
+	while( !passesFilter( buffer, static_cast<size_t>(ret)));
+
+	return ret;
+}
+
+bool CANRawSocket::passesFilter( const void* frame, size_t len) const
+{
+	if( m_filterTable.empty() || len < sizeof(can_id))
+		return true;
+
+	can_id id;
+	std::memcpy( &id, frame, sizeof(id));
+	return m_filterTable.matches(id);
+}
+
 int CANRawSocket::timedReceiveFrom( void* buffer, size_t len, std::string& interface, int timeout)
 {
 	struct pollfd poll;
@@ -53,29 +145,276 @@ int CANRawSocket::timedReceiveFrom( void* buffer, size_t len, std::string& inter
 		m_peerDisconnected = true;
 
 	if( poll.revents & POLLIN || poll.revents & POLLPRI)
-		return receiveFrom( buffer, len, interface);
+	{
+		// do not block if the user space filter dropped the frame
+		sockaddr_can clientAddr;
+		ret = receiveFrame( buffer, len, clientAddr, MSG_DONTWAIT);
+		if( ret > 0)
+			interface = getInterfaceName(clientAddr);
+		return ret;
+	}
 
 	return 0;
 }
 
+unsigned CANRawSocket::readFrames( can_frame* frames, FrameInfo* info, unsigned count)
+{
+	return readFrames( reinterpret_cast<uint8_t*>(frames), sizeof(can_frame), info, count, true);
+}
+
+unsigned CANRawSocket::readFrames( canfd_frame* frames, FrameInfo* info, unsigned count)
+{
+	return readFrames( reinterpret_cast<uint8_t*>(frames), sizeof(canfd_frame), info, count, true);
+}
+
+unsigned CANRawSocket::timedReadFrames( can_frame* frames, FrameInfo* info, unsigned count, int timeout)
+{
+	if( !waitForFrames(timeout)) return 0;
+	return readFrames( reinterpret_cast<uint8_t*>(frames), sizeof(can_frame), info, count, false);
+}
+
+unsigned CANRawSocket::timedReadFrames( canfd_frame* frames, FrameInfo* info, unsigned count, int timeout)
+{
+	if( !waitForFrames(timeout)) return 0;
+	return readFrames( reinterpret_cast<uint8_t*>(frames), sizeof(canfd_frame), info, count, false);
+}
+
+unsigned CANRawSocket::writeFrames( const can_frame* frames, const FrameInfo* info, unsigned count)
+{
+	return writeFrames( reinterpret_cast<const uint8_t*>(frames), sizeof(can_frame), info, count);
+}
+
+unsigned CANRawSocket::writeFrames( const canfd_frame* frames, const FrameInfo* info, unsigned count)
+{
+	return writeFrames( reinterpret_cast<const uint8_t*>(frames), sizeof(canfd_frame), info, count);
+}
+
+bool CANRawSocket::waitForFrames( int timeout)
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN | POLLPRI | POLLRDHUP;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return false;
+	if( ret < 0)  throw SocketException("Receive failed (poll)");
+
+	if( poll.revents & POLLRDHUP)
+		m_peerDisconnected = true;
+
+	return poll.revents & POLLIN || poll.revents & POLLPRI;
+}
+
+unsigned CANRawSocket::readFrames( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count, bool wait)
+{
+	unsigned ret = 0;
+	for(;;)
+	{
+		// wait for the first frame only, then take what is queued
+		int flags = (wait && ret == 0) ? MSG_WAITFORONE : MSG_DONTWAIT;
+		unsigned received = readBatch( frames + ret * frameSize, frameSize, info ? info + ret : nullptr, count - ret, flags);
+		ret += filterFrames( frames + ret * frameSize, frameSize, info ? info + ret : nullptr, received);
+
+		if( ret == count) break;
+		if( received == BATCH_SIZE) continue;
+		if( !wait || ret > 0) break;
+	}
+
+	return ret;
+}
+
+unsigned CANRawSocket::filterFrames( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count) const
+{
+	if( m_filterTable.empty()) return count;
+
+	unsigned kept = 0;
+	for( unsigned i = 0; i < count; ++i)
+	{
+		if( !passesFilter( frames + i * frameSize, frameSize))
+			continue;
+
+		if( kept != i)
+		{
+			std::memcpy( frames + kept * frameSize, frames + i * frameSize, frameSize);
+			if( info) info[kept] = info[i];
+		}
+		++kept;
+	}
+
+	return kept;
+}
+
+unsigned CANRawSocket::readBatch( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count, int flags)
+{
+	if( info && !m_timestamps)
+	{
+		int enable = 1;
+		if( setsockopt( m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) < 0)
+			throw SocketException("Enable timestamps failed (setsockopt)");
+		m_timestamps = true;
+	}
+
+	if( count > BATCH_SIZE) count = BATCH_SIZE;
+
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iovs[BATCH_SIZE];
+	sockaddr_can addrs[BATCH_SIZE];
+	char control[BATCH_SIZE][CMSG_SPACE(sizeof(timespec))];
+
+	std::memset( msgs, 0, sizeof(mmsghdr) * count);
+	for( unsigned i = 0; i < count; ++i)
+	{
+		iovs[i].iov_base = frames + i * frameSize;
+		iovs[i].iov_len = frameSize;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_can);
+		if( info)
+		{
+			msgs[i].msg_hdr.msg_control = control[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+		}
+	}
+
+	int ret = TEMP_FAILURE_RETRY (::recvmmsg( m_socket, msgs, count, flags, nullptr));
+	if( ret < 0)
+	{
+		if( flags & MSG_DONTWAIT && errno == EAGAIN)
+			return 0;
+		throw SocketException("Receive failed (recvmmsg)");
+	}
+
+	unsigned kept = 0;
+	for( unsigned i = 0; i < static_cast<unsigned>(ret); ++i)
+	{
+		// a CAN FD frame does not fit into a can_frame after setFDFrames(true)
+		if( msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+			continue;
+
+		if( kept != i)
+			std::memcpy( frames + kept * frameSize, frames + i * frameSize, frameSize);
+
+		if( info)
+		{
+			// the kind of a frame is given by its size
+			info[kept].ifindex = addrs[i].can_ifindex;
+			info[kept].fd = msgs[i].msg_len == CANFD_FRAME_SIZE;
+			info[kept].sec = 0;
+			info[kept].nsec = 0;
+
+			msghdr& msg = msgs[i].msg_hdr;
+			for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+			{
+				if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_TIMESTAMPNS)
+				{
+					timespec stamp;
+					std::memcpy( &stamp, CMSG_DATA(cmsg), sizeof(stamp));
+					info[kept].sec = stamp.tv_sec;
+					info[kept].nsec = static_cast<uint32_t>(stamp.tv_nsec);
+				}
+			}
+		}
+		++kept;
+	}
+
+	return kept;
+}
+
+unsigned CANRawSocket::writeFrames( const uint8_t* frames, size_t frameSize, const FrameInfo* info, unsigned count)
+{
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iovs[BATCH_SIZE];
+	sockaddr_can addrs[BATCH_SIZE];
+
+	unsigned sent = 0;
+	while( sent < count)
+	{
+		unsigned batch = count - sent < BATCH_SIZE ? count - sent : BATCH_SIZE;
+
+		std::memset( msgs, 0, sizeof(mmsghdr) * batch);
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			iovs[i].iov_base = const_cast<uint8_t*>( frames + (sent + i) * frameSize);
+			iovs[i].iov_len = frameSize;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			if( info)
+			{
+				// the kernel tells the kind of a frame by its size
+				if( frameSize == CANFD_FRAME_SIZE && !info[sent + i].fd)
+					iovs[i].iov_len = CAN_FRAME_SIZE;
+
+				std::memset( &addrs[i], 0, sizeof(sockaddr_can));
+				addrs[i].can_family = AF_CAN;
+				addrs[i].can_ifindex = info[sent + i].ifindex;
+				msgs[i].msg_hdr.msg_name = &addrs[i];
+				msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_can);
+			}
+		}
+
+		int ret = TEMP_FAILURE_RETRY (::sendmmsg( m_socket, msgs, batch, 0));
+		if( ret < 0)
+		{
+			// report the frames already sent, the error repeats with the next call
+			if( sent > 0) break;
+			throw SocketException("Send failed (sendmmsg)");
+		}
+
+		sent += static_cast<unsigned>(ret);
+		if( static_cast<unsigned>(ret) < batch) break;
+	}
+
+	return sent;
+}
+
 void CANRawSocket::setReceiveFilter( const can_filter* filter, size_t len)
 {
+	std::vector< ::can_filter> kernel;
+	std::vector<can_filter> masked;
+	for( size_t i = 0; i < len; ++i)
+	{
+		if( isExactFilter( filter[i]))
+			kernel.push_back( reinterpret_cast<const ::can_filter&>(filter[i]));
+		else
+			masked.push_back( filter[i]);
+	}
+
+	// the kernel keeps the exact ids, too many masked filters are narrowed
+	// down by one covering filter there and checked in user space
+	bool userSpace = masked.size() > MAX_KERNEL_FILTERS;
+	if( userSpace)
+		kernel.push_back( coveringFilter( masked));
+	else
+		kernel.insert( kernel.end(), reinterpret_cast<const ::can_filter*>(masked.data()),
+		               reinterpret_cast<const ::can_filter*>(masked.data() + masked.size()));
+
+	if( kernel.size() > MAX_FILTERS)
+	{
+		kernel.assign( 1, ::can_filter());
+		userSpace = true;
+	}
+
 	if( setsockopt( m_socket,
 	                SOL_CAN_RAW,
 	                CAN_RAW_FILTER,
-	                (const raw_type*)filter,
-	                sizeof(filter) * len) < 0)
+	                (const raw_type*)kernel.data(),
+	                static_cast<socklen_t>(sizeof(::can_filter) * kernel.size())) < 0)
 		throw SocketException("Set receive filter failed (setsockopt)");
+
+	m_filterTable.assign( filter, userSpace ? len : 0);
 }
 
-void CANRawSocket::setErrorFilter( const can_filter* filter, size_t len)
+void CANRawSocket::setErrorFilter( uint32_t mask)
 {
+	can_err_mask_t errMask = mask;
 	if( setsockopt( m_socket,
 	                SOL_CAN_RAW,
 	                CAN_RAW_ERR_FILTER,
-	                (const raw_type*)filter,
-	                sizeof(filter) * len) < 0)
-		throw SocketException("Set receive filter failed (setsockopt)");
+	                (const raw_type*)&errMask,
+	                sizeof(errMask)) < 0)
+		throw SocketException("Set error filter failed (setsockopt)");
 }
 
 void CANRawSocket::setLocalLoopback( bool enable)
@@ -99,3 +438,14 @@ void CANRawSocket::setReceiveOwnMessages( bool enable)
 	                sizeof(recv_own_msgs)) < 0)
 		throw SocketException("Set receive own messages failed (setsockopt)");
 }
+
+void CANRawSocket::setFDFrames( bool enable)
+{
+	int fd_frames = enable;
+	if( setsockopt( m_socket,
+	                SOL_CAN_RAW,
+	                CAN_RAW_FD_FRAMES,
+	                (raw_type*)&fd_frames,
+	                sizeof(fd_frames)) < 0)
+		throw SocketException("Set CAN FD frames failed (setsockopt)");
+}
@@ -3,13 +3,35 @@
 
 #include "CANSocket.h"
 #include "CANFrame.h"
+#include "CANFilterTable.h"
+
+#include <cstdint>
 
 namespace NET
 {
 	//! Raw CAN socket class
+	/*!
+	 * Note: receive filters beyond the capacity of the kernel are checked
+	 * in user space, see setReceiveFilter(). Only the receive functions of
+	 * CANRawSocket apply them. The functions of the base classes are not
+	 * virtual, so receiving through a SimpleSocket reference or pointer
+	 * may return frames that do not pass the filters.
+	 */
 	class CANRawSocket : public CANSocket
 	{
 	public:
+		//! Interface and reception time of a frame transferred by readFrames() or writeFrames()
+		struct FrameInfo
+		{
+			int ifindex;   ///< interface index, see if_nametoindex() and if_indextoname()
+			bool fd;       ///< true for a CAN FD frame, false for a classic frame
+			int64_t sec;   ///< receive timestamp, seconds
+			uint32_t nsec; ///< receive timestamp, nanoseconds
+		};
+
+		//! number of masked receive filters up to which the kernel does the filtering
+		static const size_t MAX_KERNEL_FILTERS = 32;
+
 		/*!
 		 * Construct a raw CAN socket
 		 * \exception SocketException thrown if unable to create the socket
@@ -47,6 +69,31 @@ namespace NET
 		 */
 		int receiveFrom( void* buffer, size_t len, std::string& interface);
 
+		/*!
+		 * Read one CAN frame from this socket, applying the user space
+		 * filters of setReceiveFilter(). Hides SimpleSocket::receive(),
+		 * which does not know about these filters.
+		 *
+		 * \param buffer pointer to CAN frame structure
+		 * \param len size of the can frame structure
+		 * \return number of bytes received
+		 * \exception SocketException thrown if unable to receive datagram
+		 */
+		int receive( void* buffer, size_t len);
+
+		/*!
+		 * Read one CAN frame like receive(). If no frame passing the
+		 * filters is received before the timeout runs out, 0 is returned.
+		 * Hides SimpleSocket::timedReceive().
+		 *
+		 * \param buffer pointer to CAN frame structure
+		 * \param len size of the can frame structure
+		 * \param timeout timeout in milliseconds
+		 * \return number of bytes received, 0 on timeout
+		 * \exception SocketException thrown if unable to receive datagram
+		 */
+		int timedReceive( void* buffer, size_t len, int timeout);
+
 		/*!
 		 * Read one CAN frame from this socket. If no interface has received a
 		 * frame before the timeout runs out, the function will return
@@ -65,20 +112,124 @@ namespace NET
 		int timedReceiveFrom( void* buffer, size_t len, std::string& interface, int timeout);
 
 		/*!
-		 * 
-		 * \param filters
+		 * Read a batch of CAN frames with a single system call. Blocks
+		 * until at least one frame is available and returns all frames
+		 * that are queued, up to count.
+		 *
+		 * Unlike receiveFrom(), the receiving interface is reported as an
+		 * index, so no lookup of the interface name is needed per frame.
+		 * The first call enables the timestamps of the kernel.
+		 *
+		 * After setFDFrames(true) CAN FD frames do not fit into a can_frame,
+		 * they are skipped and only the classic frames are returned.
+		 *
+		 * \param frames array to store the frames
+		 * \param info array to store interface and timestamp of each frame, may be nullptr
+		 * \param count size of the arrays
+		 * \return number of frames read
+		 * \exception SocketException thrown if unable to receive frames
+		 */
+		unsigned readFrames( can_frame* frames, FrameInfo* info, unsigned count);
+
+		/*!
+		 * Read a batch of classic and CAN FD frames like readFrames().
+		 * Classic frames keep their layout, FrameInfo::fd tells both kinds
+		 * apart. CAN FD frames are only received after setFDFrames().
+		 *
+		 * \param frames array to store the frames
+		 * \param info array to store kind, interface and timestamp of each frame, may be nullptr
+		 * \param count size of the arrays
+		 * \return number of frames read
+		 * \exception SocketException thrown if unable to receive frames
+		 */
+		unsigned readFrames( canfd_frame* frames, FrameInfo* info, unsigned count);
+
+		/*!
+		 * Read a batch of CAN frames like readFrames(). If no frame is
+		 * received before the timeout runs out, 0 is returned.
+		 *
+		 * \param frames array to store the frames
+		 * \param info array to store interface and timestamp of each frame, may be nullptr
+		 * \param count size of the arrays
+		 * \param timeout timeout in milliseconds
+		 * \return number of frames read, 0 on timeout
+		 * \exception SocketException thrown if unable to receive frames
+		 */
+		unsigned timedReadFrames( can_frame* frames, FrameInfo* info, unsigned count, int timeout);
+
+		/*!
+		 * Read a batch of classic and CAN FD frames like timedReadFrames().
+		 *
+		 * \param frames array to store the frames
+		 * \param info array to store kind, interface and timestamp of each frame, may be nullptr
+		 * \param count size of the arrays
+		 * \param timeout timeout in milliseconds
+		 * \return number of frames read, 0 on timeout
+		 * \exception SocketException thrown if unable to receive frames
+		 */
+		unsigned timedReadFrames( canfd_frame* frames, FrameInfo* info, unsigned count, int timeout);
+
+		/*!
+		 * Send a batch of CAN frames with a single system call per 64
+		 * frames. Each frame is sent on the interface given by its info,
+		 * the timestamps are ignored. Without info, all frames are sent on
+		 * the interface the socket is connected to.
+		 *
+		 * \param frames frames to send
+		 * \param info interface of each frame, may be nullptr
+		 * \param count number of frames
+		 * \return number of frames sent, less than count if the device queue ran full
+		 * \exception SocketException thrown if unable to send the first frame
+		 */
+		unsigned writeFrames( const can_frame* frames, const FrameInfo* info, unsigned count);
+
+		/*!
+		 * Send a batch of classic and CAN FD frames like writeFrames().
+		 * A frame is sent as classic frame if its info has fd cleared,
+		 * without info all frames are sent as CAN FD frames. Sending CAN
+		 * FD frames needs setFDFrames() and an interface with an MTU of
+		 * 72 bytes.
+		 *
+		 * \param frames frames to send
+		 * \param info kind and interface of each frame, may be nullptr
+		 * \param count number of frames
+		 * \return number of frames sent, less than count if the device queue ran full
+		 * \exception SocketException thrown if unable to send the first frame
+		 */
+		unsigned writeFrames( const canfd_frame* frames, const FrameInfo* info, unsigned count);
+
+		/*!
+		 * Receive only frames passing any of the given filters, no
+		 * frames at all if len is 0.
+		 *
+		 * Filters of exact ids are always handed to the kernel, which looks
+		 * them up. The other filters are checked one by one for every frame,
+		 * so only up to MAX_KERNEL_FILTERS of them are handed to the kernel.
+		 * A larger set is replaced in the kernel by one filter passing all
+		 * their frames, and the exact check is done in user space by a
+		 * CANFilterTable. In that case the timed receive functions may
+		 * return 0 before the timeout if all frames were dropped by the
+		 * filters.
+		 *
+		 * The user space check is only applied by the receive functions of
+		 * CANRawSocket, not by SimpleSocket::receive() and
+		 * SimpleSocket::timedReceive() called through a base class.
+		 *
+		 * \param filters filters to set
 		 * \param len number of filters to set
-		 * \exception SocketException
+		 * \exception SocketException thrown if unable to set the filters
 		 */
 		void setReceiveFilter( const can_filter* filters, size_t len);
 
 		/*!
-		 * 
-		 * \param filters
-		 * \param len number of filters to set
-		 * \exception SocketException
+		 * Receive error frames of the given classes. The mask is a
+		 * combination of the CAN_ERR_* bits of <linux/can/error.h>,
+		 * 0 disables error frames.
+		 *
+		 * \param mask error classes to receive
+		 * \exception SocketException thrown if unable to set the mask
 		 */
-		void setErrorFilter( const can_filter* filters, size_t len);
+		void setErrorFilter( uint32_t mask);
 
 		/*!
 		 * 
@@ -93,6 +244,29 @@ namespace NET
 		 * \exception SocketException
 		 */
 		void setReceiveOwnMessages( bool enable);
+
+		/*!
+		 * Enable the exchange of CAN FD frames. Afterwards the socket
+		 * receives classic frames of CAN_FRAME_SIZE bytes as well as CAN FD
+		 * frames of CANFD_FRAME_SIZE bytes, so receive buffers must be
+		 * large enough for a canfd_frame.
+		 *
+		 * \param enable true to exchange CAN FD frames
+		 * \exception SocketException thrown if the kernel does not support CAN FD
+		 */
+		void setFDFrames( bool enable);
+
+	private:
+		int receiveFrame( void* buffer, size_t len, sockaddr_can& addr, int flags);
+		bool passesFilter( const void* frame, size_t len) const;
+		unsigned readFrames( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count, bool wait);
+		unsigned filterFrames( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count) const;
+		unsigned readBatch( uint8_t* frames, size_t frameSize, FrameInfo* info, unsigned count, int flags);
+		unsigned writeFrames( const uint8_t* frames, size_t frameSize, const FrameInfo* info, unsigned count);
+		bool waitForFrames( int timeout);
+
+		bool m_timestamps;
+		CANFilterTable m_filterTable;
 	};
 
 } // namespace NET
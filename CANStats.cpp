@@ -0,0 +1,270 @@
+#include "CANStats.h"
+
+using namespace NET;
+
+namespace {
+
+const uint64_t EMPTY_KEY = ~uint64_t(0);
+
+// weight of a new period within the moving average
+const uint64_t AVERAGE_WEIGHT = 16;
+
+// worst case length including stuff bits and interframe space
+// (Davis et al., Controller Area Network schedulability analysis)
+uint64_t frameBits( const can_frame& frame)
+{
+	uint64_t dataBits = frame.id.rtr_flag ? 0 : 8u * (frame.dlc > 8 ? 8u : frame.dlc);
+	uint64_t headerBits = frame.id.ext_format ? 54 : 34;
+	return headerBits + dataBits + 13 + (headerBits + dataBits - 1) / 4;
+}
+
+unsigned jitterBucket( uint64_t deviation)
+{
+	uint64_t usec = deviation / 1000;
+	unsigned bucket = 0;
+	while( usec)
+	{
+		++bucket;
+		usec >>= 1;
+	}
+	return bucket < CANStats::JITTER_BUCKETS ? bucket : CANStats::JITTER_BUCKETS - 1;
+}
+
+uint64_t load( const std::atomic<uint64_t>& value)
+{
+	return value.load(std::memory_order_relaxed);
+}
+
+void store( std::atomic<uint64_t>& value, uint64_t newValue)
+{
+	// there is only one writer
+	value.store( newValue, std::memory_order_relaxed);
+}
+
+} // namespace
+
+struct CANStats::IdSlot
+{
+	std::atomic<uint64_t> key;
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> first;
+	std::atomic<uint64_t> last;
+	std::atomic<uint64_t> meanPeriod;
+	std::atomic<uint64_t> minPeriod;
+	std::atomic<uint64_t> maxPeriod;
+	std::atomic<uint32_t> jitter[JITTER_BUCKETS];
+};
+
+struct CANStats::InterfaceSlot
+{
+	std::atomic<int> ifindex;
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> bits;
+	std::atomic<uint64_t> first;
+	std::atomic<uint64_t> last;
+};
+
+double CANStats::IdStatistics::rate() const
+{
+	if( frames < 2 || last <= first) return 0.0;
+	return static_cast<double>(frames - 1) * 1e9 / static_cast<double>(last - first);
+}
+
+double CANStats::InterfaceStatistics::load() const
+{
+	if( bitrate == 0 || last <= first) return 0.0;
+	return static_cast<double>(bits) * 1e9 / (static_cast<double>(bitrate) * static_cast<double>(last - first));
+}
+
+CANStats::CANStats( unsigned bitrate, unsigned maxIds /* = 4096 */)
+: m_bitrate(bitrate)
+, m_slotCount(1)
+{
+	while( m_slotCount < maxIds)
+		m_slotCount <<= 1;
+
+	m_slots.reset( new IdSlot[m_slotCount]);
+	m_interfaces.reset( new InterfaceSlot[MAX_INTERFACES]);
+	reset();
+}
+
+CANStats::~CANStats()
+{}
+
+void CANStats::record( const can_frame* frames, const CANRawSocket::FrameInfo* info, unsigned count)
+{
+	for( unsigned i = 0; i < count; ++i)
+	{
+		if( info[i].sec == 0 && info[i].nsec == 0) continue;
+		uint64_t now = static_cast<uint64_t>(info[i].sec) * 1000000000 + info[i].nsec;
+
+		InterfaceSlot* interface = findInterface( info[i].ifindex);
+		if( interface)
+		{
+			if( load(interface->frames) == 0)
+				store( interface->first, now);
+			store( interface->last, now);
+			store( interface->bits, load(interface->bits) + frameBits(frames[i]));
+			store( interface->frames, load(interface->frames) + 1);
+		}
+
+		uint64_t key = static_cast<uint64_t>( static_cast<uint32_t>(info[i].ifindex)) << 32 | raw_id(frames[i].id);
+		IdSlot* slot = findSlot(key);
+		if( !slot)
+		{
+			store( m_untracked, load(m_untracked) + 1);
+			continue;
+		}
+
+		uint64_t received = load(slot->frames);
+		if( received == 0)
+		{
+			store( slot->first, now);
+		}
+		else
+		{
+			uint64_t last = load(slot->last);
+			uint64_t period = now > last ? now - last : 0;
+
+			if( received == 1)
+			{
+				store( slot->meanPeriod, period);
+				store( slot->minPeriod, period);
+				store( slot->maxPeriod, period);
+			}
+			else
+			{
+				uint64_t mean = load(slot->meanPeriod);
+				uint64_t deviation = period > mean ? period - mean : mean - period;
+				std::atomic<uint32_t>& bucket = slot->jitter[jitterBucket(deviation)];
+				bucket.store( bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+				if( period > mean) store( slot->meanPeriod, mean + deviation / AVERAGE_WEIGHT);
+				else               store( slot->meanPeriod, mean - deviation / AVERAGE_WEIGHT);
+				if( period < load(slot->minPeriod)) store( slot->minPeriod, period);
+				if( period > load(slot->maxPeriod)) store( slot->maxPeriod, period);
+			}
+		}
+
+		store( slot->last, now);
+		store( slot->frames, received + 1);
+	}
+}
+
+CANStats::IdSlot* CANStats::findSlot( uint64_t key)
+{
+	size_t mask = m_slotCount - 1;
+	size_t index = static_cast<size_t>( (key * 0x9e3779b97f4a7c15ULL) >> 32) & mask;
+
+	for( size_t probe = 0; probe < m_slotCount; ++probe)
+	{
+		IdSlot& slot = m_slots[(index + probe) & mask];
+		uint64_t slotKey = slot.key.load(std::memory_order_relaxed);
+
+		if( slotKey == key)
+			return &slot;
+
+		if( slotKey == EMPTY_KEY)
+		{
+			// the counters are zero, readers see the slot once the key is set
+			slot.key.store( key, std::memory_order_release);
+			return &slot;
+		}
+	}
+
+	return nullptr;
+}
+
+CANStats::InterfaceSlot* CANStats::findInterface( int ifindex)
+{
+	for( unsigned i = 0; i < MAX_INTERFACES; ++i)
+	{
+		InterfaceSlot& slot = m_interfaces[i];
+		int slotIndex = slot.ifindex.load(std::memory_order_relaxed);
+
+		if( slotIndex == ifindex)
+			return &slot;
+
+		if( slotIndex == 0)
+		{
+			slot.ifindex.store( ifindex, std::memory_order_release);
+			return &slot;
+		}
+	}
+
+	return nullptr;
+}
+
+CANStats::Snapshot CANStats::snapshot() const
+{
+	Snapshot ret;
+	ret.untracked = load(m_untracked);
+
+	for( unsigned i = 0; i < MAX_INTERFACES; ++i)
+	{
+		const InterfaceSlot& slot = m_interfaces[i];
+		int ifindex = slot.ifindex.load(std::memory_order_acquire);
+		if( ifindex == 0) break;
+
+		InterfaceStatistics stats;
+		stats.ifindex = ifindex;
+		stats.frames = load(slot.frames);
+		stats.bits = load(slot.bits);
+		stats.first = load(slot.first);
+		stats.last = load(slot.last);
+		stats.bitrate = m_bitrate;
+		ret.interfaces.push_back(stats);
+	}
+
+	for( size_t i = 0; i < m_slotCount; ++i)
+	{
+		const IdSlot& slot = m_slots[i];
+		uint64_t key = slot.key.load(std::memory_order_acquire);
+		if( key == EMPTY_KEY) continue;
+
+		IdStatistics stats;
+		stats.ifindex = static_cast<int>(key >> 32);
+		uint32_t id = static_cast<uint32_t>(key);
+		stats.id = can_id{ id & CAN_EXTENDED_MASK, (id >> 29) & 1, (id >> 30) & 1, id >> 31 };
+		stats.frames = load(slot.frames);
+		stats.first = load(slot.first);
+		stats.last = load(slot.last);
+		stats.meanPeriod = load(slot.meanPeriod);
+		stats.minPeriod = load(slot.minPeriod);
+		stats.maxPeriod = load(slot.maxPeriod);
+		for( unsigned b = 0; b < JITTER_BUCKETS; ++b)
+			stats.jitter[b] = slot.jitter[b].load(std::memory_order_relaxed);
+		ret.ids.push_back(stats);
+	}
+
+	return ret;
+}
+
+void CANStats::reset()
+{
+	for( size_t i = 0; i < m_slotCount; ++i)
+	{
+		IdSlot& slot = m_slots[i];
+		store( slot.frames, 0);
+		store( slot.first, 0);
+		store( slot.last, 0);
+		store( slot.meanPeriod, 0);
+		store( slot.minPeriod, 0);
+		store( slot.maxPeriod, 0);
+		for( unsigned b = 0; b < JITTER_BUCKETS; ++b)
+			slot.jitter[b].store( 0, std::memory_order_relaxed);
+		slot.key.store( EMPTY_KEY, std::memory_order_release);
+	}
+
+	for( unsigned i = 0; i < MAX_INTERFACES; ++i)
+	{
+		InterfaceSlot& slot = m_interfaces[i];
+		store( slot.frames, 0);
+		store( slot.bits, 0);
+		store( slot.first, 0);
+		store( slot.last, 0);
+		slot.ifindex.store( 0, std::memory_order_release);
+	}
+
+	store( m_untracked, 0);
+}
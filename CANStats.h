@@ -0,0 +1,143 @@
+#ifndef NET_CANStats_h__
+#define NET_CANStats_h__
+
+#include "CANRawSocket.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace NET
+{
+	//! Collects bus load, frame rates and period jitter of received CAN frames
+	/*!
+	 * CANStats is fed with the frames and kernel timestamps returned by
+	 * CANRawSocket::readFrames(). It keeps one slot per CAN id and
+	 * interface and one per interface. Slots are updated without locks,
+	 * so snapshot() can be called from any thread while frames are
+	 * recorded. Recording must only be done by one thread at a time.
+	 *
+	 * The bus load is estimated from the number of bits of the frames,
+	 * including the worst case of stuff bits, so it is an upper bound.
+	 *
+	 * Usage example:
+	 * \code
+	 * CANRawSocket socket;
+	 * socket.bind("can0");
+	 * CANStats stats(500000);
+	 * while( running)
+	 * {
+	 *   unsigned count = socket.readFrames( frames, info, 64);
+	 *   stats.record( frames, info, count);
+	 * }
+	 * \endcode
+	 */
+	class CANStats
+	{
+	public:
+		//! number of buckets of the jitter histogram
+		static const unsigned JITTER_BUCKETS = 16;
+
+		//! number of interfaces that can be tracked
+		static const unsigned MAX_INTERFACES = 16;
+
+		//! Statistics of one CAN id on one interface
+		struct IdStatistics
+		{
+			int ifindex;       ///< interface the frames were received on
+			can_id id;         ///< id of the frames, including the format and remote flags
+			uint64_t frames;   ///< number of received frames
+			uint64_t first;    ///< timestamp of the first frame in nanoseconds
+			uint64_t last;     ///< timestamp of the last frame in nanoseconds
+			uint64_t meanPeriod; ///< moving average of the time between two frames in nanoseconds
+			uint64_t minPeriod;  ///< shortest time between two frames in nanoseconds
+			uint64_t maxPeriod;  ///< longest time between two frames in nanoseconds
+
+			//! deviations of the period from its average
+			/*!
+			 * Bucket 0 counts deviations below 1 microsecond, bucket n
+			 * deviations from 2^(n-1) up to 2^n microseconds. The last
+			 * bucket counts all larger deviations.
+			 */
+			uint32_t jitter[JITTER_BUCKETS];
+
+			//! frames per second between the first and the last frame
+			double rate() const;
+		};
+
+		//! Statistics of one interface
+		struct InterfaceStatistics
+		{
+			int ifindex;     ///< index of the interface
+			uint64_t frames; ///< number of received frames
+			uint64_t bits;   ///< estimated number of bits on the bus
+			uint64_t first;  ///< timestamp of the first frame in nanoseconds
+			uint64_t last;   ///< timestamp of the last frame in nanoseconds
+			unsigned bitrate; ///< bit rate of the bus
+
+			//! estimated share of the time the bus was busy, between 0 and 1
+			double load() const;
+		};
+
+		//! A snapshot of all counters
+		/*!
+		 * Every value is read atomically, but the values of a slot may
+		 * stem from different frames if frames are recorded concurrently.
+		 */
+		struct Snapshot
+		{
+			std::vector<InterfaceStatistics> interfaces;
+			std::vector<IdStatistics> ids;
+			uint64_t untracked; ///< frames of ids that did not fit into the table
+		};
+
+		/*!
+		 * Create a collector.
+		 * \param bitrate nominal bit rate of the buses in bits per second
+		 * \param maxIds maximum number of tracked ids, rounded up to a power of two
+		 */
+		explicit CANStats( unsigned bitrate, unsigned maxIds = 4096);
+
+		~CANStats();
+
+		/*!
+		 * Update the statistics with received frames. Frames without
+		 * timestamp are ignored.
+		 *
+		 * \param frames received frames
+		 * \param info interface and timestamp of each frame
+		 * \param count number of frames
+		 */
+		void record( const can_frame* frames, const CANRawSocket::FrameInfo* info, unsigned count);
+
+		//! return the current statistics
+		Snapshot snapshot() const;
+
+		//! forget all frames
+		/*!
+		 * Must not be called while another thread records frames.
+		 */
+		void reset();
+
+	private:
+		struct IdSlot;
+		struct InterfaceSlot;
+
+		IdSlot* findSlot( uint64_t key);
+		InterfaceSlot* findInterface( int ifindex);
+
+		// dont' allow
+		CANStats( const CANStats&);
+		const CANStats& operator=( const CANStats&);
+
+		unsigned m_bitrate;
+		size_t m_slotCount;
+		std::unique_ptr<IdSlot[]> m_slots;
+		std::unique_ptr<InterfaceSlot[]> m_interfaces;
+		std::atomic<uint64_t> m_untracked;
+	};
+
+} // namespace NET
+
+#endif // NET_CANStats_h__
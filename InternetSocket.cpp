@@ -91,6 +91,17 @@ unsigned short InternetSocket::getForeignPort() const
 	return ntohs( addr.sin_port);
 }
 
+void InternetSocket::setReusePort( bool enable)
+{
+	int reuse = enable;
+	if( setsockopt( m_socket,
+	                SOL_SOCKET,
+	                SO_REUSEPORT,
+	                (raw_type*)&reuse,
+	                sizeof(reuse)) < 0)
+		throw SocketException("Set reuse port failed (setsockopt)");
+}
+
 void InternetSocket::fillAddress( const std::string& address, unsigned short port, sockaddr_in& addr)
 {
 	addr.sin_family = AF_INET;
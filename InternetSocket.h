@@ -90,6 +90,18 @@ namespace NET
 		 */
 		unsigned short getForeignPort() const;
 
+		//! allow several sockets to bind to the same address / port
+		/*!
+		 * Has to be called before bind(). All sockets bound to the same
+		 * address / port must enable this option. Incoming connections or
+		 * datagrams are then distributed between those sockets by the
+		 * operating system.
+		 *
+		 * \param enable true to allow sharing of the local port
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setReusePort( bool enable);
+
 	protected:
 		//! create socket from a SocketHandle returned by an accept() call
 		explicit InternetSocket( int sockfd);
@@ -0,0 +1,294 @@
+#include "LossMonitor.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <linux/sock_diag.h>
+#include <poll.h>
+#include <cstring>
+#include <algorithm>
+
+using namespace NET;
+
+namespace {
+
+// number of sequence numbers behind the highest one that are remembered
+const uint64_t WINDOW_SIZE = 64;
+
+uint32_t readKernelDrops( int socket)
+{
+	uint32_t meminfo[SK_MEMINFO_VARS];
+	socklen_t size = sizeof(meminfo);
+
+	if( getsockopt( socket, SOL_SOCKET, SO_MEMINFO, meminfo, &size) < 0)
+		throw SocketException("Fetch of drop counter failed (getsockopt)");
+
+	return meminfo[SK_MEMINFO_DROPS];
+}
+
+// bits 1 to count set, bit 0 is the current highest sequence number
+uint64_t gapBits( uint64_t count)
+{
+	if( count >= WINDOW_SIZE - 1) return ~uint64_t(1);
+	return ((uint64_t(1) << count) - 1) << 1;
+}
+
+// length of the longest run of set bits
+uint64_t longestRun( uint64_t bits)
+{
+	uint64_t length = 0;
+	for( ; bits; ++length)
+		bits &= bits << 1;
+	return length;
+}
+
+// the runs of set bits that reach into the given region
+uint64_t runsReaching( uint64_t bits, uint64_t region)
+{
+	uint64_t runs = bits & region;
+	for( uint64_t last = 0; runs != last; )
+	{
+		last = runs;
+		runs |= (runs >> 1) & bits;
+	}
+	return runs;
+}
+
+void updateMax( std::atomic<uint64_t>& max, uint64_t value)
+{
+	// there is only one writer
+	if( value > max.load(std::memory_order_relaxed))
+		max.store( value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+double LossMonitor::Statistics::lossRate() const
+{
+	uint64_t expected = received - duplicates + lost;
+	if( expected == 0) return 0.0;
+	return static_cast<double>(lost) / static_cast<double>(expected);
+}
+
+double LossMonitor::Statistics::averageBurst() const
+{
+	if( bursts == 0) return 0.0;
+	return static_cast<double>(lost) / static_cast<double>(bursts);
+}
+
+LossMonitor::LossMonitor( UDPSocket& socket)
+: m_socket(socket)
+, m_offset(0)
+, m_width(0)
+{
+	int enable = 1;
+	if( setsockopt( m_socket.nativeHandle(), SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) < 0)
+		throw SocketException("Enable drop counter failed (setsockopt)");
+
+	reset();
+}
+
+void LossMonitor::setSequenceField( size_t offset, size_t width)
+{
+	switch(width)
+	{
+	case 1:
+	case 2:
+	case 4:
+	case 8:
+		break;
+	default:
+		throw SocketException("Sequence number width must be 1, 2, 4 or 8 bytes", false);
+	}
+
+	m_offset = offset;
+	m_width = width;
+	m_haveSequence = false;
+}
+
+int LossMonitor::receive( void* buffer, size_t len)
+{
+	char control[CMSG_SPACE(sizeof(uint32_t))];
+
+	struct iovec iov;
+	iov.iov_base = buffer;
+	iov.iov_len = len;
+
+	struct msghdr msg;
+	std::memset( &msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	int ret = TEMP_FAILURE_RETRY (::recvmsg( m_socket.nativeHandle(), &msg, 0));
+	if( ret < 0)
+		throw SocketException("Receive failed (recvmsg)");
+
+	// the counter is only passed along if it is not zero
+	for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+		{
+			uint32_t drops;
+			std::memcpy( &drops, CMSG_DATA(cmsg), sizeof(drops));
+			updateKernelDrops(drops);
+		}
+	}
+
+	++m_received;
+
+	// the datagram might have been truncated
+	size_t received = std::min( static_cast<size_t>(ret), len);
+	if( m_width)
+		updateSequence( buffer, received);
+
+	return ret;
+}
+
+int LossMonitor::timedReceive( void* buffer, size_t len, int timeout)
+{
+	struct pollfd poll;
+	poll.fd = m_socket.nativeHandle();
+	poll.events = POLLIN | POLLPRI;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return 0;
+	if( ret < 0)  throw SocketException("Receive failed (poll)");
+
+	if( poll.revents & POLLIN || poll.revents & POLLPRI)
+		return receive( buffer, len);
+
+	return 0;
+}
+
+LossMonitor::Statistics LossMonitor::statistics() const
+{
+	Statistics stats;
+	stats.received = m_received;
+	stats.kernelDrops = m_kernelDrops;
+	stats.lost = m_lost;
+	stats.bursts = m_bursts;
+	stats.maxBurst = m_maxBurst;
+	stats.reordered = m_reordered;
+	stats.maxReorderDepth = m_maxReorderDepth;
+	stats.duplicates = m_duplicates;
+	return stats;
+}
+
+void LossMonitor::reset()
+{
+	m_firstDrops = readKernelDrops( m_socket.nativeHandle());
+	m_haveSequence = false;
+	m_highest = 0;
+	m_receivedWindow = 0;
+	m_missingWindow = 0;
+	m_settledMaxBurst = 0;
+
+	m_received = 0;
+	m_kernelDrops = 0;
+	m_lost = 0;
+	m_bursts = 0;
+	m_maxBurst = 0;
+	m_reordered = 0;
+	m_maxReorderDepth = 0;
+	m_duplicates = 0;
+}
+
+void LossMonitor::updateKernelDrops( uint32_t drops)
+{
+	// unsigned arithmetic also handles wrap around of the counter, datagrams
+	// queued before reset() carry a counter behind the baseline
+	uint32_t sinceReset = drops - m_firstDrops;
+	if( sinceReset > 0x7fffffff)
+		sinceReset = 0;
+	m_kernelDrops.store( sinceReset, std::memory_order_relaxed);
+}
+
+void LossMonitor::updateSequence( const void* buffer, size_t len)
+{
+	if( len < m_offset + m_width) return;
+
+	const unsigned char* field = static_cast<const unsigned char*>(buffer) + m_offset;
+	uint64_t sequence = 0;
+	for( size_t i = 0; i < m_width; ++i)
+		sequence = (sequence << 8) | field[i];
+
+	if( !m_haveSequence)
+	{
+		m_haveSequence = true;
+		m_highest = sequence;
+		m_receivedWindow = 1;
+		m_missingWindow = 0;
+		return;
+	}
+
+	uint64_t mask = (m_width == 8) ? ~uint64_t(0) : (uint64_t(1) << (m_width * 8)) - 1;
+	uint64_t ahead = (sequence - m_highest) & mask;
+	uint64_t behind = (m_highest - sequence) & mask;
+
+	if( ahead != 0 && ahead <= mask / 2)
+	{
+		uint64_t gap = ahead - 1;
+		if( gap)
+		{
+			m_lost += gap;
+			++m_bursts;
+		}
+
+		// gaps leaving the window can no longer be filled, their length is final
+		if( ahead >= WINDOW_SIZE)
+		{
+			m_settledMaxBurst = std::max( m_settledMaxBurst, std::max( longestRun( m_missingWindow), gap));
+			m_receivedWindow = 1;
+			m_missingWindow = gapBits(gap);
+		}
+		else
+		{
+			uint64_t leaving = ~(~uint64_t(0) >> ahead);
+			if( m_missingWindow & leaving)
+				m_settledMaxBurst = std::max( m_settledMaxBurst, longestRun( runsReaching( m_missingWindow, leaving)));
+			m_receivedWindow = (m_receivedWindow << ahead) | 1;
+			m_missingWindow = (m_missingWindow << ahead) | gapBits(gap);
+		}
+		m_highest = sequence;
+		if( m_missingWindow)
+			updateMaxBurst();
+		return;
+	}
+
+	if( behind < WINDOW_SIZE)
+	{
+		uint64_t bit = uint64_t(1) << behind;
+		if( m_receivedWindow & bit)
+		{
+			++m_duplicates;
+			return;
+		}
+
+		m_receivedWindow |= bit;
+		if( m_missingWindow & bit)
+		{
+			// fills a gap that was already counted as loss, which removes,
+			// shortens or splits the gap
+			bool older = m_missingWindow & (bit << 1);
+			bool newer = m_missingWindow & (bit >> 1);
+			m_missingWindow &= ~bit;
+			--m_lost;
+			if( !older && !newer)
+				--m_bursts;
+			else if( older && newer)
+				++m_bursts;
+			updateMaxBurst();
+		}
+	}
+
+	++m_reordered;
+	updateMax( m_maxReorderDepth, behind);
+}
+
+void LossMonitor::updateMaxBurst()
+{
+	uint64_t max = std::max( m_settledMaxBurst, longestRun( m_missingWindow));
+	m_maxBurst.store( max, std::memory_order_relaxed);
+}
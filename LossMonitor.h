@@ -0,0 +1,156 @@
+#ifndef NET_LossMonitor_h__
+#define NET_LossMonitor_h__
+
+#include "UDPSocket.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace NET
+{
+	//! Measures datagram loss of a receiving UDPSocket
+	/*!
+	 * LossMonitor receives through a bound UDPSocket and keeps track of
+	 * the datagrams the kernel dropped because the receive buffer of the
+	 * socket was full (SO_RXQ_OVFL).
+	 *
+	 * If the datagrams carry a sequence number, setSequenceField() enables
+	 * detection of gaps, reordering and duplicates. This also covers loss
+	 * that happened before the datagrams reached the socket.
+	 *
+	 * All counters are updated with every received datagram and can be
+	 * read at any time from other threads using statistics(). Receiving
+	 * must only be done by one thread at a time.
+	 *
+	 * Usage example:
+	 * \code
+	 * UDPSocket socket;
+	 * socket.bind(47777);
+	 * socket.joinGroup("224.40.0.1");
+	 * LossMonitor monitor(socket);
+	 * monitor.setSequenceField( 0, 4);
+	 * while( running)
+	 *   process( buffer, monitor.receive( buffer, sizeof(buffer)));
+	 * \endcode
+	 */
+	class LossMonitor
+	{
+	public:
+		//! A snapshot of all loss counters
+		/*!
+		 * The kernel reports its drop counter along with the datagrams it
+		 * queues, so drops become visible with the first datagram received
+		 * after them.
+		 *
+		 * A datagram arriving late fills its place in a gap, which shortens
+		 * the gap, splits it in two or removes it, so pure reordering does
+		 * not count as burst. Gaps more than 64 sequence numbers behind the
+		 * highest one received are final.
+		 */
+		struct Statistics
+		{
+			uint64_t received;        ///< number of received datagrams, including duplicates
+			uint64_t kernelDrops;     ///< datagrams dropped by the kernel since monitoring started, see above
+			uint64_t lost;            ///< sequence numbers that are missing
+			uint64_t bursts;          ///< number of gaps in the sequence numbers, see below
+			uint64_t maxBurst;        ///< length of the longest gap, see below
+			uint64_t reordered;       ///< datagrams that arrived after a higher sequence number
+			uint64_t maxReorderDepth; ///< largest distance of a reordered datagram to the highest sequence number
+			uint64_t duplicates;      ///< datagrams received more than once
+
+			//! ratio of lost to expected datagrams
+			double lossRate() const;
+
+			//! average number of datagrams lost in one gap
+			double averageBurst() const;
+		};
+
+		/*!
+		 * Start to monitor the given socket. The socket must outlive
+		 * the monitor.
+		 * \param socket bound socket to receive from
+		 * \exception SocketException thrown if unable to enable drop counting
+		 */
+		explicit LossMonitor( UDPSocket& socket);
+
+		//! Enable detection of sequence gaps
+		/*!
+		 * The sequence number is read in network byte order from every
+		 * datagram at the given offset. Datagrams too short to contain
+		 * the field are not taken into account. Wrap around of the
+		 * sequence number is handled.
+		 *
+		 * \param offset offset of the sequence number within the datagram
+		 * \param width size of the sequence number in bytes (1, 2, 4 or 8)
+		 * \exception SocketException thrown if width is not supported
+		 */
+		void setSequenceField( size_t offset, size_t width);
+
+		/*!
+		 * Receive one datagram like UDPSocket::receive() and update
+		 * the counters.
+		 *
+		 * \param buffer buffer to receive data
+		 * \param len maximum number of bytes to receive
+		 * \return number of bytes received
+		 * \exception SocketException thrown if unable to receive datagram
+		 */
+		int receive( void* buffer, size_t len);
+
+		/*!
+		 * Receive one datagram like UDPSocket::timedReceive() and update
+		 * the counters.
+		 *
+		 * \param buffer buffer to receive data
+		 * \param len maximum number of bytes to receive
+		 * \param timeout timeout in milliseconds
+		 * \return number of bytes received, 0 on timeout
+		 * \exception SocketException thrown if unable to receive datagram
+		 */
+		int timedReceive( void* buffer, size_t len, int timeout);
+
+		//! return a snapshot of the current counters
+		Statistics statistics() const;
+
+		//! set all counters to zero and forget the last sequence number
+		/*!
+		 * Must not be called while another thread is receiving.
+		 * \exception SocketException thrown if unable to read the drop counter
+		 */
+		void reset();
+
+	private:
+		void updateKernelDrops( uint32_t drops);
+		void updateSequence( const void* buffer, size_t len);
+		void updateMaxBurst();
+
+		// dont' allow
+		LossMonitor( const LossMonitor&);
+		const LossMonitor& operator=( const LossMonitor&);
+
+		UDPSocket& m_socket;
+
+		size_t m_offset;
+		size_t m_width;
+
+		// receive side state, only touched by the receiving thread
+		bool m_haveSequence;
+		uint64_t m_highest;
+		uint64_t m_receivedWindow;
+		uint64_t m_missingWindow;
+		uint64_t m_settledMaxBurst;   // longest gap that left the window
+		uint32_t m_firstDrops;
+
+		std::atomic<uint64_t> m_received;
+		std::atomic<uint64_t> m_kernelDrops;
+		std::atomic<uint64_t> m_lost;
+		std::atomic<uint64_t> m_bursts;
+		std::atomic<uint64_t> m_maxBurst;
+		std::atomic<uint64_t> m_reordered;
+		std::atomic<uint64_t> m_maxReorderDepth;
+		std::atomic<uint64_t> m_duplicates;
+	};
+
+} // namespace NET
+
+#endif // NET_LossMonitor_h__
@@ -0,0 +1,313 @@
+#include "MulticastFanout.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/bpf.h>
+#include <linux/filter.h>
+#include <linux/sock_diag.h>
+#include <pthread.h>
+#include <sched.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+uint32_t steeringOffset( MulticastFanout::Steering steering)
+{
+	int ancillary = (steering == MulticastFanout::BY_CPU) ? SKF_AD_CPU : SKF_AD_RXHASH;
+	return static_cast<uint32_t>(SKF_AD_OFF + ancillary);
+}
+
+// multicast datagrams are delivered to every socket of a reuseport group,
+// so each shard drops the datagrams that belong to another shard
+void attachShardFilter( int socket, MulticastFanout::Steering steering, unsigned shards, unsigned shard)
+{
+	struct sock_filter code[] = {
+		{ BPF_LD  | BPF_W   | BPF_ABS, 0, 0, steeringOffset(steering) },
+		{ BPF_ALU | BPF_MOD | BPF_K,   0, 0, shards },
+		{ BPF_JMP | BPF_JEQ | BPF_K,   0, 1, shard },
+		{ BPF_RET | BPF_K,             0, 0, 0xffffffff },
+		{ BPF_RET | BPF_K,             0, 0, 0 }
+	};
+	struct sock_fprog prog = { sizeof(code) / sizeof(code[0]), code };
+
+	if( setsockopt( socket, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) < 0)
+		throw SocketException("Attach of shard filter failed (setsockopt)");
+}
+
+int bpf( int cmd, bpf_attr& attr)
+{
+	return static_cast<int>( ::syscall( __NR_bpf, cmd, &attr, sizeof(attr)));
+}
+
+bpf_insn instruction( uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+	bpf_insn insn;
+	insn.code = code;
+	insn.dst_reg = dst & 0xf;
+	insn.src_reg = src & 0xf;
+	insn.off = off;
+	insn.imm = imm;
+	return insn;
+}
+
+// per shard counters of the filter, kept in an array map indexed by shard
+struct FilterCounters
+{
+	uint64_t seen;      // datagrams that reached the filter
+	uint64_t accepted;  // datagrams that belong to the shard
+};
+
+int createCounterMap( unsigned shards)
+{
+	bpf_attr attr;
+	std::memset( &attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_ARRAY;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(FilterCounters);
+	attr.max_entries = shards;
+	return bpf( BPF_MAP_CREATE, attr);
+}
+
+// the shard filter as eBPF program, which also counts what it rejects, so
+// the kernel drop counter of the socket can be corrected by the rejects
+void attachCountingShardFilter( int socket, int mapFd, MulticastFanout::Steering steering, unsigned shards, unsigned shard)
+{
+	const int32_t index = static_cast<int32_t>(shard);
+	const int16_t seen = offsetof(FilterCounters, seen);
+	const int16_t accepted = offsetof(FilterCounters, accepted);
+
+	// the selector of the shard is the CPU or the receive hash, like SKF_AD_CPU and SKF_AD_RXHASH
+	bpf_insn select = (steering == MulticastFanout::BY_CPU)
+		? instruction( BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_get_smp_processor_id)
+		: instruction( BPF_LDX | BPF_W | BPF_MEM, BPF_REG_0, BPF_REG_6, offsetof(__sk_buff, hash), 0);
+
+	bpf_insn program[] = {
+		// counters = bpf_map_lookup_elem( &map, &shard)
+		instruction( BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0),
+		instruction( BPF_ST | BPF_W | BPF_MEM, BPF_REG_10, 0, -4, index),
+		instruction( BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_2, BPF_REG_10, 0, 0),
+		instruction( BPF_ALU64 | BPF_ADD | BPF_K, BPF_REG_2, 0, 0, -4),
+		instruction( BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, mapFd),
+		instruction( 0, 0, 0, 0, 0),
+		instruction( BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_map_lookup_elem),
+		instruction( BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0),
+		// if( counters) ++counters->seen
+		instruction( BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_7, 0, 2, 0),
+		instruction( BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, 1),
+		instruction( BPF_STX | BPF_DW | BPF_XADD, BPF_REG_7, BPF_REG_1, seen, 0),
+		// if( selector % shards != shard) return 0
+		select,
+		instruction( BPF_ALU | BPF_MOD | BPF_K, BPF_REG_0, 0, 0, static_cast<int32_t>(shards)),
+		instruction( BPF_JMP | BPF_JNE | BPF_K, BPF_REG_0, 0, 5, index),
+		// if( counters) ++counters->accepted
+		instruction( BPF_JMP | BPF_JEQ | BPF_K, BPF_REG_7, 0, 2, 0),
+		instruction( BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_1, 0, 0, 1),
+		instruction( BPF_STX | BPF_DW | BPF_XADD, BPF_REG_7, BPF_REG_1, accepted, 0),
+		instruction( BPF_ALU | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, -1),
+		instruction( BPF_JMP | BPF_EXIT, 0, 0, 0, 0),
+		instruction( BPF_ALU | BPF_MOV | BPF_K, BPF_REG_0, 0, 0, 0),
+		instruction( BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+	};
+	const char license[] = "Dual MIT/GPL";
+
+	bpf_attr attr;
+	std::memset( &attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+	attr.insns = reinterpret_cast<uintptr_t>(program);
+	attr.insn_cnt = sizeof(program) / sizeof(program[0]);
+	attr.license = reinterpret_cast<uintptr_t>(license);
+	int progFd = bpf( BPF_PROG_LOAD, attr);
+	if( progFd < 0)
+		throw SocketException("Load of shard filter failed (bpf)");
+
+	// the socket keeps the program alive
+	int ret = setsockopt( socket, SOL_SOCKET, SO_ATTACH_BPF, &progFd, sizeof(progFd));
+	::close( progFd);
+	if( ret < 0)
+		throw SocketException("Attach of shard filter failed (setsockopt)");
+}
+
+FilterCounters readCounters( int mapFd, unsigned shard)
+{
+	uint32_t key = shard;
+	FilterCounters counters;
+	bpf_attr attr;
+	std::memset( &attr, 0, sizeof(attr));
+	attr.map_fd = static_cast<uint32_t>(mapFd);
+	attr.key = reinterpret_cast<uintptr_t>(&key);
+	attr.value = reinterpret_cast<uintptr_t>(&counters);
+	if( bpf( BPF_MAP_LOOKUP_ELEM, attr) < 0)
+		throw SocketException("Fetch of filter counters failed (bpf)");
+	return counters;
+}
+
+// number of datagrams the kernel did not queue to the socket, wraps like the kernel counter
+uint32_t socketDrops( int socket)
+{
+	uint32_t meminfo[SK_MEMINFO_VARS];
+	socklen_t len = sizeof(meminfo);
+	if( getsockopt( socket, SOL_SOCKET, SO_MEMINFO, meminfo, &len) < 0)
+		throw SocketException("Fetch of drop counter failed (getsockopt)");
+	return meminfo[SK_MEMINFO_DROPS];
+}
+
+void pinThread( int cpu)
+{
+	// failing to pin is not fatal, the thread just runs unpinned
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(static_cast<size_t>(cpu), &set);
+	pthread_setaffinity_np( pthread_self(), sizeof(set), &set);
+}
+
+} // namespace
+
+MulticastFanout::MulticastFanout( const std::string& multicastGroup, unsigned short port, unsigned shards,
+                                  Steering steering /* = BY_CPU */)
+: m_mapFd(-1)
+, m_running(false)
+{
+	if( shards == 0)
+		throw SocketException("MulticastFanout needs at least one shard", false);
+
+	// counting the rejects needs eBPF, without the privilege the shards only steer
+	m_mapFd = createCounterMap( shards);
+	if( m_mapFd < 0 && errno != EPERM)
+		throw SocketException("Creation of filter counters failed (bpf)");
+
+	try
+	{
+		for( unsigned i = 0; i < shards; ++i)
+		{
+			std::unique_ptr<Shard> shard( new Shard);
+			shard->socket.setReusePort(true);
+			if( m_mapFd >= 0)
+				attachCountingShardFilter( shard->socket.nativeHandle(), m_mapFd, steering, shards, i);
+			else
+				attachShardFilter( shard->socket.nativeHandle(), steering, shards, i);
+			shard->socket.bind( multicastGroup, port);
+			m_shards.push_back( std::move(shard));
+		}
+
+		m_shards[0]->socket.joinGroup( multicastGroup);
+	}
+	catch(...)
+	{
+		if( m_mapFd >= 0) ::close( m_mapFd);
+		throw;
+	}
+}
+
+MulticastFanout::~MulticastFanout()
+{
+	stop();
+	if( m_mapFd >= 0) ::close( m_mapFd);
+}
+
+unsigned MulticastFanout::shards() const
+{
+	return static_cast<unsigned>(m_shards.size());
+}
+
+UDPSocket& MulticastFanout::socket( unsigned shard)
+{
+	return m_shards.at(shard)->socket;
+}
+
+void MulticastFanout::start( const Handler& handler, const std::vector<int>& cpus /* = std::vector<int>() */)
+{
+	if( m_running.exchange(true))
+		throw SocketException("MulticastFanout is already running", false);
+
+	m_handler = handler;
+	for( auto& shard : m_shards)
+		shard->error = 0;
+
+	unsigned numCPUs = std::thread::hardware_concurrency();
+	if( numCPUs == 0) numCPUs = 1;
+
+	for( unsigned i = 0; i < m_shards.size(); ++i)
+	{
+		int cpu = cpus.empty() ? static_cast<int>(i % numCPUs) : cpus[i % cpus.size()];
+		m_shards[i]->thread = std::thread( &MulticastFanout::run, this, i, cpu);
+	}
+}
+
+void MulticastFanout::stop()
+{
+	m_running = false;
+
+	for( auto& shard : m_shards)
+	{
+		if( shard->thread.joinable())
+			shard->thread.join();
+	}
+}
+
+uint64_t MulticastFanout::received( unsigned shard) const
+{
+	return m_shards.at(shard)->received;
+}
+
+uint64_t MulticastFanout::drops( unsigned shard) const
+{
+	if( m_mapFd < 0)
+		throw SocketException("Drop counting of MulticastFanout needs CAP_BPF", false);
+
+	// the socket counter is read first, so a datagram being rejected meanwhile is never taken for a loss
+	uint32_t dropped = socketDrops( m_shards.at(shard)->socket.nativeHandle());
+	FilterCounters counters = readCounters( m_mapFd, shard);
+
+	// modulo 2^32 like the kernel counter, a negative result is a reject in delivery
+	uint32_t lost = dropped - static_cast<uint32_t>(counters.seen - counters.accepted);
+	return lost > 0x7fffffff ? 0 : lost;
+}
+
+int MulticastFanout::error( unsigned shard) const
+{
+	return m_shards.at(shard)->error;
+}
+
+void MulticastFanout::run( unsigned index, int cpu)
+{
+	pinThread(cpu);
+
+	Shard& shard = *m_shards[index];
+	int socket = shard.socket.nativeHandle();
+
+	char buffer[65536];
+
+	while( m_running)
+	{
+		// wake up regularly to notice stop()
+		struct pollfd poll;
+		poll.fd = socket;
+		poll.events = POLLIN;
+
+		int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, 100));
+		if( ret < 0)
+		{
+			shard.error = errno;
+			break;
+		}
+		if( ret == 0) continue;
+
+		ret = TEMP_FAILURE_RETRY (::recv( socket, buffer, sizeof(buffer), MSG_DONTWAIT));
+		if( ret < 0)
+		{
+			if( errno == EAGAIN) continue;
+			shard.error = errno;
+			break;
+		}
+
+		++shard.received;
+		m_handler( index, buffer, static_cast<size_t>(ret));
+	}
+}
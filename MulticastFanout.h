@@ -0,0 +1,149 @@
+#ifndef NET_MulticastFanout_h__
+#define NET_MulticastFanout_h__
+
+#include "UDPSocket.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace NET
+{
+	//! Distributes the datagrams of one multicast group to several threads
+	/*!
+	 * MulticastFanout opens one UDPSocket per shard, all bound to the same
+	 * multicast group and port using SO_REUSEPORT. Each datagram is handed
+	 * to exactly one shard, which is selected either by the CPU that
+	 * processed the datagram in the kernel, or by the receive hash of the
+	 * flow. The group is joined only once for all shards.
+	 *
+	 * Every shard is served by its own thread, pinned to a CPU. Datagrams
+	 * are passed to a user provided handler, which is called concurrently
+	 * from all shard threads.
+	 *
+	 * Usage example:
+	 * \code
+	 * MulticastFanout fanout( "224.40.0.1", 47777, 4);
+	 * fanout.start( [](unsigned shard, const void* data, size_t len) {
+	 *   process( shard, data, len);
+	 * });
+	 * // ...
+	 * fanout.stop();
+	 * \endcode
+	 */
+	class MulticastFanout
+	{
+	public:
+		enum Steering
+		{
+			BY_CPU,  ///< select the shard by the CPU that received the datagram
+			BY_HASH  ///< select the shard by the receive hash of the flow
+		};
+
+		//! called for every received datagram with the index of the receiving shard
+		typedef std::function<void( unsigned shard, const void* data, size_t len)> Handler;
+
+		/*!
+		 * Create and bind one socket per shard and join the multicast group.
+		 *
+		 * The group is only joined by the first shard. This relies on the
+		 * default behaviour of Linux to deliver the datagrams of all joined
+		 * groups to every socket bound to the port (IP_MULTICAST_ALL).
+		 *
+		 * \param multicastGroup multicast group address to join
+		 * \param port local port to bind all shards to
+		 * \param shards number of sockets and threads
+		 * \param steering how datagrams are distributed between the shards
+		 * \exception SocketException thrown if unable to create the sockets
+		 */
+		MulticastFanout( const std::string& multicastGroup, unsigned short port, unsigned shards,
+		                 Steering steering = BY_CPU);
+
+		//! stops all running threads, closing the sockets leaves the multicast group
+		~MulticastFanout();
+
+		//! return the number of shards
+		unsigned shards() const;
+
+		//! access the socket of the given shard, e.g. to set options
+		UDPSocket& socket( unsigned shard);
+
+		//! start one receiving thread per shard
+		/*!
+		 * The thread of shard i is pinned to cpus[i % cpus.size()]. If no
+		 * CPUs are given, it is pinned to CPU i modulo the number of
+		 * available CPUs, which matches the BY_CPU steering.
+		 *
+		 * \param handler function called for every received datagram
+		 * \param cpus CPUs to pin the threads to
+		 * \exception SocketException thrown if the threads are already running
+		 */
+		void start( const Handler& handler, const std::vector<int>& cpus = std::vector<int>());
+
+		//! stop all receiving threads and wait for them to finish
+		void stop();
+
+		//! return the number of datagrams received by the given shard
+		uint64_t received( unsigned shard) const;
+
+		//! return the number of datagrams the kernel dropped for the given shard
+		/*!
+		 * Multicast datagrams are delivered to every socket bound to the
+		 * port, SO_REUSEPORT and reuseport BPF programs do not select one of
+		 * them. The steering is done alone by the socket filter of each
+		 * shard, which rejects the datagrams of the other shards. The kernel
+		 * counts these rejects in the same per-socket counter as receive
+		 * buffer overflows (SO_RXQ_OVFL, SO_MEMINFO).
+		 *
+		 * The shard filters are eBPF programs that count the datagrams they
+		 * see and accept, so the rejects are subtracted and only the real
+		 * losses of the shard remain, i.e. the overflows of its receive
+		 * queue. The result is exact while no datagram is being delivered
+		 * and may lag behind otherwise.
+		 *
+		 * Loading eBPF programs needs CAP_BPF (or CAP_SYS_ADMIN). Without it
+		 * the shards steer with classic filters and can not count.
+		 *
+		 * \exception SocketException thrown if unable to read the counters
+		 *            or if the shards were created without counting filters
+		 */
+		uint64_t drops( unsigned shard) const;
+
+		//! return the error that stopped the thread of the given shard
+		/*!
+		 * A thread leaves its loop if poll() or recv() fail, which is
+		 * reported as errno value. It is reset by start().
+		 *
+		 * \return 0 while the thread runs or after it was stopped by stop()
+		 */
+		int error( unsigned shard) const;
+
+	private:
+		struct Shard
+		{
+			UDPSocket socket;
+			std::thread thread;
+			std::atomic<uint64_t> received;
+			std::atomic<int> error;
+
+			Shard() : received(0), error(0) {}
+		};
+
+		void run( unsigned shard, int cpu);
+
+		// dont' allow
+		MulticastFanout( const MulticastFanout&);
+		const MulticastFanout& operator=( const MulticastFanout&);
+
+		std::vector<std::unique_ptr<Shard>> m_shards;
+		int m_mapFd;   // counters of the shard filters, -1 without eBPF
+		Handler m_handler;
+		std::atomic<bool> m_running;
+	};
+
+} // namespace NET
+
+#endif // NET_MulticastFanout_h__
@@ -0,0 +1,243 @@
+#include "PacketRingSocket.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <net/if.h>
+#include <poll.h>
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+// the link layer address of a received frame and the data of a frame in
+// the transmit ring follow the aligned header
+const size_t HEADER_SIZE = (sizeof(struct tpacket3_hdr) + TPACKET_ALIGNMENT - 1) & ~size_t(TPACKET_ALIGNMENT - 1);
+
+// the kernel changes the status words concurrently
+uint32_t loadStatus( const uint32_t& status)
+{
+	return __atomic_load_n( &status, __ATOMIC_ACQUIRE);
+}
+
+void storeStatus( uint32_t& status, uint32_t value)
+{
+	__atomic_store_n( &status, value, __ATOMIC_RELEASE);
+}
+
+void setPacketOption( int socket, int option, const void* value, socklen_t len, const char* message)
+{
+	if( setsockopt( socket, SOL_PACKET, option, value, len) < 0)
+		throw SocketException(message);
+}
+
+} // namespace
+
+PacketRingSocket::FrameIterator::FrameIterator()
+: m_next(nullptr)
+, m_count(0)
+, m_remaining(0)
+{}
+
+bool PacketRingSocket::FrameIterator::next( Frame& frame)
+{
+	if( m_remaining == 0) return false;
+
+	const tpacket3_hdr* hdr = reinterpret_cast<const tpacket3_hdr*>(m_next);
+	frame.data = m_next + hdr->tp_mac;
+	frame.len = hdr->tp_snaplen;
+	frame.wireLen = hdr->tp_len;
+	frame.sec = hdr->tp_sec;
+	frame.nsec = hdr->tp_nsec;
+	frame.type = reinterpret_cast<const sockaddr_ll*>(m_next + HEADER_SIZE)->sll_pkttype;
+
+	m_next += hdr->tp_next_offset;
+	--m_remaining;
+	return true;
+}
+
+PacketRingSocket::PacketRingSocket( const std::string& interface, unsigned blockSize /* = 1 << 18 */,
+                                    unsigned blockCount /* = 16 */, unsigned frameSize /* = 2048 */,
+                                    unsigned txFrames /* = 256 */)
+: SimpleSocket( PACKET, RAW, htons(ETH_P_ALL))
+, m_map(nullptr)
+, m_mapSize(0)
+, m_rxRing(nullptr)
+, m_blockSize(blockSize)
+, m_blockCount(blockCount)
+, m_currentBlock(0)
+, m_blockPending(false)
+, m_txRing(nullptr)
+, m_frameSize(frameSize)
+, m_txFrames(0)
+, m_currentFrame(0)
+{
+	unsigned ifindex = 0;
+	if( !interface.empty() && (ifindex = if_nametoindex( interface.c_str())) == 0)
+		throw SocketException("Unknown interface (if_nametoindex)");
+
+	setupRings( blockSize, blockCount, frameSize, txFrames);
+
+	sockaddr_ll addr;
+	std::memset( &addr, 0, sizeof(addr));
+	addr.sll_family = AF_PACKET;
+	addr.sll_protocol = htons(ETH_P_ALL);
+	addr.sll_ifindex = static_cast<int>(ifindex);
+
+	if( ::bind( m_socket, (sockaddr*) &addr, sizeof(addr)) < 0)
+	{
+		SocketException error("Set of interface failed (bind)");
+		::munmap( m_map, m_mapSize);
+		throw error;
+	}
+}
+
+PacketRingSocket::~PacketRingSocket()
+{
+	::munmap( m_map, m_mapSize);
+}
+
+void PacketRingSocket::setupRings( unsigned blockSize, unsigned blockCount, unsigned frameSize, unsigned txFrames)
+{
+	if( frameSize < HEADER_SIZE || blockSize % frameSize != 0)
+		throw SocketException("Frame size has to divide the block size", false);
+
+	int version = TPACKET_V3;
+	setPacketOption( m_socket, PACKET_VERSION, &version, sizeof(version), "Set of packet version failed (setsockopt)");
+
+	unsigned framesPerBlock = blockSize / frameSize;
+
+	tpacket_req3 rx;
+	std::memset( &rx, 0, sizeof(rx));
+	rx.tp_block_size = blockSize;
+	rx.tp_block_nr = blockCount;
+	rx.tp_frame_size = frameSize;
+	rx.tp_frame_nr = framesPerBlock * blockCount;
+	rx.tp_retire_blk_tov = 10;
+	setPacketOption( m_socket, PACKET_RX_RING, &rx, sizeof(rx), "Set up of receive ring failed (setsockopt)");
+
+	// the transmit ring uses blocks of the same size, filled frame by frame
+	unsigned txBlocks = (txFrames + framesPerBlock - 1) / framesPerBlock;
+	if( txBlocks)
+	{
+		tpacket_req3 tx;
+		std::memset( &tx, 0, sizeof(tx));
+		tx.tp_block_size = blockSize;
+		tx.tp_block_nr = txBlocks;
+		tx.tp_frame_size = frameSize;
+		tx.tp_frame_nr = framesPerBlock * txBlocks;
+		setPacketOption( m_socket, PACKET_TX_RING, &tx, sizeof(tx), "Set up of transmit ring failed (setsockopt)");
+		m_txFrames = tx.tp_frame_nr;
+	}
+
+	size_t rxSize = static_cast<size_t>(blockSize) * blockCount;
+	size_t txSize = static_cast<size_t>(blockSize) * txBlocks;
+	void* map = ::mmap( nullptr, rxSize + txSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_socket, 0);
+	if( map == MAP_FAILED)
+		throw SocketException("Mapping of rings failed (mmap)");
+
+	m_map = static_cast<uint8_t*>(map);
+	m_mapSize = rxSize + txSize;
+	m_rxRing = m_map;
+	m_txRing = txBlocks ? m_map + rxSize : nullptr;
+}
+
+bool PacketRingSocket::receiveBlock( FrameIterator& frames, int timeout)
+{
+	releaseBlock();
+
+	tpacket_block_desc* desc = reinterpret_cast<tpacket_block_desc*>( m_rxRing + static_cast<size_t>(m_currentBlock) * m_blockSize);
+
+	if( !(loadStatus( desc->hdr.bh1.block_status) & TP_STATUS_USER))
+	{
+		struct pollfd poll;
+		poll.fd = m_socket;
+		poll.events = POLLIN | POLLERR;
+
+		int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+		if( ret == 0) return false;
+		if( ret < 0)  throw SocketException("Receive failed (poll)");
+
+		if( !(loadStatus( desc->hdr.bh1.block_status) & TP_STATUS_USER))
+			return false;
+	}
+
+	frames.m_next = reinterpret_cast<const uint8_t*>(desc) + desc->hdr.bh1.offset_to_first_pkt;
+	frames.m_count = desc->hdr.bh1.num_pkts;
+	frames.m_remaining = frames.m_count;
+
+	m_blockPending = true;
+	return true;
+}
+
+void PacketRingSocket::releaseBlock()
+{
+	if( !m_blockPending) return;
+
+	tpacket_block_desc* desc = reinterpret_cast<tpacket_block_desc*>( m_rxRing + static_cast<size_t>(m_currentBlock) * m_blockSize);
+	storeStatus( desc->hdr.bh1.block_status, TP_STATUS_KERNEL);
+
+	m_currentBlock = (m_currentBlock + 1) % m_blockCount;
+	m_blockPending = false;
+}
+
+bool PacketRingSocket::queueFrame( const void* frame, size_t len)
+{
+	if( m_txFrames == 0)
+		throw SocketException("No transmit ring available", false);
+	if( len > m_frameSize - HEADER_SIZE)
+		throw SocketException("Frame is too large for the transmit ring", false);
+
+	uint8_t* slot = m_txRing + static_cast<size_t>(m_currentFrame) * m_frameSize;
+	tpacket3_hdr* hdr = reinterpret_cast<tpacket3_hdr*>(slot);
+
+	if( loadStatus( hdr->tp_status) & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING))
+		return false;
+
+	std::memcpy( slot + HEADER_SIZE, frame, len);
+	hdr->tp_len = static_cast<uint32_t>(len);
+	hdr->tp_snaplen = static_cast<uint32_t>(len);
+	storeStatus( hdr->tp_status, TP_STATUS_SEND_REQUEST);
+
+	m_currentFrame = (m_currentFrame + 1) % m_txFrames;
+	return true;
+}
+
+int PacketRingSocket::flush()
+{
+	int sent = TEMP_FAILURE_RETRY (::send( m_socket, nullptr, 0, 0));
+	if( sent < 0)
+		throw SocketException("Send failed (send)");
+	return sent;
+}
+
+void PacketRingSocket::setFanout( uint16_t groupId, FanoutMode mode)
+{
+	int fanout = groupId | (mode << 16);
+	setPacketOption( m_socket, PACKET_FANOUT, &fanout, sizeof(fanout), "Join of fanout group failed (setsockopt)");
+}
+
+void PacketRingSocket::setIgnoreOutgoing( bool enable)
+{
+	int ignore = enable;
+	setPacketOption( m_socket, PACKET_IGNORE_OUTGOING, &ignore, sizeof(ignore), "Set ignore outgoing failed (setsockopt)");
+}
+
+PacketRingSocket::Statistics PacketRingSocket::statistics()
+{
+	tpacket_stats_v3 stats;
+	socklen_t size = sizeof(stats);
+
+	if( getsockopt( m_socket, SOL_PACKET, PACKET_STATISTICS, &stats, &size) < 0)
+		throw SocketException("Fetch of statistics failed (getsockopt)");
+
+	Statistics ret;
+	ret.packets = stats.tp_packets;
+	ret.drops = stats.tp_drops;
+	ret.freezes = stats.tp_freeze_q_cnt;
+	return ret;
+}
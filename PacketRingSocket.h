@@ -0,0 +1,204 @@
+#ifndef NET_PacketRingSocket_h__
+#define NET_PacketRingSocket_h__
+
+#include "SimpleSocket.h"
+
+#include <linux/if_packet.h>
+#include <cstdint>
+
+namespace NET
+{
+	//! Packet socket class using memory mapped receive and transmit rings
+	/*!
+	 * PacketRingSocket captures and injects complete link layer frames
+	 * (AF_PACKET). Frames are exchanged with the kernel through rings
+	 * shared by memory mapping (TPACKET_V3), so no system call and no copy
+	 * is needed per received frame.
+	 *
+	 * The kernel fills the receive ring block by block. A block is handed
+	 * to the user when it is full or its timeout of 10 ms expired. Frames
+	 * of a block are read in place using a FrameIterator.
+	 *
+	 * Capturing and injecting frames needs the CAP_NET_RAW capability.
+	 *
+	 * Usage example:
+	 * \code
+	 * PacketRingSocket socket("eth0");
+	 * PacketRingSocket::FrameIterator frames;
+	 * PacketRingSocket::Frame frame;
+	 * while( socket.receiveBlock( frames, 1000))
+	 *   while( frames.next(frame))
+	 *     process( frame.data, frame.len);
+	 * \endcode
+	 */
+	class PacketRingSocket : public SimpleSocket
+	{
+	public:
+		enum FanoutMode
+		{
+			FANOUT_HASH = PACKET_FANOUT_HASH,     ///< select the socket by the flow hash
+			FANOUT_LB = PACKET_FANOUT_LB,         ///< select the sockets round robin
+			FANOUT_CPU = PACKET_FANOUT_CPU,       ///< select the socket by the receiving CPU
+			FANOUT_ROLLOVER = PACKET_FANOUT_ROLLOVER, ///< fill one socket before moving to the next
+			FANOUT_RANDOM = PACKET_FANOUT_RND,    ///< select the socket randomly
+			FANOUT_QUEUE = PACKET_FANOUT_QM       ///< select the socket by the receive queue of the NIC
+		};
+
+		//! A captured frame, pointing into the receive ring
+		struct Frame
+		{
+			const uint8_t* data; ///< start of the link layer header
+			size_t len;          ///< number of captured bytes
+			size_t wireLen;      ///< original length of the frame
+			uint32_t sec;        ///< receive timestamp, seconds
+			uint32_t nsec;       ///< receive timestamp, nanoseconds
+			uint8_t type;        ///< direction of the frame, e.g. PACKET_HOST or PACKET_OUTGOING
+		};
+
+		//! Iterates over the frames of one received block
+		/*!
+		 * The frames stay valid until the next call to receiveBlock() or
+		 * releaseBlock(), which return the block to the kernel.
+		 */
+		class FrameIterator
+		{
+		public:
+			FrameIterator();
+
+			/*!
+			 * Fetch the next frame of the block.
+			 * \param frame set to the next frame
+			 * \return false if there are no frames left
+			 */
+			bool next( Frame& frame);
+
+			//! return the number of frames within the block
+			unsigned size() const { return m_count; }
+
+		private:
+			friend class PacketRingSocket;
+
+			const uint8_t* m_next;
+			unsigned m_count;
+			unsigned m_remaining;
+		};
+
+		//! Counters of the kernel, reset by every call to statistics()
+		struct Statistics
+		{
+			unsigned packets; ///< frames received
+			unsigned drops;   ///< frames dropped because the ring was full
+			unsigned freezes; ///< times the ring was completely full
+		};
+
+		/*!
+		 * Construct a packet socket bound to the given interface and
+		 * set up both rings.
+		 *
+		 * The receive ring consists of blockCount blocks of blockSize bytes.
+		 * blockSize has to be a multiple of the page size. The transmit ring
+		 * holds txFrames frames of frameSize bytes, including a header of
+		 * 48 bytes. frameSize has to divide blockSize.
+		 *
+		 * \param interface network interface to capture on, empty for all interfaces
+		 * \param blockSize size of a receive block in bytes
+		 * \param blockCount number of receive blocks
+		 * \param frameSize size of a transmit frame slot in bytes
+		 * \param txFrames number of transmit frames, 0 disables the transmit ring
+		 * \exception SocketException thrown if unable to create the socket or the rings
+		 */
+		explicit PacketRingSocket( const std::string& interface, unsigned blockSize = 1 << 18,
+		                           unsigned blockCount = 16, unsigned frameSize = 2048, unsigned txFrames = 256);
+
+		//! unmaps the rings
+		~PacketRingSocket();
+
+		/*!
+		 * Wait for the next filled block of the receive ring. The block
+		 * returned by the previous call is released first.
+		 *
+		 * \param frames iterator over the frames of the block
+		 * \param timeout timeout in milliseconds, -1 to wait forever
+		 * \return false if no block was filled before the timeout
+		 * \exception SocketException thrown if waiting failed
+		 */
+		bool receiveBlock( FrameIterator& frames, int timeout);
+
+		//! return the current block to the kernel
+		/*!
+		 * All frames of the block become invalid.
+		 */
+		void releaseBlock();
+
+		/*!
+		 * Copy a complete link layer frame into the next free slot of the
+		 * transmit ring. The frame is not sent before flush() is called.
+		 *
+		 * \param frame link layer frame to send
+		 * \param len length of the frame
+		 * \return false if the transmit ring is full
+		 * \exception SocketException thrown if the frame does not fit into a slot
+		 */
+		bool queueFrame( const void* frame, size_t len);
+
+		/*!
+		 * Send all frames queued by queueFrame() with one system call.
+		 * Blocks until all frames were handed to the network device.
+		 *
+		 * \return number of bytes sent
+		 * \exception SocketException thrown if sending failed
+		 */
+		int flush();
+
+		/*!
+		 * Join a fanout group. All packet sockets of the same group share
+		 * the captured frames, each frame is delivered to only one of them
+		 * as selected by the mode. All sockets of a group must be bound to
+		 * the same interface and use the same mode.
+		 *
+		 * \param groupId id of the fanout group
+		 * \param mode how frames are distributed
+		 * \exception SocketException thrown if unable to join the group
+		 */
+		void setFanout( uint16_t groupId, FanoutMode mode);
+
+		/*!
+		 * Do not capture frames sent by this host. By default a packet
+		 * socket receives outgoing frames as well as incoming ones, on the
+		 * loopback interface every frame is captured twice.
+		 *
+		 * The option does not apply to sockets within a fanout group, use
+		 * Frame::type to tell both directions apart in that case.
+		 *
+		 * \param enable true to capture only incoming frames
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setIgnoreOutgoing( bool enable);
+
+		//! return and reset the kernel counters
+		/*!
+		 * \exception SocketException thrown if unable to fetch the counters
+		 */
+		Statistics statistics();
+
+	private:
+		void setupRings( unsigned blockSize, unsigned blockCount, unsigned frameSize, unsigned txFrames);
+
+		uint8_t* m_map;
+		size_t m_mapSize;
+
+		uint8_t* m_rxRing;
+		unsigned m_blockSize;
+		unsigned m_blockCount;
+		unsigned m_currentBlock;
+		bool m_blockPending;
+
+		uint8_t* m_txRing;
+		unsigned m_frameSize;
+		unsigned m_txFrames;
+		unsigned m_currentFrame;
+	};
+
+} // namespace NET
+
+#endif // NET_PacketRingSocket_h__
@@ -0,0 +1,260 @@
+#include "SCTPMessageReader.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+using namespace NET;
+
+namespace {
+
+// number of messages over which the peak size is taken
+const unsigned SIZE_WINDOW = 64;
+
+size_t roundUpPowerOfTwo( size_t size)
+{
+	size_t ret = 1;
+	while( ret < size)
+		ret <<= 1;
+	return ret;
+}
+
+} // namespace
+
+//! Free buffers and the statistics about the message sizes
+class SCTPMessageReader::Pool
+{
+public:
+	Pool( size_t initialSize, size_t maxPooled)
+	: m_initialSize(initialSize)
+	, m_maxPooled(maxPooled)
+	, m_count(0)
+	, m_windowPeak(0)
+	, m_lastPeak(0)
+	{}
+
+	std::vector<uint8_t> acquire()
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		if( m_free.empty())
+			return std::vector<uint8_t>( target());
+
+		std::vector<uint8_t> ret( std::move( m_free.back()));
+		m_free.pop_back();
+		return ret;
+	}
+
+	void release( std::vector<uint8_t>& buffer)
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		if( m_free.size() >= m_maxPooled)
+			return;
+
+		// a buffer grown for a message much larger than the recent ones is shrunk again
+		size_t size = target();
+		if( buffer.size() > 2 * size)
+			std::vector<uint8_t>( size).swap( buffer);
+
+		m_free.push_back( std::move( buffer));
+	}
+
+	void record( size_t size)
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		m_windowPeak = std::max( m_windowPeak, size);
+		if( ++m_count == SIZE_WINDOW)
+		{
+			m_lastPeak = m_windowPeak;
+			m_windowPeak = 0;
+			m_count = 0;
+		}
+	}
+
+	size_t bufferSize() const
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		return target();
+	}
+
+	size_t pooled() const
+	{
+		std::lock_guard<std::mutex> lock( m_mutex);
+		return m_free.size();
+	}
+
+private:
+	// the peak of the current and the last window, so a new window does not shrink at once
+	size_t target() const
+	{
+		return roundUpPowerOfTwo( std::max( m_initialSize, std::max( m_windowPeak, m_lastPeak)));
+	}
+
+	mutable std::mutex m_mutex;
+	std::vector<std::vector<uint8_t>> m_free;
+	size_t m_initialSize;
+	size_t m_maxPooled;
+
+	unsigned m_count;
+	size_t m_windowPeak;
+	size_t m_lastPeak;
+};
+
+SCTPMessageReader::Message::Message()
+: m_size(0)
+, m_stream(0)
+, m_ppid(0)
+, m_flags(SCTPSocket::NO_FLAGS)
+{}
+
+SCTPMessageReader::Message::Message( Message&& other)
+: m_buffer( std::move( other.m_buffer))
+, m_size( other.m_size)
+, m_stream( other.m_stream)
+, m_ppid( other.m_ppid)
+, m_flags( other.m_flags)
+, m_pool( std::move( other.m_pool))
+{
+	other.m_size = 0;
+}
+
+SCTPMessageReader::Message& SCTPMessageReader::Message::operator=( Message&& other)
+{
+	if( this != &other)
+	{
+		release();
+		m_buffer = std::move( other.m_buffer);
+		m_size = other.m_size;
+		m_stream = other.m_stream;
+		m_ppid = other.m_ppid;
+		m_flags = other.m_flags;
+		m_pool = std::move( other.m_pool);
+		other.m_size = 0;
+	}
+	return *this;
+}
+
+SCTPMessageReader::Message::~Message()
+{
+	release();
+}
+
+void SCTPMessageReader::Message::release()
+{
+	if( m_pool)
+		m_pool->release( m_buffer);
+
+	m_buffer.clear();
+	m_pool.reset();
+	m_size = 0;
+}
+
+SCTPMessageReader::SCTPMessageReader( SCTPSocket& socket, size_t initialSize /* = 4096 */, size_t maxPooled /* = 16 */)
+: m_socket(socket)
+, m_pool( std::make_shared<Pool>( std::max( initialSize, size_t(1)), maxPooled))
+{
+	// stream and ppid of a message are passed along as SCTP_RCVINFO
+	int enable = 1;
+	if( setsockopt( socket.nativeHandle(), IPPROTO_SCTP, SCTP_RECVRCVINFO, &enable, sizeof(enable)) < 0)
+		throw SocketException("Enable receive info failed (setsockopt)");
+}
+
+bool SCTPMessageReader::receive( Message& message, int timeout /* = -1 */)
+{
+	message.release();
+
+	// the message owns the buffer from now on, so it returns to the pool on errors
+	message.m_buffer = m_pool->acquire();
+	message.m_pool = m_pool;
+
+	int socket = m_socket.nativeHandle();
+	std::vector<uint8_t>& buffer = message.m_buffer;
+	char control[CMSG_SPACE(sizeof(sctp_rcvinfo))];
+	size_t size = 0;
+
+	for(;;)
+	{
+		if( size == 0 && timeout >= 0)
+		{
+			struct pollfd poll;
+			poll.fd = socket;
+			poll.events = POLLIN;
+
+			int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+			if( ret < 0)
+				throw SocketException("SCTPMessageReader::receive failed (poll)");
+			if( ret == 0)
+			{
+				message.release();
+				return false;
+			}
+		}
+
+		if( size == buffer.size())
+			buffer.resize( buffer.size() * 2);
+
+		struct iovec iov;
+		iov.iov_base = buffer.data() + size;
+		iov.iov_len = buffer.size() - size;
+
+		struct msghdr msg;
+		std::memset( &msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		int ret = TEMP_FAILURE_RETRY (::recvmsg( socket, &msg, 0));
+		if( ret < 0)
+			throw SocketException("SCTPMessageReader::receive failed (recvmsg)");
+		if( ret == 0)
+		{
+			message.release();
+			return false;
+		}
+
+		// notifications are overwritten by the next part
+		if( msg.msg_flags & MSG_NOTIFICATION)
+			continue;
+
+		if( size == 0)
+		{
+			message.m_stream = 0;
+			message.m_ppid = 0;
+			message.m_flags = SCTPSocket::NO_FLAGS;
+
+			for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+			{
+				if( cmsg->cmsg_level == IPPROTO_SCTP && cmsg->cmsg_type == SCTP_RCVINFO)
+				{
+					sctp_rcvinfo info;
+					std::memcpy( &info, CMSG_DATA(cmsg), sizeof(info));
+					message.m_stream = info.rcv_sid;
+					message.m_ppid = info.rcv_ppid;
+					if( info.rcv_flags & SCTP_UNORDERED)
+						message.m_flags = SCTPSocket::UNORDERED;
+				}
+			}
+		}
+
+		size += static_cast<size_t>(ret);
+		if( msg.msg_flags & MSG_EOR)
+			break;
+	}
+
+	m_pool->record( size);
+	message.m_size = size;
+	return true;
+}
+
+size_t SCTPMessageReader::bufferSize() const
+{
+	return m_pool->bufferSize();
+}
+
+size_t SCTPMessageReader::pooled() const
+{
+	return m_pool->pooled();
+}
@@ -0,0 +1,123 @@
+#ifndef NET_SCTPMessageReader_h__
+#define NET_SCTPMessageReader_h__
+
+#include "SCTPSocket.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace NET
+{
+	//! Receives complete SCTP messages of any size
+	/*!
+	 * A message larger than the receive buffer of the socket is handed to
+	 * the user in several parts by partial delivery, and a message larger
+	 * than the buffer passed to SCTPSocket::receive() is truncated into
+	 * parts as well. SCTPMessageReader reads all parts up to the end of
+	 * the message (MSG_EOR) into one buffer, which grows as needed.
+	 *
+	 * Buffers are taken from a pool and return to it when the Message is
+	 * destroyed, so no allocation takes place once the pool is warmed up.
+	 * The reader keeps track of the message sizes it sees. Buffers that
+	 * grew for a burst of large messages are shrunk again when they are
+	 * returned after the sizes went down.
+	 *
+	 * Messages may be kept and released from any thread, receiving must
+	 * only be done by one thread at a time. Notifications are dropped.
+	 *
+	 * Usage example:
+	 * \code
+	 * SCTPMessageReader reader(socket);
+	 * SCTPMessageReader::Message message;
+	 * while( reader.receive( message))
+	 *   process( message.stream(), message.data(), message.size());
+	 * \endcode
+	 */
+	class SCTPMessageReader
+	{
+		class Pool;
+
+	public:
+		//! A complete message, owning a buffer of the pool
+		class Message
+		{
+		public:
+			Message();
+			Message( Message&& other);
+			Message& operator=( Message&& other);
+
+			//! returns the buffer to the pool
+			~Message();
+
+			//! return the content of the message
+			const uint8_t* data() const { return m_buffer.data(); }
+
+			//! return the length of the message
+			size_t size() const { return m_size; }
+
+			//! return the stream the message was received on
+			uint16_t stream() const { return m_stream; }
+
+			//! return the payload protocol identifier
+			unsigned ppid() const { return m_ppid; }
+
+			//! return SCTPSocket::UNORDERED or SCTPSocket::NO_FLAGS
+			SCTPSocket::receiveFlag flags() const { return m_flags; }
+
+			//! return the buffer to the pool, the message becomes empty
+			void release();
+
+		private:
+			friend class SCTPMessageReader;
+
+			// dont' allow
+			Message( const Message&);
+			const Message& operator=( const Message&);
+
+			std::vector<uint8_t> m_buffer;
+			size_t m_size;
+			uint16_t m_stream;
+			unsigned m_ppid;
+			SCTPSocket::receiveFlag m_flags;
+			std::shared_ptr<Pool> m_pool;
+		};
+
+		/*!
+		 * Start to read from the given socket, which must outlive the reader.
+		 * \param socket socket to receive from
+		 * \param initialSize size of new buffers and lower limit for shrinking
+		 * \param maxPooled number of free buffers kept by the pool
+		 * \exception SocketException thrown if unable to enable receive information
+		 */
+		explicit SCTPMessageReader( SCTPSocket& socket, size_t initialSize = 4096, size_t maxPooled = 16);
+
+		/*!
+		 * Receive the next complete message. The previous content of
+		 * message is released first.
+		 *
+		 * \param message set to the received message
+		 * \param timeout timeout in milliseconds for the first part, -1 to wait forever
+		 * \return false on timeout or if the peer shut the association down
+		 * \exception SocketException thrown if unable to receive
+		 */
+		bool receive( Message& message, int timeout = -1);
+
+		//! return the size buffers are currently shrunk to
+		size_t bufferSize() const;
+
+		//! return the number of free buffers within the pool
+		size_t pooled() const;
+
+	private:
+		// dont' allow
+		SCTPMessageReader( const SCTPMessageReader&);
+		const SCTPMessageReader& operator=( const SCTPMessageReader&);
+
+		SCTPSocket& m_socket;
+		std::shared_ptr<Pool> m_pool;
+	};
+
+} // namespace NET
+
+#endif // NET_SCTPMessageReader_h__
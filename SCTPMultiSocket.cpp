@@ -0,0 +1,201 @@
+#include "SCTPMultiSocket.h"
+#include "TempFailure.h"
+
+#include <netinet/in.h>
+#include <poll.h>
+#include <cstring>
+
+using namespace NET;
+
+SCTPMultiSocket::SCTPMultiSocket( uint16_t numOutStreams /* = 10 */,
+                                  uint16_t maxInStreams /* = 65535 */,
+                                  uint16_t maxAttempts /* = 4 */,
+                                  uint16_t maxInitTimeout /* = 0 */)
+: InternetSocket( SOCK_SEQPACKET, IPPROTO_SCTP)
+{
+	struct sctp_initmsg init;
+	init.sinit_num_ostreams = numOutStreams;
+	init.sinit_max_instreams = maxInStreams;
+	init.sinit_max_attempts = maxAttempts;
+	init.sinit_max_init_timeo = maxInitTimeout;
+
+	if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_INITMSG, &init, sizeof(init)) < 0)
+		throw SocketException("SCTPMultiSocket construction failed (setsockopt)");
+
+	// the association of a message is passed along as SCTP_RCVINFO
+	int enable = 1;
+	if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_RECVRCVINFO, &enable, sizeof(enable)) < 0)
+		throw SocketException("SCTPMultiSocket construction failed (setsockopt)");
+}
+
+int SCTPMultiSocket::bind( const std::vector<std::string>& localAddresses, unsigned short localPort /* = 0 */)
+{
+	size_t size = localAddresses.size();
+	std::vector<sockaddr_in> dest(size);
+
+	for( size_t i = 0; i < size; ++i)
+		fillAddress( localAddresses[i], localPort, dest[i]);
+
+	int ret = sctp_bindx( m_socket, reinterpret_cast<sockaddr*>(dest.data()), static_cast<int>(size), SCTP_BINDX_ADD_ADDR);
+	if(ret < 0)
+		throw SocketException("Set of local address and port failed (sctp_bindx)");
+	return ret;
+}
+
+void SCTPMultiSocket::listen( int backlog /* = 5 */)
+{
+	if( ::listen( m_socket, backlog) < 0)
+		throw SocketException("SCTPMultiSocket::listen failed (listen)");
+}
+
+SCTPMultiSocket::AssociationId SCTPMultiSocket::connect( const std::string& foreignAddress, unsigned short foreignPort)
+{
+	return connect( std::vector<std::string>( 1, foreignAddress), foreignPort);
+}
+
+SCTPMultiSocket::AssociationId SCTPMultiSocket::connect( const std::vector<std::string>& foreignAddresses, unsigned short foreignPort)
+{
+	size_t size = foreignAddresses.size();
+	std::vector<sockaddr_in> dest(size);
+
+	for( size_t i = 0; i < size; ++i)
+		fillAddress( foreignAddresses[i], foreignPort, dest[i]);
+
+	AssociationId assoc = 0;
+	if( sctp_connectx( m_socket, reinterpret_cast<sockaddr*>(dest.data()), static_cast<int>(size), &assoc) < 0)
+		throw SocketException("Connect failed (sctp_connectx)");
+
+	return assoc;
+}
+
+int SCTPMultiSocket::send( const void* data, size_t length, AssociationId assoc, uint16_t stream, unsigned ttl /* = 0 */,
+                           unsigned context /* = 0 */, unsigned ppid /* = 0 */,
+                           SCTPSocket::abortFlag abort /* = SCTPSocket::KEEPALIVE */)
+{
+	struct sctp_sndrcvinfo info;
+	std::memset( &info, 0, sizeof(info));
+	info.sinfo_stream = stream;
+	info.sinfo_flags = static_cast<uint16_t>(abort);
+	info.sinfo_ppid = ppid;
+	info.sinfo_context = context;
+	info.sinfo_timetolive = ttl;
+	info.sinfo_assoc_id = assoc;
+
+	int ret = sctp_send( m_socket, data, length, &info, 0);
+	if( ret < 0)
+		throw SocketException("SCTPMultiSocket::send failed (sctp_send)");
+	return ret;
+}
+
+int SCTPMultiSocket::receive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream)
+{
+	SCTPSocket::receiveFlag flag;
+	return receive( data, maxLen, assoc, stream, flag);
+}
+
+int SCTPMultiSocket::receive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream,
+                              SCTPSocket::receiveFlag& flag)
+{
+	char control[CMSG_SPACE(sizeof(sctp_rcvinfo))];
+
+	struct iovec iov;
+	iov.iov_base = data;
+	iov.iov_len = maxLen;
+
+	for(;;)
+	{
+		struct msghdr msg;
+		std::memset( &msg, 0, sizeof(msg));
+		msg.msg_iov = &iov;
+		msg.msg_iovlen = 1;
+		msg.msg_control = control;
+		msg.msg_controllen = sizeof(control);
+
+		int ret = TEMP_FAILURE_RETRY (::recvmsg( m_socket, &msg, 0));
+		if( ret < 0)
+			throw SocketException("SCTPMultiSocket::receive failed (recvmsg)");
+
+		// notifications are not passed to the user
+		if( msg.msg_flags & MSG_NOTIFICATION)
+			continue;
+
+		assoc = 0;
+		stream = 0;
+		unsigned flags = (msg.msg_flags & MSG_EOR) ? 0 : SCTPSocket::INCOMPLETE;
+		for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+		{
+			if( cmsg->cmsg_level == IPPROTO_SCTP && cmsg->cmsg_type == SCTP_RCVINFO)
+			{
+				sctp_rcvinfo info;
+				std::memcpy( &info, CMSG_DATA(cmsg), sizeof(info));
+				assoc = info.rcv_assoc_id;
+				stream = info.rcv_sid;
+				flags |= info.rcv_flags & SCTPSocket::UNORDERED;
+			}
+		}
+		flag = static_cast<SCTPSocket::receiveFlag>(flags);
+		return ret;
+	}
+}
+
+int SCTPMultiSocket::timedReceive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream, int timeout)
+{
+	SCTPSocket::receiveFlag flag;
+	return timedReceive( data, maxLen, assoc, stream, flag, timeout);
+}
+
+int SCTPMultiSocket::timedReceive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream,
+                                   SCTPSocket::receiveFlag& flag, int timeout)
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN | POLLPRI;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return 0;
+	if( ret < 0) throw SocketException("SCTPMultiSocket::timedReceive failed (poll)");
+
+	if( poll.revents & POLLIN || poll.revents & POLLPRI)
+		return receive( data, maxLen, assoc, stream, flag);
+
+	return 0;
+}
+
+SCTPSocket::Handle SCTPMultiSocket::peelOff( AssociationId assoc)
+{
+	int ret = sctp_peeloff( m_socket, assoc);
+	if( ret < 0)
+		throw SocketException("SCTPMultiSocket::peelOff failed (sctp_peeloff)");
+	return SCTPSocket::Handle(ret);
+}
+
+void SCTPMultiSocket::setAutoClose( unsigned seconds)
+{
+	int value = static_cast<int>(seconds);
+	if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_AUTOCLOSE, &value, sizeof(value)) < 0)
+		throw SocketException("SCTPMultiSocket::setAutoClose failed (setsockopt)");
+}
+
+std::vector<SCTPMultiSocket::AssociationId> SCTPMultiSocket::associations() const
+{
+	// the number of associations may change between both calls
+	for(;;)
+	{
+		uint32_t count = 0;
+		socklen_t size = sizeof(count);
+		if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_GET_ASSOC_NUMBER, &count, &size) < 0)
+			throw SocketException("SCTPMultiSocket::associations failed (getsockopt)");
+
+		std::vector<uint8_t> buffer( sizeof(sctp_assoc_ids) + (count + 1) * sizeof(sctp_assoc_t));
+		size = static_cast<socklen_t>(buffer.size());
+		if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_GET_ASSOC_ID_LIST, buffer.data(), &size) < 0)
+		{
+			if( errno == EINVAL) continue;
+			throw SocketException("SCTPMultiSocket::associations failed (getsockopt)");
+		}
+
+		const sctp_assoc_ids* ids = reinterpret_cast<const sctp_assoc_ids*>(buffer.data());
+		return std::vector<AssociationId>( ids->gaids_assoc_id, ids->gaids_assoc_id + ids->gaids_number_of_ids);
+	}
+}
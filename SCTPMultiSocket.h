@@ -0,0 +1,160 @@
+#ifndef NET_SCTPMultiSocket_h__
+#define NET_SCTPMultiSocket_h__
+
+#include "SCTPSocket.h"
+
+#include <vector>
+#include <string>
+
+namespace NET
+{
+	//! SCTP one-to-many socket class
+	/*!
+	 * SCTPMultiSocket (SOCK_SEQPACKET) carries any number of SCTP
+	 * associations on one file descriptor. Associations are set up
+	 * implicitly by peers connecting to a listening socket or explicitly
+	 * by connect(), there is no accept(). Every message is addressed by
+	 * the id of its association.
+	 *
+	 * A busy association can be moved to its own one-to-one SCTPSocket
+	 * with peelOff(). Idle associations are closed automatically after
+	 * setAutoClose().
+	 *
+	 * Usage example:
+	 * \code
+	 * SCTPMultiSocket socket;
+	 * socket.bind(2905);
+	 * socket.listen();
+	 * SCTPMultiSocket::AssociationId assoc;
+	 * uint16_t stream;
+	 * int len = socket.receive( buffer, sizeof(buffer), assoc, stream);
+	 * socket.send( buffer, len, assoc, stream);
+	 * \endcode
+	 */
+	class SCTPMultiSocket : public InternetSocket
+	{
+	public:
+		//! identifies an association of the socket
+		typedef sctp_assoc_t AssociationId;
+
+		/*!
+		 * Construct a one-to-many socket. The parameters apply to every
+		 * association set up by the socket.
+		 *
+		 * \param numOutStreams number of outgoing streams requested
+		 * \param maxInStreams maximum number of incoming streams accepted
+		 * \param maxAttempts maximum number of retransmissions of INIT
+		 * \param maxInitTimeout maximum retransmission timeout of INIT in milliseconds, 0 for the default
+		 * \exception SocketException thrown if unable to create the socket or to set the parameters
+		 */
+		SCTPMultiSocket( uint16_t numOutStreams = 10, uint16_t maxInStreams = 65535, uint16_t maxAttempts = 4,
+		                 uint16_t maxInitTimeout = 0);
+
+		using InternetSocket::bind;
+		int bind( const std::vector<std::string>& localAddresses, unsigned short localPort = 0);
+
+		//! accept associations set up by peers
+		/*!
+		 * \param backlog maximum number of associations being set up at the same time
+		 * \exception SocketException thrown if unable to listen
+		 */
+		void listen( int backlog = 5);
+
+		/*!
+		 * Set up an association with the given peer. Blocks until the
+		 * association is established.
+		 * \param foreignAddress foreign address (IP address or name)
+		 * \param foreignPort foreign port
+		 * \return id of the new association
+		 * \exception SocketException thrown if unable to establish the association
+		 */
+		AssociationId connect( const std::string& foreignAddress, unsigned short foreignPort);
+
+		/*!
+		 * Set up an association with a multi-homed peer.
+		 * \param foreignAddresses addresses of the peer
+		 * \param foreignPort foreign port
+		 * \return id of the new association
+		 * \exception SocketException thrown if unable to establish the association
+		 */
+		AssociationId connect( const std::vector<std::string>& foreignAddresses, unsigned short foreignPort);
+
+		/*!
+		 * Send a message on one association.
+		 * \param data message to send
+		 * \param length length of the message
+		 * \param assoc association to send on
+		 * \param stream stream of the association
+		 * \param ttl time to live in milliseconds, 0 for no limit
+		 * \param context value reported if sending fails
+		 * \param ppid payload protocol identifier
+		 * \param abort ABORT or SHUTDOWN end the association instead of sending
+		 * \return number of bytes sent
+		 * \exception SocketException thrown if unable to send
+		 */
+		int send( const void* data, size_t length, AssociationId assoc, uint16_t stream, unsigned ttl = 0,
+		          unsigned context = 0, unsigned ppid = 0, SCTPSocket::abortFlag abort = SCTPSocket::KEEPALIVE);
+
+		/*!
+		 * Receive the next message of any association. A message larger
+		 * than the buffer is received in several parts, use the variant
+		 * with flag to tell them apart.
+		 * \param data buffer to receive the message
+		 * \param maxLen size of the buffer
+		 * \param assoc set to the association the message was received on
+		 * \param stream set to the stream the message was received on
+		 * \return number of bytes received
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int receive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream);
+
+		/*!
+		 * Receive the next message of any association like receive().
+		 * \param flag set to INCOMPLETE if the rest of the message follows, and to UNORDERED
+		 *             for a message sent unordered
+		 * \return number of bytes received
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int receive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream, SCTPSocket::receiveFlag& flag);
+
+		/*!
+		 * Receive the next message of any association like receive().
+		 * \return number of bytes received, 0 on timeout
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int timedReceive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream, int timeout);
+
+		/*!
+		 * Receive the next message of any association like receive() with flag.
+		 * \return number of bytes received, 0 on timeout
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int timedReceive( void* data, size_t maxLen, AssociationId& assoc, uint16_t& stream,
+		                  SCTPSocket::receiveFlag& flag, int timeout);
+
+		/*!
+		 * Move an association to a new one-to-one socket. Messages of the
+		 * association are no longer received by this socket.
+		 * \param assoc association to move
+		 * \return handle to construct an SCTPSocket from
+		 * \exception SocketException thrown if there is no such association
+		 */
+		SCTPSocket::Handle peelOff( AssociationId assoc);
+
+		/*!
+		 * Close associations automatically after a time without traffic.
+		 * \param seconds idle time, 0 to never close associations
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setAutoClose( unsigned seconds);
+
+		//! return the ids of all associations of the socket
+		/*!
+		 * \exception SocketException thrown if unable to fetch the ids
+		 */
+		std::vector<AssociationId> associations() const;
+	};
+
+} // namespace NET
+
+#endif // NET_SCTPMultiSocket_h__
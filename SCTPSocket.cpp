@@ -3,10 +3,101 @@
 
 #include <vector>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <poll.h>
+#include <cstring>
+#include <algorithm>
 
 using namespace NET;
 
+namespace {
+
+// number of messages passed to one sendmmsg() call
+const unsigned BATCH_SIZE = 64;
+
+std::string addressToString( const sockaddr_storage& addr, unsigned short& port)
+{
+	char buffer[INET6_ADDRSTRLEN];
+
+	if( addr.ss_family == AF_INET)
+	{
+		const sockaddr_in* in = reinterpret_cast<const sockaddr_in*>(&addr);
+		port = ntohs( in->sin_port);
+		return inet_ntop( AF_INET, &in->sin_addr, buffer, sizeof(buffer));
+	}
+	if( addr.ss_family == AF_INET6)
+	{
+		const sockaddr_in6* in6 = reinterpret_cast<const sockaddr_in6*>(&addr);
+		port = ntohs( in6->sin6_port);
+		return inet_ntop( AF_INET6, &in6->sin6_addr, buffer, sizeof(buffer));
+	}
+
+	port = 0;
+	return std::string();
+}
+
+// copies a notification of the given type, a truncated one is padded with zeros
+template<typename T>
+T readNotification( const uint8_t* data, size_t len)
+{
+	T ret;
+	std::memset( &ret, 0, sizeof(ret));
+	std::memcpy( &ret, data, std::min( len, sizeof(ret)));
+	return ret;
+}
+
+void parseNotification( const uint8_t* data, size_t len, SCTPSocket::Notification& notification)
+{
+	notification.state = 0;
+	notification.error = 0;
+	notification.address.clear();
+	notification.port = 0;
+	notification.stream = 0;
+	notification.context = 0;
+
+	// every notification starts with its 16 bit type
+	uint16_t type = readNotification<uint16_t>( data, len);
+	switch( type)
+	{
+	case SCTP_ASSOC_CHANGE:
+	{
+		sctp_assoc_change change = readNotification<sctp_assoc_change>( data, len);
+		notification.type = SCTPSocket::Notification::ASSOCIATION_CHANGE;
+		notification.state = change.sac_state;
+		notification.error = change.sac_error;
+		break;
+	}
+	case SCTP_PEER_ADDR_CHANGE:
+	{
+		sctp_paddr_change change = readNotification<sctp_paddr_change>( data, len);
+		notification.type = SCTPSocket::Notification::PEER_ADDRESS_CHANGE;
+		notification.state = change.spc_state;
+		notification.error = change.spc_error;
+		notification.address = addressToString( change.spc_aaddr, notification.port);
+		break;
+	}
+	case SCTP_SEND_FAILED_EVENT:
+	{
+		sctp_send_failed_event failed = readNotification<sctp_send_failed_event>( data, len);
+		notification.type = SCTPSocket::Notification::SEND_FAILED;
+		notification.state = failed.ssf_flags;
+		notification.error = static_cast<int>(failed.ssf_error);
+		notification.stream = failed.ssfe_info.snd_sid;
+		notification.context = failed.ssfe_info.snd_context;
+		break;
+	}
+	case SCTP_SHUTDOWN_EVENT:
+		notification.type = SCTPSocket::Notification::PEER_SHUTDOWN;
+		break;
+	default:
+		// not subscribed by subscribe(), reported as no notification
+		notification.type = SCTPSocket::Notification::NONE;
+		break;
+	}
+}
+
+} // namespace
+
 SCTPSocket::SCTPSocket( uint16_t numOutStreams /* = 10 */,
                         uint16_t maxInStreams /* = 65535 */,
                         uint16_t maxAttempts /* = 4 */,
@@ -51,63 +142,135 @@ int SCTPSocket::connect( const std::vector<std::string>& foreignAddresses, unsig
 	return ret;
 }
 
-int SCTPSocket::state() const
+SCTPSocket::Status SCTPSocket::status() const
 {
 	struct sctp_status status;
 	socklen_t size = sizeof(status);
+	std::memset( &status, 0, sizeof(status));
 	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::state failed (getsockopt)");
-	return status.sstat_state;
+		throw SocketException("SCTPSocket::status failed (getsockopt)");
+
+	Status ret;
+	ret.state = status.sstat_state;
+	ret.notAckedData = status.sstat_unackdata;
+	ret.pendingData = status.sstat_penddata;
+	ret.inStreams = status.sstat_instrms;
+	ret.outStreams = status.sstat_outstrms;
+	ret.fragmentationPoint = status.sstat_fragmentation_point;
+
+	const sctp_paddrinfo& primary = status.sstat_primary;
+	ret.primary.address = addressToString( primary.spinfo_address, ret.primary.port);
+	ret.primary.state = primary.spinfo_state;
+	ret.primary.cwnd = primary.spinfo_cwnd;
+	ret.primary.srtt = primary.spinfo_srtt;
+	ret.primary.rto = primary.spinfo_rto;
+	ret.primary.mtu = primary.spinfo_mtu;
+	return ret;
+}
+
+int SCTPSocket::state() const
+{
+	return status().state;
 }
 
 int SCTPSocket::notAckedData() const
 {
-	struct sctp_status status;
-	socklen_t size = sizeof(status);
-	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::notAckedData failed (getsockopt)");
-	return status.sstat_unackdata;
+	return status().notAckedData;
 }
 
 int SCTPSocket::pendingData() const
 {
-	struct sctp_status status;
-	socklen_t size = sizeof(status);
-	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::pendingData failed (getsockopt)");
-	return status.sstat_penddata;
+	return status().pendingData;
 }
 
 unsigned SCTPSocket::inStreams() const
 {
-	struct sctp_status status;
-	socklen_t size = sizeof(status);
-	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::inStreams failed (getsockopt)");
-	return status.sstat_instrms;
+	return status().inStreams;
 }
 
 unsigned SCTPSocket::outStreams() const
 {
-	struct sctp_status status;
-	socklen_t size = sizeof(status);
-	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::outStreams failed (getsockopt)");
-	return status.sstat_outstrms;
+	return status().outStreams;
 }
 
 unsigned SCTPSocket::fragmentationPoint() const
 {
-	struct sctp_status status;
-	socklen_t size = sizeof(status);
-	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STATUS, &status, &size) < 0)
-		throw SocketException("SCTPSocket::fragmentationPoint failed (getsockopt)");
-	return status.sstat_fragmentation_point;
+	return status().fragmentationPoint;
 }
 
 std::string SCTPSocket::primaryAddress() const
 {
-	return std::string(); // TODO
+	return status().primary.address;
+}
+
+void SCTPSocket::subscribe( unsigned events)
+{
+	static const struct
+	{
+		eventFlag flag;
+		uint16_t type;
+	} EVENTS[] =
+	{
+		{ EVENT_ASSOCIATION_CHANGE, SCTP_ASSOC_CHANGE },
+		{ EVENT_PEER_ADDRESS_CHANGE, SCTP_PEER_ADDR_CHANGE },
+		{ EVENT_SEND_FAILED, SCTP_SEND_FAILED_EVENT },
+		{ EVENT_SHUTDOWN, SCTP_SHUTDOWN_EVENT }
+	};
+
+	for( size_t i = 0; i < sizeof(EVENTS) / sizeof(EVENTS[0]); ++i)
+	{
+		struct sctp_event event;
+		std::memset( &event, 0, sizeof(event));
+		event.se_type = EVENTS[i].type;
+		event.se_on = (events & static_cast<unsigned>(EVENTS[i].flag)) ? 1 : 0;
+
+		if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_EVENT, &event, sizeof(event)) < 0)
+			throw SocketException("SCTPSocket::subscribe failed (setsockopt)");
+	}
+}
+
+void SCTPSocket::setStreamScheduler( streamScheduler scheduler)
+{
+	struct sctp_assoc_value value;
+	std::memset( &value, 0, sizeof(value));
+	value.assoc_value = static_cast<uint32_t>(scheduler);
+
+	if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER, &value, sizeof(value)) < 0)
+		throw SocketException("SCTPSocket::setStreamScheduler failed (setsockopt)");
+}
+
+SCTPSocket::streamScheduler SCTPSocket::getStreamScheduler() const
+{
+	struct sctp_assoc_value value;
+	socklen_t size = sizeof(value);
+	std::memset( &value, 0, sizeof(value));
+
+	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER, &value, &size) < 0)
+		throw SocketException("SCTPSocket::getStreamScheduler failed (getsockopt)");
+	return static_cast<streamScheduler>(value.assoc_value);
+}
+
+void SCTPSocket::setStreamPriority( uint16_t stream, uint16_t priority)
+{
+	struct sctp_stream_value value;
+	std::memset( &value, 0, sizeof(value));
+	value.stream_id = stream;
+	value.stream_value = priority;
+
+	if( setsockopt( m_socket, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER_VALUE, &value, sizeof(value)) < 0)
+		throw SocketException("SCTPSocket::setStreamPriority failed (setsockopt)");
+}
+
+uint16_t SCTPSocket::getStreamPriority( uint16_t stream) const
+{
+	struct sctp_stream_value value;
+	socklen_t size = sizeof(value);
+	std::memset( &value, 0, sizeof(value));
+	value.stream_id = stream;
+
+	if( getsockopt( m_socket, IPPROTO_SCTP, SCTP_STREAM_SCHEDULER_VALUE, &value, &size) < 0)
+		throw SocketException("SCTPSocket::getStreamPriority failed (getsockopt)");
+	return value.stream_value;
 }
 
 int SCTPSocket::send( const void* data, size_t length, uint16_t stream, unsigned ttl /* = 0 */, unsigned context /* = 0 */,
@@ -133,12 +296,75 @@ int SCTPSocket::sendUnordered( const void* data, size_t length, uint16_t stream,
 	return ret;
 }
 
+size_t SCTPSocket::sendBatch( BatchMessage* messages, size_t count)
+{
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iovs[BATCH_SIZE];
+	char control[BATCH_SIZE][CMSG_SPACE(sizeof(sctp_sndinfo))];
+
+	size_t sent = 0;
+	size_t next = 0;
+	while( next < count)
+	{
+		unsigned batch = count - next < BATCH_SIZE ? static_cast<unsigned>(count - next) : BATCH_SIZE;
+
+		std::memset( msgs, 0, sizeof(mmsghdr) * batch);
+		std::memset( control, 0, sizeof(control[0]) * batch);
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			const BatchMessage& message = messages[next + i];
+			iovs[i].iov_base = const_cast<void*>(message.data);
+			iovs[i].iov_len = message.length;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_control = control[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+			cmsg->cmsg_level = IPPROTO_SCTP;
+			cmsg->cmsg_type = SCTP_SNDINFO;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(sctp_sndinfo));
+
+			sctp_sndinfo info;
+			std::memset( &info, 0, sizeof(info));
+			info.snd_sid = message.stream;
+			info.snd_flags = static_cast<uint16_t>(message.flags);
+			info.snd_ppid = message.ppid;
+			info.snd_context = message.context;
+			std::memcpy( CMSG_DATA(cmsg), &info, sizeof(info));
+		}
+
+		int ret = TEMP_FAILURE_RETRY (::sendmmsg( m_socket, msgs, batch, 0));
+		if( ret < 0)
+		{
+			// sendmmsg only reports the error of the first message of a call
+			int error = errno;
+			if( error == EAGAIN)
+			{
+				for( size_t i = next; i < count; ++i)
+					messages[i].result = -EAGAIN;
+				break;
+			}
+			if( error == ECONNRESET || error == ECONNREFUSED || error == EPIPE)
+				m_peerDisconnected = true;
+			messages[next++].result = -error;
+			continue;
+		}
+
+		for( int i = 0; i < ret; ++i)
+			messages[next + static_cast<size_t>(i)].result = static_cast<int>(msgs[i].msg_len);
+		sent += static_cast<size_t>(ret);
+		next += static_cast<size_t>(ret);
+	}
+
+	return sent;
+}
+
 int SCTPSocket::receive( void* data, size_t maxLen, uint16_t& stream)
 {
 	struct sctp_sndrcvinfo info;
-	int ret;
-	if( (ret = sctp_recvmsg( m_socket, data, maxLen, 0, 0, &info, 0)) < 0)
-		throw SocketException("SCTPSocket::receive failed (sctp_recvmsg)");
+	int flags;
+	int ret = receiveData( data, maxLen, info, flags);
 	stream = info.sinfo_stream;
 	return ret;
 }
@@ -146,14 +372,52 @@ int SCTPSocket::receive( void* data, size_t maxLen, uint16_t& stream)
 int SCTPSocket::receive( void* data, size_t maxLen, uint16_t& stream, receiveFlag& flag)
 {
 	struct sctp_sndrcvinfo info;
-	int ret;
-	if( (ret = sctp_recvmsg( m_socket, data, maxLen, 0, 0, &info, 0)) < 0)
-		throw SocketException("SCTPSocket::receive failed (sctp_recvmsg)");
+	int flags;
+	int ret = receiveData( data, maxLen, info, flags);
 	stream = info.sinfo_stream;
-	flag = static_cast<receiveFlag>(info.sinfo_flags);
+	flag = static_cast<receiveFlag>( (info.sinfo_flags & UNORDERED) | ((flags & MSG_EOR) ? 0 : INCOMPLETE));
 	return ret;
 }
 
+int SCTPSocket::receive( void* data, size_t maxLen, uint16_t& stream, Notification& notification)
+{
+	struct sctp_sndrcvinfo info;
+	std::memset( &info, 0, sizeof(info));
+	int flags = 0;
+	int ret;
+	if( (ret = sctp_recvmsg( m_socket, data, maxLen, 0, 0, &info, &flags)) < 0)
+		throw SocketException("SCTPSocket::receive failed (sctp_recvmsg)");
+
+	notification.type = Notification::NONE;
+	if( !(flags & MSG_NOTIFICATION))
+	{
+		stream = info.sinfo_stream;
+		return ret;
+	}
+
+	if( flags & MSG_EOR)
+	{
+		parseNotification( static_cast<const uint8_t*>(data), static_cast<size_t>(ret), notification);
+		return 0;
+	}
+
+	// the notification did not fit, the rest follows in further reads up to MSG_EOR
+	const uint8_t* begin = static_cast<const uint8_t*>(data);
+	std::vector<uint8_t> buffer( begin, begin + ret);
+	uint8_t chunk[256];
+	do
+	{
+		flags = 0;
+		if( (ret = sctp_recvmsg( m_socket, chunk, sizeof(chunk), 0, 0, &info, &flags)) < 0)
+			throw SocketException("SCTPSocket::receive failed (sctp_recvmsg)");
+		buffer.insert( buffer.end(), chunk, chunk + ret);
+	}
+	while( ret > 0 && !(flags & MSG_EOR));
+
+	parseNotification( buffer.data(), buffer.size(), notification);
+	return 0;
+}
+
 int SCTPSocket::timedReceive( void* data, size_t maxLen, uint16_t& stream, int timeout)
 {
 	struct pollfd poll;
@@ -194,6 +458,28 @@ int SCTPSocket::timedReceive( void* data, size_t maxLen, uint16_t& stream, recei
 	return 0;
 }
 
+int SCTPSocket::timedReceive( void* data, size_t maxLen, uint16_t& stream, Notification& notification, int timeout)
+{
+	notification.type = Notification::NONE;
+
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN | POLLPRI | POLLRDHUP;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return 0;
+	if( ret < 0) throw SocketException("SCTPSocket::timedReceive failed (poll)");
+
+	if( poll.revents & POLLRDHUP)
+		m_peerDisconnected = true;
+
+	if( poll.revents & POLLIN || poll.revents & POLLPRI)
+		return receive( data, maxLen, stream, notification);
+
+	return 0;
+}
+
 void SCTPSocket::listen( int backlog /* = 5 */)
 {
 	int ret = ::listen( m_socket, backlog);
@@ -238,3 +524,17 @@ void SCTPSocket::setInitValues( uint16_t numOutStreams, uint16_t maxInStreams, u
 	if( ret < 0)
 		throw SocketException("SCTPSocket construction failed (setsockopt)");
 }
+
+int SCTPSocket::receiveData( void* data, size_t maxLen, sctp_sndrcvinfo& info, int& flags)
+{
+	// notifications subscribed to are only passed on by receive() with a Notification
+	for(;;)
+	{
+		flags = 0;
+		int ret;
+		if( (ret = sctp_recvmsg( m_socket, data, maxLen, 0, 0, &info, &flags)) < 0)
+			throw SocketException("SCTPSocket::receive failed (sctp_recvmsg)");
+		if( !(flags & MSG_NOTIFICATION))
+			return ret;
+	}
+}
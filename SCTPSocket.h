@@ -32,8 +32,91 @@ namespace NET
 			OVERRIDE_PRIMARY = SCTP_ADDR_OVER
 		};
 
+		//! properties of a received message
 		enum receiveFlag
 		{
+			NO_FLAGS = 0,
+			UNORDERED = SCTP_UNORDERED, ///< the message was sent unordered
+			INCOMPLETE = 1 << 16        ///< the buffer was too small, the rest of the message follows
+		};
+
+		//! order in which the kernel serves the outgoing streams
+		enum streamScheduler
+		{
+			SCHEDULER_FCFS = SCTP_SS_FCFS,       ///< first come, first served (default)
+			SCHEDULER_PRIORITY = SCTP_SS_PRIO,   ///< streams with lower priority values first
+			SCHEDULER_ROUND_ROBIN = SCTP_SS_RR   ///< one message of each stream in turn
+		};
+
+		//! events to subscribe to with subscribe()
+		enum eventFlag
+		{
+			EVENT_ASSOCIATION_CHANGE = 1,  ///< association came up, was lost or restarted
+			EVENT_PEER_ADDRESS_CHANGE = 2, ///< a path of the peer became reachable or failed
+			EVENT_SEND_FAILED = 4,         ///< a message could not be delivered
+			EVENT_SHUTDOWN = 8             ///< the peer started a graceful shutdown
+		};
+
+		//! State of one path to the peer
+		struct PathStatus
+		{
+			std::string address;  ///< address of the peer
+			unsigned short port;  ///< port of the peer
+			int state;            ///< SCTP_ACTIVE, SCTP_INACTIVE, SCTP_UNCONFIRMED or SCTP_PF
+			unsigned cwnd;        ///< congestion window in bytes
+			unsigned srtt;        ///< smoothed round trip time in milliseconds
+			unsigned rto;         ///< retransmission timeout in milliseconds
+			unsigned mtu;         ///< path MTU
+		};
+
+		//! State of the association, fetched at once by status()
+		struct Status
+		{
+			int state;                   ///< e.g. SCTP_ESTABLISHED
+			int notAckedData;            ///< DATA chunks not acknowledged by the peer
+			int pendingData;             ///< DATA chunks waiting to be received
+			unsigned inStreams;          ///< number of incoming streams
+			unsigned outStreams;         ///< number of outgoing streams
+			unsigned fragmentationPoint; ///< message size above which messages are fragmented
+			PathStatus primary;          ///< the path used to send new data
+		};
+
+		//! An event of the association, received in-band by receive()
+		struct Notification
+		{
+			enum Type
+			{
+				NONE = 0, ///< a data message was received
+				ASSOCIATION_CHANGE = SCTP_ASSOC_CHANGE,
+				PEER_ADDRESS_CHANGE = SCTP_PEER_ADDR_CHANGE,
+				SEND_FAILED = SCTP_SEND_FAILED_EVENT,
+				PEER_SHUTDOWN = SCTP_SHUTDOWN_EVENT
+			};
+
+			Type type;
+			/*!
+			 * SCTP_COMM_UP, SCTP_COMM_LOST, SCTP_RESTART, ... for ASSOCIATION_CHANGE,
+			 * SCTP_ADDR_AVAILABLE, SCTP_ADDR_UNREACHABLE, ... for PEER_ADDRESS_CHANGE,
+			 * SCTP_DATA_UNSENT or SCTP_DATA_SENT for SEND_FAILED
+			 */
+			int state;
+			int error;             ///< error cause reported along with the event
+			std::string address;   ///< affected peer address of PEER_ADDRESS_CHANGE
+			unsigned short port;   ///< affected peer port of PEER_ADDRESS_CHANGE
+			uint16_t stream;       ///< stream of the failed message of SEND_FAILED
+			unsigned context;      ///< context of the failed message of SEND_FAILED
+		};
+
+		//! One message of a batch passed to sendBatch()
+		struct BatchMessage
+		{
+			const void* data;  ///< payload of the message
+			size_t length;     ///< length of the payload
+			uint16_t stream;   ///< stream to send the message on
+			unsigned ppid;     ///< payload protocol identifier
+			unsigned context;  ///< value reported if the message fails later
+			unsigned flags;    ///< UNORDERED, ABORT, SHUTDOWN or 0
+			int result;        ///< set to the number of bytes sent or to -errno
 		};
 
 		SCTPSocket( uint16_t numOutStreams = 10, uint16_t maxInStreams = 65535, uint16_t maxAttempts = 4,
@@ -51,6 +134,14 @@ namespace NET
 		using InternetSocket::connect;
 		int connect( const std::vector<std::string>& foreignAddresses, unsigned short foreignPort = 0);
 
+		//! return the state of the association and its primary path
+		/*!
+		 * Fetches everything with one system call. Prefer it over the
+		 * single value functions below when more than one value is needed.
+		 * \exception SocketException thrown if unable to fetch the state
+		 */
+		Status status() const;
+
 		int state() const;
 		int notAckedData() const;
 		int pendingData() const;
@@ -59,6 +150,45 @@ namespace NET
 		unsigned fragmentationPoint() const;
 		std::string primaryAddress() const;
 
+		/*!
+		 * Select the events delivered in-band by receive() with a
+		 * Notification. Events not selected are switched off. The other
+		 * receive functions drop notifications.
+		 * \param events combination of eventFlag values
+		 * \exception SocketException thrown if unable to subscribe
+		 */
+		void subscribe( unsigned events);
+
+		/*!
+		 * Select the stream scheduler. Set before connect() or listen()
+		 * it applies to all future associations of the socket.
+		 * \param scheduler order in which outgoing streams are served
+		 * \exception SocketException thrown if the kernel lacks the scheduler
+		 */
+		void setStreamScheduler( streamScheduler scheduler);
+
+		//! return the selected stream scheduler
+		/*!
+		 * \exception SocketException thrown if unable to fetch the scheduler
+		 */
+		streamScheduler getStreamScheduler() const;
+
+		/*!
+		 * Set the priority of an outgoing stream for SCHEDULER_PRIORITY.
+		 * Streams with a lower value are served first, streams of equal
+		 * priority round robin. Needs an established association.
+		 * \param stream outgoing stream
+		 * \param priority priority of the stream, 0 is the highest
+		 * \exception SocketException thrown if unable to set the priority
+		 */
+		void setStreamPriority( uint16_t stream, uint16_t priority);
+
+		//! return the priority of an outgoing stream
+		/*!
+		 * \exception SocketException thrown if unable to fetch the priority
+		 */
+		uint16_t getStreamPriority( uint16_t stream) const;
+
 		using SimpleSocket::send;
 		int send( const void* data, size_t length, uint16_t stream, unsigned ttl = 0, unsigned context = 0, unsigned ppid = 0,
 		          abortFlag abort = KEEPALIVE, switchAddressFlag switchAddr = KEEP_PRIMARY);
@@ -66,20 +196,57 @@ namespace NET
 		int sendUnordered( const void* data, size_t length, uint16_t stream, unsigned ttl = 0, unsigned context = 0,
 		                   unsigned ppid = 0, abortFlag abort = KEEPALIVE, switchAddressFlag switchAddr = KEEP_PRIMARY);
 
+		/*!
+		 * Send a batch of messages with as few system calls as possible.
+		 * Every message gets its own result, a failing message does not
+		 * stop the messages after it. On a non-blocking socket sending
+		 * stops at the first message that would block, this message and
+		 * all following ones get -EAGAIN.
+		 *
+		 * \param messages messages to send, the result of each is filled in
+		 * \param count number of messages
+		 * \return number of messages sent
+		 */
+		size_t sendBatch( BatchMessage* messages, size_t count);
+
 		using SimpleSocket::receive;
 		int receive( void* data, size_t maxLen, uint16_t& stream);
 		int receive( void* data, size_t maxLen, uint16_t& stream, receiveFlag& flag);
 
+		/*!
+		 * Receive the next data message or notification. A notification
+		 * larger than the buffer is read completely into an internal
+		 * buffer, a data message is truncated like with receive().
+		 * \param data buffer to receive the message
+		 * \param maxLen size of the buffer
+		 * \param stream set to the stream of a data message
+		 * \param notification set to the received event, type NONE for a data message
+		 * \return number of bytes of a data message, 0 for a notification
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int receive( void* data, size_t maxLen, uint16_t& stream, Notification& notification);
+
 		using SimpleSocket::timedReceive;
 		int timedReceive( void* data, size_t maxLen, uint16_t& stream, int timeout);
 		int timedReceive( void* data, size_t maxLen, uint16_t& stream, receiveFlag& flag, int timeout);
 
+		/*!
+		 * Receive the next data message or notification like receive().
+		 * \return number of bytes of a data message, 0 for a notification
+		 *         or on timeout, which leaves notification.type NONE
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int timedReceive( void* data, size_t maxLen, uint16_t& stream, Notification& notification, int timeout);
+
 		void listen( int backlog = 5);
 		Handle accept() const;
 		Handle timedAccept( int timeout) const;
 
 	protected:
 		void setInitValues( uint16_t ostr, uint16_t istr, uint16_t att, uint16_t time);
+
+	private:
+		int receiveData( void* data, size_t maxLen, sctp_sndrcvinfo& info, int& flags);
 	};
 
 } // namespace NET
@@ -0,0 +1,391 @@
+#include "SCTPStreamDispatcher.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+
+using namespace NET;
+
+namespace {
+
+// number of messages fetched by one recvmmsg
+const unsigned BATCH_SIZE = 16;
+
+// messages a worker handles from one queue before moving to the next
+const unsigned SERVE_LIMIT = 32;
+
+// rounds a worker yields before it goes to sleep
+const unsigned SPIN_ROUNDS = 64;
+
+} // namespace
+
+//! Single producer, single consumer ring of the messages of one stream
+class SCTPStreamDispatcher::StreamQueue
+{
+public:
+	explicit StreamQueue( size_t size)
+	: received(0)
+	, m_head(0)
+	, m_tail(0)
+	{
+		size_t capacity = 1;
+		while( capacity < size)
+			capacity <<= 1;
+		m_slots.resize(capacity);
+		m_mask = capacity - 1;
+	}
+
+	//! called by the receiving thread only
+	bool push( uint16_t stream, const uint8_t* data, size_t len)
+	{
+		size_t tail = m_tail.load( std::memory_order_relaxed);
+		if( tail - m_head.load( std::memory_order_acquire) > m_mask)
+			return false;
+
+		// the buffer of a slot keeps its capacity, so it is allocated only once per size
+		Message& slot = m_slots[tail & m_mask];
+		slot.data.assign( data, data + len);
+		slot.stream = stream;
+
+		m_tail.store( tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	//! called by the worker thread only
+	bool empty() const
+	{
+		return m_head.load( std::memory_order_relaxed) == m_tail.load( std::memory_order_acquire);
+	}
+
+	//! called by the worker thread only, the queue must not be empty
+	const std::vector<uint8_t>& front( uint16_t& stream) const
+	{
+		const Message& slot = m_slots[m_head.load( std::memory_order_relaxed) & m_mask];
+		stream = slot.stream;
+		return slot.data;
+	}
+
+	//! called by the worker thread only
+	void pop()
+	{
+		m_head.store( m_head.load( std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	//! messages of the stream received so far
+	std::atomic<uint64_t> received;
+
+private:
+	struct Message
+	{
+		std::vector<uint8_t> data;
+		uint16_t stream;
+	};
+
+	std::vector<Message> m_slots;
+	size_t m_mask;
+
+	// producer and consumer index on separate cache lines
+	char m_pad0[64];
+	std::atomic<size_t> m_head;
+	char m_pad1[64 - sizeof(std::atomic<size_t>)];
+	std::atomic<size_t> m_tail;
+};
+
+struct SCTPStreamDispatcher::Worker
+{
+	std::thread thread;
+	std::vector<StreamQueue*> queues;
+
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	std::atomic<bool> sleeping;
+
+	Worker() : sleeping(false) {}
+
+	bool pending() const
+	{
+		for( const StreamQueue* queue : queues)
+			if( !queue->empty()) return true;
+		return false;
+	}
+};
+
+SCTPStreamDispatcher::SCTPStreamDispatcher( SCTPSocket& socket, unsigned workers, size_t queueSize /* = 1024 */,
+                                            size_t maxMessageSize /* = 65536 */, unsigned streams /* = 0 */)
+: m_socket(socket)
+, m_maxMessageSize(maxMessageSize)
+, m_running(false)
+, m_receiving(false)
+, m_received(0)
+, m_stalls(0)
+, m_error(0)
+{
+	if( workers == 0)
+		throw SocketException("SCTPStreamDispatcher needs at least one worker", false);
+
+	if( streams == 0)
+		streams = socket.inStreams();
+	if( streams == 0)
+		throw SocketException("SCTPStreamDispatcher needs at least one stream", false);
+
+	// the stream of a message is passed along as SCTP_RCVINFO
+	int enable = 1;
+	if( setsockopt( socket.nativeHandle(), IPPROTO_SCTP, SCTP_RECVRCVINFO, &enable, sizeof(enable)) < 0)
+		throw SocketException("Enable receive info failed (setsockopt)");
+
+	for( unsigned i = 0; i < workers; ++i)
+		m_workers.push_back( std::unique_ptr<Worker>( new Worker));
+
+	for( unsigned i = 0; i < streams; ++i)
+	{
+		m_queues.push_back( std::unique_ptr<StreamQueue>( new StreamQueue( queueSize)));
+		m_workers[i % workers]->queues.push_back( m_queues.back().get());
+	}
+}
+
+SCTPStreamDispatcher::~SCTPStreamDispatcher()
+{
+	stop();
+}
+
+void SCTPStreamDispatcher::start( const Handler& handler)
+{
+	if( m_running.exchange(true))
+		throw SocketException("SCTPStreamDispatcher is already running", false);
+
+	m_handler = handler;
+	m_receiving = true;
+	m_error = 0;
+
+	for( unsigned i = 0; i < m_workers.size(); ++i)
+		m_workers[i]->thread = std::thread( &SCTPStreamDispatcher::work, this, i);
+	m_receiver = std::thread( &SCTPStreamDispatcher::receive, this);
+}
+
+void SCTPStreamDispatcher::stop()
+{
+	m_running = false;
+
+	// the workers drain their queues once the receiver is gone
+	if( m_receiver.joinable())
+		m_receiver.join();
+	m_receiving = false;
+
+	for( auto& worker : m_workers)
+	{
+		wake( *worker);
+		if( worker->thread.joinable())
+			worker->thread.join();
+	}
+}
+
+uint64_t SCTPStreamDispatcher::received() const
+{
+	return m_received;
+}
+
+uint64_t SCTPStreamDispatcher::received( uint16_t stream) const
+{
+	return m_queues.at(stream)->received;
+}
+
+uint64_t SCTPStreamDispatcher::stalls() const
+{
+	return m_stalls;
+}
+
+int SCTPStreamDispatcher::error() const
+{
+	return m_error;
+}
+
+void SCTPStreamDispatcher::receive()
+{
+	int socket = m_socket.nativeHandle();
+
+	std::vector<uint8_t> buffers( BATCH_SIZE * m_maxMessageSize);
+	char control[BATCH_SIZE][CMSG_SPACE(sizeof(sctp_rcvinfo))];
+	struct iovec iovs[BATCH_SIZE];
+	struct mmsghdr msgs[BATCH_SIZE];
+	std::vector<bool> touched( m_workers.size());
+
+	// parts of messages larger than a receive buffer, by queue
+	std::vector<std::vector<uint8_t>> partial( m_queues.size());
+
+	while( m_running)
+	{
+		// wake up regularly to notice stop()
+		struct pollfd poll;
+		poll.fd = socket;
+		poll.events = POLLIN;
+
+		int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, 100));
+		if( ret < 0)
+		{
+			m_error = errno;
+			break;
+		}
+		if( ret == 0) continue;
+
+		std::memset( msgs, 0, sizeof(msgs));
+		for( unsigned i = 0; i < BATCH_SIZE; ++i)
+		{
+			iovs[i].iov_base = &buffers[i * m_maxMessageSize];
+			iovs[i].iov_len = m_maxMessageSize;
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+			msgs[i].msg_hdr.msg_control = control[i];
+			msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+		}
+
+		ret = TEMP_FAILURE_RETRY (::recvmmsg( socket, msgs, BATCH_SIZE, MSG_DONTWAIT, nullptr));
+		if( ret < 0)
+		{
+			if( errno == EAGAIN) continue;
+			m_error = errno;
+			break;
+		}
+
+		bool done = false;
+		for( int i = 0; i < ret; ++i)
+		{
+			msghdr& msg = msgs[i].msg_hdr;
+			if( msg.msg_flags & MSG_NOTIFICATION)
+				continue;
+
+			// the peer shut the association down
+			if( msgs[i].msg_len == 0)
+			{
+				done = true;
+				break;
+			}
+
+			uint16_t stream = 0;
+			for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+			{
+				if( cmsg->cmsg_level == IPPROTO_SCTP && cmsg->cmsg_type == SCTP_RCVINFO)
+				{
+					sctp_rcvinfo info;
+					std::memcpy( &info, CMSG_DATA(cmsg), sizeof(info));
+					stream = info.rcv_sid;
+				}
+			}
+
+			size_t index = stream % m_queues.size();
+			StreamQueue& queue = *m_queues[index];
+			Worker& worker = *m_workers[index % m_workers.size()];
+			const uint8_t* data = static_cast<const uint8_t*>(iovs[i].iov_base);
+			size_t len = msgs[i].msg_len;
+
+			// collect the parts until the end of the message
+			std::vector<uint8_t>& parts = partial[index];
+			if( !(msg.msg_flags & MSG_EOR))
+			{
+				parts.insert( parts.end(), data, data + len);
+				continue;
+			}
+			if( !parts.empty())
+			{
+				parts.insert( parts.end(), data, data + len);
+				data = parts.data();
+				len = parts.size();
+			}
+
+			bool pushed = queue.push( stream, data, len);
+			if( !pushed)
+			{
+				++m_stalls;
+				wake( worker);
+				while( !(pushed = queue.push( stream, data, len)) && m_running)
+					std::this_thread::yield();
+			}
+			parts.clear();
+
+			// stop() was called while waiting for the worker
+			if( !pushed)
+			{
+				done = true;
+				break;
+			}
+
+			queue.received.store( queue.received.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			m_received.store( m_received.load( std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			touched[index % m_workers.size()] = true;
+		}
+
+		// one wake up per worker and batch
+		for( size_t i = 0; i < touched.size(); ++i)
+		{
+			if( touched[i]) wake( *m_workers[i]);
+			touched[i] = false;
+		}
+
+		if( done) break;
+	}
+
+	m_receiving = false;
+}
+
+void SCTPStreamDispatcher::work( unsigned index)
+{
+	Worker& worker = *m_workers[index];
+
+	for(;;)
+	{
+		if( serve( worker)) continue;
+
+		// the receiver has finished, handle what is left and quit
+		if( !m_receiving)
+		{
+			if( serve( worker)) continue;
+			break;
+		}
+
+		bool served = false;
+		for( unsigned i = 0; i < SPIN_ROUNDS && !served; ++i)
+		{
+			std::this_thread::yield();
+			served = serve( worker);
+		}
+		if( served) continue;
+
+		// the timeout covers a wake up racing with going to sleep
+		std::unique_lock<std::mutex> lock( worker.mutex);
+		worker.sleeping = true;
+		if( !worker.pending() && m_receiving)
+			worker.wakeup.wait_for( lock, std::chrono::milliseconds(10));
+		worker.sleeping = false;
+	}
+}
+
+bool SCTPStreamDispatcher::serve( Worker& worker)
+{
+	bool served = false;
+
+	for( StreamQueue* queue : worker.queues)
+	{
+		for( unsigned i = 0; i < SERVE_LIMIT && !queue->empty(); ++i)
+		{
+			uint16_t stream;
+			const std::vector<uint8_t>& data = queue->front( stream);
+			m_handler( stream, data.data(), data.size());
+			queue->pop();
+			served = true;
+		}
+	}
+	return served;
+}
+
+void SCTPStreamDispatcher::wake( Worker& worker)
+{
+	if( worker.sleeping)
+	{
+		std::lock_guard<std::mutex> lock( worker.mutex);
+		worker.wakeup.notify_one();
+	}
+}
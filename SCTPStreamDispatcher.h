@@ -0,0 +1,131 @@
+#ifndef NET_SCTPStreamDispatcher_h__
+#define NET_SCTPStreamDispatcher_h__
+
+#include "SCTPSocket.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace NET
+{
+	//! Dispatches the messages of an SCTP association to worker threads by stream
+	/*!
+	 * SCTPStreamDispatcher runs one thread that receives the messages of a
+	 * connected SCTPSocket in batches and routes them by stream number to
+	 * a lock-free single producer, single consumer queue per stream. The
+	 * queues are served by a pool of worker threads, stream s is always
+	 * handled by worker s % workers. Thus messages of one stream are
+	 * handled in the order they were received, while a slow handler only
+	 * delays the streams of its own worker.
+	 *
+	 * If the queue of a stream is full, the receiving thread waits until
+	 * the worker made room. Messages are never dropped, the association is
+	 * throttled by SCTP flow control instead, until stop() is called.
+	 *
+	 * Messages larger than maxMessageSize are received in several parts,
+	 * which are joined before the message is handed over. Notifications
+	 * are not dispatched.
+	 *
+	 * Usage example:
+	 * \code
+	 * SCTPSocket socket;
+	 * socket.connect( "192.168.0.1", 2905);
+	 * SCTPStreamDispatcher dispatcher( socket, 4);
+	 * dispatcher.start( [](uint16_t stream, const void* data, size_t len) {
+	 *   process( stream, data, len);
+	 * });
+	 * // ...
+	 * dispatcher.stop();
+	 * \endcode
+	 */
+	class SCTPStreamDispatcher
+	{
+	public:
+		//! called by a worker thread for every received message
+		typedef std::function<void( uint16_t stream, const void* data, size_t len)> Handler;
+
+		/*!
+		 * Prepare dispatching of the given socket. The socket must be
+		 * connected and outlive the dispatcher.
+		 *
+		 * \param socket connected socket to receive from
+		 * \param workers number of worker threads
+		 * \param queueSize number of messages a stream queue can hold, rounded up to a power of two
+		 * \param maxMessageSize size of the receive buffers, larger messages are joined from parts
+		 * \param streams number of incoming streams, 0 to ask the association
+		 * \exception SocketException thrown if unable to set up receiving
+		 */
+		SCTPStreamDispatcher( SCTPSocket& socket, unsigned workers, size_t queueSize = 1024,
+		                      size_t maxMessageSize = 65536, unsigned streams = 0);
+
+		//! stops all running threads
+		~SCTPStreamDispatcher();
+
+		//! start the receiving and the worker threads
+		/*!
+		 * \param handler function called for every received message
+		 * \exception SocketException thrown if the threads are already running
+		 */
+		void start( const Handler& handler);
+
+		//! stop all threads and wait for them to finish
+		/*!
+		 * Messages already queued are handled before the workers finish.
+		 * A message waiting for room in a full queue is discarded.
+		 */
+		void stop();
+
+		//! return the number of messages received
+		uint64_t received() const;
+
+		//! return the number of messages received on the given stream
+		uint64_t received( uint16_t stream) const;
+
+		//! return how often the receiving thread had to wait for a full queue
+		uint64_t stalls() const;
+
+		//! return the error that stopped the receiving thread
+		/*!
+		 * The receiving thread ends if poll() or recvmmsg() fail, which is
+		 * reported as errno value. Queued messages are still handled. It
+		 * is reset by start().
+		 *
+		 * \return 0 while receiving, after stop() or after the peer shut the association down
+		 */
+		int error() const;
+
+	private:
+		class StreamQueue;
+		struct Worker;
+
+		void receive();
+		void work( unsigned worker);
+		bool serve( Worker& worker);
+		void wake( Worker& worker);
+
+		// dont' allow
+		SCTPStreamDispatcher( const SCTPStreamDispatcher&);
+		const SCTPStreamDispatcher& operator=( const SCTPStreamDispatcher&);
+
+		SCTPSocket& m_socket;
+		size_t m_maxMessageSize;
+
+		std::vector<std::unique_ptr<StreamQueue>> m_queues;
+		std::vector<std::unique_ptr<Worker>> m_workers;
+		std::thread m_receiver;
+
+		Handler m_handler;
+		std::atomic<bool> m_running;
+		std::atomic<bool> m_receiving;
+		std::atomic<uint64_t> m_received;
+		std::atomic<uint64_t> m_stalls;
+		std::atomic<int> m_error;
+	};
+
+} // namespace NET
+
+#endif // NET_SCTPStreamDispatcher_h__
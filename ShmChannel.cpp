@@ -0,0 +1,485 @@
+#include "ShmChannel.h"
+#include "TempFailure.h"
+
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+using namespace NET;
+
+namespace {
+
+const uint64_t MAGIC = 0x314c4e4843534e4eULL;
+
+// every record starts with a header and is aligned to it
+const size_t RECORD_ALIGN = 8;
+
+// a record that only skips the rest of the ring up to its end
+const uint64_t PADDING = ~uint64_t(0);
+
+const size_t MIN_CAPACITY = 4096;
+
+// bounds of the adaptive spin of the receiver, in rounds
+const unsigned MIN_SPIN = 64;
+const unsigned MAX_SPIN = 1 << 14;
+
+// senders waiting for room spin a fixed number of rounds
+const unsigned SEND_SPIN = 1024;
+
+// sleeping senders look at the ring again after this time, as several
+// of them share one doorbell
+const int SPACE_POLL_INTERVAL = 10;
+
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#endif
+}
+
+inline size_t recordSize( size_t len)
+{
+	return (sizeof(uint64_t) + len + RECORD_ALIGN - 1) & ~(RECORD_ALIGN - 1);
+}
+
+void ring( int eventfd)
+{
+	uint64_t one = 1;
+	// a full counter means the doorbell is rung already
+	TEMP_FAILURE_RETRY (::write( eventfd, &one, sizeof(one)));
+}
+
+// returns false on timeout, hangup is set if the socket to the peer was closed
+bool sleepOn( int eventfd, int peer, int timeout, bool& hangup)
+{
+	struct pollfd poll[2];
+	poll[0].fd = eventfd;
+	poll[0].events = POLLIN;
+	poll[1].fd = peer;
+	poll[1].events = 0;   // POLLHUP is always reported
+
+	int ret = TEMP_FAILURE_RETRY (::poll( poll, 2, timeout));
+	if( ret < 0)
+		throw SocketException("ShmChannel wait failed (poll)");
+	if( ret == 0)
+		return false;
+
+	hangup = poll[1].revents & (POLLHUP | POLLERR);
+	if( poll[0].revents & POLLIN)
+	{
+		uint64_t count;
+		TEMP_FAILURE_RETRY (::read( eventfd, &count, sizeof(count)));
+	}
+	return true;
+}
+
+// a copy of the socket to the peer, closed by the kernel if the peer dies
+int keepPeer( UnixSocket& socket)
+{
+	int fd = ::fcntl( socket.nativeHandle(), F_DUPFD_CLOEXEC, 0);
+	if( fd < 0)
+		throw SocketException("ShmChannel setup failed (fcntl)");
+	return fd;
+}
+
+void closeAll( int* fds, size_t count)
+{
+	for( size_t i = 0; i < count; ++i)
+		if( fds[i] >= 0) TEMP_FAILURE_RETRY (::close( fds[i]));
+}
+
+} // namespace
+
+//! State of one direction, shared by both processes
+struct ShmChannel::Ring
+{
+	// written by the senders
+	alignas(64) std::atomic<uint64_t> reserved;
+	std::atomic<uint64_t> committed;
+	std::atomic<uint32_t> sendersWaiting;
+
+	// written by the receiver
+	alignas(64) std::atomic<uint64_t> consumed;
+	std::atomic<uint32_t> receiverWaiting;
+};
+
+//! Start of the memory file, followed by the data of both rings
+struct ShmChannel::Header
+{
+	uint64_t magic;
+	uint64_t capacity;
+	std::atomic<uint32_t> closed[2];
+	Ring rings[2];
+};
+
+static_assert( ATOMIC_LLONG_LOCK_FREE == 2, "shared memory needs lock-free 64 bit atomics");
+
+ShmChannel::ShmChannel( UnixSocket& socket, size_t capacity)
+: m_map(nullptr)
+, m_mapSize(0)
+, m_header(nullptr)
+, m_side(0)
+, m_capacity(MIN_CAPACITY)
+, m_peer(-1)
+, m_spin(MIN_SPIN)
+, m_broken(false)
+, m_peerDisconnected(false)
+{
+	while( m_capacity < capacity)
+		m_capacity <<= 1;
+
+	// memory file first, then the doorbells: data and space of ring 0, data and space of ring 1
+	int fds[5] = { -1, -1, -1, -1, -1 };
+	try
+	{
+		fds[0] = ::memfd_create( "ShmChannel", MFD_CLOEXEC);
+		if( fds[0] < 0)
+			throw SocketException("ShmChannel creation failed (memfd_create)");
+
+		size_t size = sizeof(Header) + 2 * m_capacity;
+		if( ::ftruncate( fds[0], static_cast<off_t>(size)) < 0)
+			throw SocketException("ShmChannel creation failed (ftruncate)");
+
+		for( int i = 1; i < 5; ++i)
+		{
+			fds[i] = ::eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK);
+			if( fds[i] < 0)
+				throw SocketException("ShmChannel creation failed (eventfd)");
+		}
+
+		map( fds[0], size);
+
+		// the memory file is zeroed, which is a valid empty state of the atomics
+		m_header->capacity = m_capacity;
+		m_header->magic = MAGIC;
+
+		m_peer = keepPeer( socket);
+		socket.sendFds( fds, 5);
+	}
+	catch(...)
+	{
+		closeAll( fds, 5);
+		cleanup();
+		throw;
+	}
+
+	TEMP_FAILURE_RETRY (::close( fds[0]));
+	attach( 0, fds + 1);
+}
+
+ShmChannel::ShmChannel( UnixSocket& socket)
+: m_map(nullptr)
+, m_mapSize(0)
+, m_header(nullptr)
+, m_side(1)
+, m_capacity(0)
+, m_peer(-1)
+, m_spin(MIN_SPIN)
+, m_broken(false)
+, m_peerDisconnected(false)
+{
+	char dummy;
+	std::vector<int> fds;
+	if( socket.receiveFds( &dummy, 1, fds, 5) <= 0 || fds.size() != 5)
+	{
+		closeAll( fds.data(), fds.size());
+		throw SocketException("ShmChannel was not passed by the peer", false);
+	}
+
+	try
+	{
+		struct stat info;
+		if( ::fstat( fds[0], &info) < 0)
+			throw SocketException("ShmChannel memory file failed (fstat)");
+
+		size_t size = static_cast<size_t>(info.st_size);
+		if( size < sizeof(Header))
+			throw SocketException("ShmChannel memory file is too small", false);
+
+		map( fds[0], size);
+
+		// the rings are indexed by masking, so their size has to be a power of two
+		uint64_t capacity = m_header->capacity;
+		if( m_header->magic != MAGIC || capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0 ||
+		    sizeof(Header) + 2 * capacity != size)
+			throw SocketException("ShmChannel memory file is invalid", false);
+		m_capacity = capacity;
+
+		m_peer = keepPeer( socket);
+	}
+	catch(...)
+	{
+		closeAll( fds.data(), fds.size());
+		cleanup();
+		throw;
+	}
+
+	TEMP_FAILURE_RETRY (::close( fds[0]));
+	attach( 1, fds.data() + 1);
+}
+
+ShmChannel::~ShmChannel()
+{
+	// wake the peer, it finds the channel closed
+	m_header->closed[m_side].store( 1);
+	ring( m_txDoorbell);
+	ring( m_rxSpace);
+
+	TEMP_FAILURE_RETRY (::close( m_txDoorbell));
+	TEMP_FAILURE_RETRY (::close( m_txSpace));
+	TEMP_FAILURE_RETRY (::close( m_rxDoorbell));
+	TEMP_FAILURE_RETRY (::close( m_rxSpace));
+	cleanup();
+}
+
+void ShmChannel::map( int memfd, size_t size)
+{
+	void* map = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+	if( map == MAP_FAILED)
+		throw SocketException("ShmChannel mapping failed (mmap)");
+
+	m_map = static_cast<uint8_t*>(map);
+	m_mapSize = size;
+	m_header = reinterpret_cast<Header*>(m_map);
+}
+
+void ShmChannel::attach( unsigned side, const int* eventfds)
+{
+	// side 0 sends on ring 0 and receives on ring 1, side 1 the other way round
+	unsigned tx = side;
+	unsigned rx = 1 - side;
+
+	m_tx = &m_header->rings[tx];
+	m_txData = m_map + sizeof(Header) + tx * m_capacity;
+	m_txDoorbell = eventfds[2 * tx];
+	m_txSpace = eventfds[2 * tx + 1];
+
+	m_rx = &m_header->rings[rx];
+	m_rxData = m_map + sizeof(Header) + rx * m_capacity;
+	m_rxDoorbell = eventfds[2 * rx];
+	m_rxSpace = eventfds[2 * rx + 1];
+}
+
+void ShmChannel::cleanup()
+{
+	if( m_map)
+		::munmap( m_map, m_mapSize);
+	m_map = nullptr;
+	m_header = nullptr;
+
+	if( m_peer >= 0)
+		TEMP_FAILURE_RETRY (::close( m_peer));
+	m_peer = -1;
+}
+
+size_t ShmChannel::maxMessageSize() const
+{
+	// a record of half the ring always fits, either before or after the wrap around
+	return m_capacity / 2 - sizeof(uint64_t);
+}
+
+bool ShmChannel::peerDisconnected() const
+{
+	return m_peerDisconnected;
+}
+
+int ShmChannel::send( const void* buffer, size_t len)
+{
+	if( len > maxMessageSize())
+		throw SocketException("Message is too large for the ShmChannel", false);
+
+	if( m_peerDisconnected || m_header->closed[1 - m_side].load( std::memory_order_relaxed))
+	{
+		m_peerDisconnected = true;
+		return -1;
+	}
+
+	const size_t mask = m_capacity - 1;
+	const size_t record = recordSize(len);
+
+	uint64_t start;
+	size_t need;
+	unsigned spin = 0;
+	for(;;)
+	{
+		start = m_tx->reserved.load( std::memory_order_relaxed);
+		size_t pos = start & mask;
+		size_t contiguous = m_capacity - pos;
+		need = record <= contiguous ? record : contiguous + record;
+
+		if( start + need - m_tx->consumed.load( std::memory_order_acquire) <= m_capacity)
+		{
+			if( m_tx->reserved.compare_exchange_weak( start, start + need, std::memory_order_relaxed))
+				break;
+			continue;
+		}
+
+		if( m_peerDisconnected || m_header->closed[1 - m_side].load())
+		{
+			m_peerDisconnected = true;
+			return -1;
+		}
+
+		// the ring is full, wait for the receiver
+		if( spin++ < SEND_SPIN)
+		{
+			cpuRelax();
+			continue;
+		}
+		bool hangup = false;
+		m_tx->sendersWaiting.fetch_add(1);
+		if( start + need - m_tx->consumed.load() > m_capacity)
+			sleepOn( m_txSpace, m_peer, SPACE_POLL_INTERVAL, hangup);
+		m_tx->sendersWaiting.fetch_sub(1);
+		if( hangup)
+			m_peerDisconnected = true;
+	}
+
+	uint8_t* pos = m_txData + (start & mask);
+	if( need != record)
+	{
+		uint64_t padding = PADDING;
+		std::memcpy( pos, &padding, sizeof(padding));
+		pos = m_txData;
+	}
+
+	uint64_t header = len;
+	std::memcpy( pos, &header, sizeof(header));
+	std::memcpy( pos + sizeof(header), buffer, len);
+
+	// records become visible in the order they were reserved
+	while( m_tx->committed.load( std::memory_order_acquire) != start)
+		cpuRelax();
+	m_tx->committed.store( start + need);
+
+	if( m_tx->receiverWaiting.load())
+		ring( m_txDoorbell);
+
+	return static_cast<int>(len);
+}
+
+int ShmChannel::receive( void* buffer, size_t len)
+{
+	return receiveMessage( buffer, len, -1);
+}
+
+int ShmChannel::timedReceive( void* buffer, size_t len, int timeout)
+{
+	return receiveMessage( buffer, len, timeout);
+}
+
+int ShmChannel::receiveMessage( void* buffer, size_t len, int timeout)
+{
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+
+	int ret;
+	for(;;)
+	{
+		if( tryReceive( buffer, len, ret))
+			return ret;
+
+		if( m_peerDisconnected || m_header->closed[1 - m_side].load())
+		{
+			// messages sent before closing are still delivered
+			if( tryReceive( buffer, len, ret))
+				return ret;
+			m_peerDisconnected = true;
+			return 0;
+		}
+
+		// a wakeup without a message must not restart the timeout
+		int remaining = -1;
+		if( timeout >= 0)
+		{
+			Clock::duration left = deadline - Clock::now();
+			remaining = static_cast<int>( std::chrono::duration_cast<std::chrono::milliseconds>(left).count());
+			if( remaining < 0) remaining = 0;
+		}
+
+		if( !waitForData( remaining))
+			return 0;
+	}
+}
+
+bool ShmChannel::tryReceive( void* buffer, size_t len, int& ret)
+{
+	if( m_broken)
+		throw SocketException("ShmChannel is corrupted, invalid record", false);
+
+	const size_t mask = m_capacity - 1;
+	uint64_t consumed = m_rx->consumed.load( std::memory_order_relaxed);
+	uint64_t committed = m_rx->committed.load( std::memory_order_acquire);
+
+	for(;;)
+	{
+		if( consumed == committed)
+			return false;
+
+		const uint8_t* pos = m_rxData + (consumed & mask);
+		uint64_t header;
+		std::memcpy( &header, pos, sizeof(header));
+
+		if( header == PADDING)
+		{
+			consumed += m_capacity - (consumed & mask);
+			if( consumed > committed)
+				break;
+			continue;
+		}
+
+		// the peer may write anything into the shared memory, never read beyond the ring
+		if( header > maxMessageSize() || recordSize( static_cast<size_t>(header)) > committed - consumed ||
+		    (consumed & mask) + recordSize( static_cast<size_t>(header)) > m_capacity)
+			break;
+
+		size_t size = static_cast<size_t>(header);
+		std::memcpy( buffer, pos + sizeof(header), size < len ? size : len);
+		ret = static_cast<int>(size);
+
+		m_rx->consumed.store( consumed + recordSize(size));
+		if( m_rx->sendersWaiting.load())
+			ring( m_rxSpace);
+		return true;
+	}
+
+	m_broken = true;
+	throw SocketException("ShmChannel is corrupted, invalid record", false);
+}
+
+bool ShmChannel::waitForData( int timeout)
+{
+	uint64_t consumed = m_rx->consumed.load( std::memory_order_relaxed);
+
+	// spinning is adapted to how long the last waits took
+	for( unsigned i = 0; i < m_spin; ++i)
+	{
+		if( m_rx->committed.load( std::memory_order_acquire) != consumed)
+		{
+			if( m_spin < MAX_SPIN) m_spin <<= 1;
+			return true;
+		}
+		cpuRelax();
+	}
+	if( m_spin > MIN_SPIN) m_spin >>= 1;
+
+	// the doorbell is only rung while receiverWaiting is set
+	m_rx->receiverWaiting.store(1);
+	bool ret = true;
+	bool hangup = false;
+	if( m_rx->committed.load() == consumed && !m_header->closed[1 - m_side].load())
+		ret = sleepOn( m_rxDoorbell, m_peer, timeout, hangup);
+	m_rx->receiverWaiting.store(0);
+
+	// a crashed peer never sets closed, the kernel closes its socket instead
+	if( hangup)
+		m_peerDisconnected = true;
+	return ret;
+}
@@ -0,0 +1,147 @@
+#ifndef NET_ShmChannel_h__
+#define NET_ShmChannel_h__
+
+#include "UnixSocket.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace NET
+{
+	//! Message channel between two processes through shared memory
+	/*!
+	 * ShmChannel passes messages between processes on the same host
+	 * without the kernel copying them. Each direction is a ring within a
+	 * memory file (memfd) mapped by both processes. A message is copied
+	 * once into the ring by the sender and once out of it by the receiver.
+	 *
+	 * The channel is set up over a connected stream or sequenced packet
+	 * UnixSocket: one side creates the memory file and passes it together
+	 * with four eventfds to the other side (SCM_RIGHTS). Both sides keep a
+	 * copy of the socket, which the kernel closes if the peer process
+	 * dies. Waiting receivers and senders watch it, so they see a crashed
+	 * peer as disconnected. The socket itself may be closed afterwards.
+	 *
+	 * Any number of threads of a process may send at the same time, the
+	 * ring is multi producer, single consumer. Only one thread may
+	 * receive at a time.
+	 *
+	 * A waiting receiver first spins on the ring and goes to sleep on an
+	 * eventfd only if nothing arrives. The senders ring that doorbell only
+	 * while the receiver sleeps. The spin time adapts: it grows while
+	 * spinning pays off and shrinks while it does not. Senders waiting
+	 * for room in a full ring behave the same way.
+	 *
+	 * Usage example:
+	 * \code
+	 * // process A
+	 * UnixStreamSocket socket( server.accept());
+	 * ShmChannel channel( socket, 1 << 20);
+	 * channel.send( request, requestLen);
+	 *
+	 * // process B
+	 * UnixStreamSocket socket;
+	 * socket.connect("/tmp/shm.sock");
+	 * ShmChannel channel(socket);
+	 * int len = channel.receive( buffer, sizeof(buffer));
+	 * \endcode
+	 */
+	class ShmChannel
+	{
+	public:
+		/*!
+		 * Create a channel and pass it to the peer of the socket, which
+		 * has to construct its side with ShmChannel(UnixSocket&).
+		 *
+		 * \param socket connected socket to the peer
+		 * \param capacity size of each ring in bytes, rounded up to a power of two
+		 * \exception SocketException thrown if unable to create or pass the channel
+		 */
+		ShmChannel( UnixSocket& socket, size_t capacity);
+
+		/*!
+		 * Join a channel created by the peer of the socket.
+		 * \param socket connected socket to the peer
+		 * \exception SocketException thrown if unable to receive or map the channel, or if its layout is invalid
+		 */
+		explicit ShmChannel( UnixSocket& socket);
+
+		//! signals the peer that the channel is closed and unmaps it
+		~ShmChannel();
+
+		/*!
+		 * Send a message. Blocks while the ring is full.
+		 * \param buffer message to send
+		 * \param len length of the message, at most maxMessageSize()
+		 * \return number of bytes sent, -1 if the peer closed the channel
+		 * \exception SocketException thrown if the message is too large
+		 */
+		int send( const void* buffer, size_t len);
+
+		/*!
+		 * Receive the next message. Bytes of the message exceeding the
+		 * buffer are discarded.
+		 * \param buffer buffer to receive the message
+		 * \param len size of the buffer
+		 * \return length of the message, 0 if the peer closed the channel
+		 * \exception SocketException thrown if waiting failed or the peer wrote an invalid record
+		 */
+		int receive( void* buffer, size_t len);
+
+		/*!
+		 * Receive the next message like receive(), return after the
+		 * given timespan.
+		 * \param buffer buffer to receive the message
+		 * \param len size of the buffer
+		 * \param timeout timeout in milliseconds
+		 * \return length of the message, 0 on timeout or if the peer closed the channel
+		 * \exception SocketException thrown if waiting failed or the peer wrote an invalid record
+		 */
+		int timedReceive( void* buffer, size_t len, int timeout);
+
+		//! return the size of the largest message
+		size_t maxMessageSize() const;
+
+		//! returns whether the peer closed the channel
+		bool peerDisconnected() const;
+
+	private:
+		struct Header;
+		struct Ring;
+
+		void map( int memfd, size_t size);
+		void attach( unsigned side, const int* eventfds);
+		int receiveMessage( void* buffer, size_t len, int timeout);
+		bool tryReceive( void* buffer, size_t len, int& ret);
+		bool waitForData( int timeout);
+		void cleanup();
+
+		// dont' allow
+		ShmChannel( const ShmChannel&);
+		const ShmChannel& operator=( const ShmChannel&);
+
+		uint8_t* m_map;
+		size_t m_mapSize;
+		Header* m_header;
+		unsigned m_side;
+		size_t m_capacity;
+		int m_peer;         // copy of the socket to the peer, hangs up when the peer is gone
+
+		Ring* m_tx;
+		uint8_t* m_txData;
+		int m_txDoorbell;   // rung when data is available to the peer
+		int m_txSpace;      // rung by the peer when it freed room
+
+		Ring* m_rx;
+		uint8_t* m_rxData;
+		int m_rxDoorbell;
+		int m_rxSpace;
+
+		unsigned m_spin;
+		bool m_broken;      // the peer wrote an invalid record
+		std::atomic<bool> m_peerDisconnected;
+	};
+
+} // namespace NET
+
+#endif // NET_ShmChannel_h__
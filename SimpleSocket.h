@@ -184,14 +184,17 @@ namespace NET
 		{
 			INTERNET = PF_INET,
 			UNIX = PF_LOCAL,
-			CAN = PF_CAN
+			CAN = PF_CAN,
+			PACKET = PF_PACKET,
+			XDP = PF_XDP
 		};
 
 		enum SocketType
 		{
 			RAW = SOCK_RAW,
 			STREAM = SOCK_STREAM,
-			DATAGRAM = SOCK_DGRAM
+			DATAGRAM = SOCK_DGRAM,
+			SEQPACKET = SOCK_SEQPACKET
 		};
 
 		//! enables return of an accepted socket
@@ -11,6 +11,10 @@ namespace NET
 
 	class TCPSocket;
 	class SCTPSocket;
+	class UnixSocket;
+	class UnixStreamSocket;
+	class UnixSeqPacketSocket;
+	class UnixChannel;
 
 	//! A simple class to provide strict ownership of socket handles.
 	/*!
@@ -50,6 +54,11 @@ namespace NET
 	public:
 		friend class TCPSocket;
 		friend class SCTPSocket;
+		friend class SCTPMultiSocket;
+		friend class UnixSocket;
+		friend class UnixStreamSocket;
+		friend class UnixSeqPacketSocket;
+		friend class UnixChannel;
 
 		//! socket type that was provided as template argument
 		typedef Socket socket_type;
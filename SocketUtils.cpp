@@ -1,17 +1,24 @@
 #include "SocketUtils.h"
 #include "SimpleSocket.h"
+#include "TempFailure.h"
 
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <arpa/inet.h>
 #include <net/if.h>
 #include <net/if_arp.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <cerrno>
 #include <cstdint>
 
+#include <algorithm>
 #include <cstring>
 #include <cstdlib>
+#include <functional>
+#include <map>
 #include <sstream>
 #include <iomanip>
 
@@ -19,6 +26,9 @@ using namespace NET;
 
 namespace
 {
+	// dumps of interfaces and addresses before giving up on a changing system
+	const unsigned MAX_DUMP_ATTEMPTS = 10;
+
 	// needed because of strict aliasing rules
 	class sockaddr_ptr
 	{
@@ -38,6 +48,93 @@ namespace
 		temp_socket() : SimpleSocket( AF_INET, SOCK_DGRAM, 0) {}
 	};
 
+	// use as temporary RAII netlink socket
+	class netlink_socket : public SimpleSocket
+	{
+	public:
+		netlink_socket() : SimpleSocket( AF_NETLINK, SOCK_RAW, NETLINK_ROUTE) {}
+	};
+
+	// request a dump of all objects of the given type and pass every reply to handler,
+	// return false if the objects changed during the dump, so the replies are inconsistent
+	bool netlink_dump( netlink_socket& sock, uint16_t type, uint32_t seq,
+	                   const std::function<void( const nlmsghdr*)>& handler)
+	{
+		struct
+		{
+			nlmsghdr header;
+			rtgenmsg body;
+		} request;
+		std::memset( &request, 0, sizeof(request));
+		request.header.nlmsg_len = NLMSG_LENGTH(sizeof(rtgenmsg));
+		request.header.nlmsg_type = type;
+		request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+		request.header.nlmsg_seq = seq;
+		request.body.rtgen_family = AF_UNSPEC;
+
+		if( TEMP_FAILURE_RETRY (::send( sock.nativeHandle(), &request, request.header.nlmsg_len, 0)) < 0)
+			throw SocketException("Netlink request failed (send)");
+
+		// a dump spans several datagrams, each holding as many replies as fit
+		std::vector<char> buffer( 32768);
+		bool consistent = true;
+		for(;;)
+		{
+			// the kernel may fill datagrams larger than the buffer, depending on the page size
+			ssize_t ret = TEMP_FAILURE_RETRY (::recv( sock.nativeHandle(), buffer.data(), buffer.size(), MSG_PEEK | MSG_TRUNC));
+			if( ret < 0)
+				throw SocketException("Netlink request failed (recv)");
+			if( static_cast<size_t>(ret) > buffer.size())
+				buffer.resize( static_cast<size_t>(ret));
+
+			ret = TEMP_FAILURE_RETRY (::recv( sock.nativeHandle(), buffer.data(), buffer.size(), 0));
+			if( ret < 0)
+				throw SocketException("Netlink request failed (recv)");
+
+			size_t len = static_cast<size_t>(ret);
+			for( const nlmsghdr* msg = reinterpret_cast<const nlmsghdr*>(buffer.data()); NLMSG_OK(msg, len);
+			     msg = NLMSG_NEXT(msg, len))
+			{
+				if( msg->nlmsg_seq != seq)
+					continue;
+				if( msg->nlmsg_flags & NLM_F_DUMP_INTR)
+					consistent = false;
+				if( msg->nlmsg_type == NLMSG_DONE)
+					return consistent;
+				if( msg->nlmsg_type == NLMSG_ERROR)
+				{
+					const nlmsgerr* error = static_cast<const nlmsgerr*>(NLMSG_DATA(msg));
+					errno = -error->error;
+					throw SocketException("Netlink request failed (NLMSG_ERROR)");
+				}
+				if( consistent)
+					handler( msg);
+			}
+		}
+	}
+
+	std::string format_address( int family, const void* addr)
+	{
+		char buffer[INET6_ADDRSTRLEN];
+		if( inet_ntop( family, addr, buffer, sizeof(buffer)) == nullptr)
+			return std::string();
+		return buffer;
+	}
+
+	std::string format_hardware_address( const unsigned char* addr, size_t len, char separationChar)
+	{
+		std::ostringstream str;
+		str << std::hex << std::uppercase << std::setfill('0');
+
+		for( size_t i = 0; i < len; ++i)
+		{
+			if( i > 0)
+				str << separationChar;
+			str << std::setw(2) << static_cast<int>(addr[i]);
+		}
+		return str.str();
+	}
+
 	// check and copy the name of the interface
 	void assign_ifreq( struct ifreq& ifr, const std::string& interface)
 	{
@@ -83,57 +180,112 @@ uint16_t NET::resolveService( const std::string& service, const std::string& pro
 	return 0;
 }
 
-/* This function does not understand interfaces with multiple addresses
- * For example when using zeroconf (eth0, eth0:avahi) it would only list eth0
- * In this case eth0 does not have an ip address yet and getInterfaceAddress("eth0") throws
-std::vector<std::string> NET::getNetworkInterfaces()
+std::vector<InterfaceInfo> NET::getInterfaceInfo()
 {
-	std::vector<std::string> ret;
-	struct if_nameindex* index = if_nameindex();
-	if(index == nullptr) return ret;
+	netlink_socket sock;
+	std::vector<InterfaceInfo> ret;
+	std::map<unsigned, size_t> indices;
 
-	for( int i = 0; (index[i].if_index != 0); ++i)
-		ret.push_back( std::string( index[i].if_name));
-
-	if_freenameindex(index);
-	return ret;
-}
-*/
+	const auto links = [&]( const nlmsghdr* msg)
+	{
+		if( msg->nlmsg_type != RTM_NEWLINK)
+			return;
 
-std::vector<std::string> NET::getNetworkInterfaces()
-{
-	std::vector<std::string> ret;
-	// maximum of number interfaces
-	char data[32 * sizeof(struct ifreq)];
-	struct ifconf conf;
-	struct ifreq *ifr;
+		const ifinfomsg* link = static_cast<const ifinfomsg*>(NLMSG_DATA(msg));
+		InterfaceInfo info;
+		info.index = static_cast<unsigned>(link->ifi_index);
+		info.flags = link->ifi_flags;
+		info.mtu = 0;
 
-	conf.ifc_len = sizeof(data);
-	conf.ifc_buf = (caddr_t) data;
+		unsigned len = static_cast<unsigned>(IFLA_PAYLOAD(msg));
+		for( const rtattr* attr = IFLA_RTA(link); RTA_OK(attr, len); attr = RTA_NEXT(attr, len))
+		{
+			switch( attr->rta_type)
+			{
+			case IFLA_IFNAME:
+				info.name = static_cast<const char*>(RTA_DATA(attr));
+				break;
+			case IFLA_MTU:
+				std::memcpy( &info.mtu, RTA_DATA(attr), sizeof(info.mtu));
+				break;
+			case IFLA_ADDRESS:
+				info.hardwareAddress = format_hardware_address( static_cast<const unsigned char*>(RTA_DATA(attr)),
+				                                                RTA_PAYLOAD(attr), ':');
+				break;
+			default:
+				break;
+			}
+		}
 
-	temp_socket sock;
-	if( ioctl( sock.nativeHandle(), SIOCGIFCONF, &conf) < 0)
-		throw SocketException("ioctl failed (getNetworkInterfaces)");
+		indices[info.index] = ret.size();
+		ret.push_back( info);
+	};
 
-	ifr = (struct ifreq*)data;
-	while( (char*)ifr < data+conf.ifc_len)
+	const auto addresses = [&]( const nlmsghdr* msg)
 	{
-		switch(ifr->ifr_addr.sa_family)
+		if( msg->nlmsg_type != RTM_NEWADDR)
+			return;
+
+		const ifaddrmsg* addr = static_cast<const ifaddrmsg*>(NLMSG_DATA(msg));
+		std::map<unsigned, size_t>::const_iterator it = indices.find( addr->ifa_index);
+		if( it == indices.end() || (addr->ifa_family != AF_INET && addr->ifa_family != AF_INET6))
+			return;
+
+		InterfaceInfo::Address address;
+		address.family = addr->ifa_family;
+		address.prefixLength = addr->ifa_prefixlen;
+
+		// IFA_ADDRESS is the peer on point to point links, IFA_LOCAL the own address
+		std::string local;
+		unsigned len = static_cast<unsigned>(IFA_PAYLOAD(msg));
+		for( const rtattr* attr = IFA_RTA(addr); RTA_OK(attr, len); attr = RTA_NEXT(attr, len))
 		{
-		case AF_INET:
-			ret.push_back( std::string(ifr->ifr_name));
-			//printf("%s : %s\n", ifr->ifr_name, inet_ntop(ifr->ifr_addr.sa_family, &((struct sockaddr_in*)&ifr->ifr_addr)->sin_addr, addrbuf, sizeof(addrbuf)));
-			break;
-	#if 0
-		case AF_INET6:
-			printf("%s : %s\n", ifr->ifr_name, inet_ntop(ifr->ifr_addr.sa_family, &((struct sockaddr_in6*)&ifr->ifr_addr)->sin6_addr, addrbuf, sizeof(addrbuf)));
-			break;
-	#endif
-		default:
-			break;
+			switch( attr->rta_type)
+			{
+			case IFA_ADDRESS:
+				address.address = format_address( addr->ifa_family, RTA_DATA(attr));
+				break;
+			case IFA_LOCAL:
+				local = format_address( addr->ifa_family, RTA_DATA(attr));
+				break;
+			case IFA_BROADCAST:
+				address.broadcast = format_address( addr->ifa_family, RTA_DATA(attr));
+				break;
+			case IFA_LABEL:
+				address.label = static_cast<const char*>(RTA_DATA(attr));
+				break;
+			default:
+				break;
+			}
 		}
-		++ifr;
+		if( !local.empty())
+			address.address = local;
+
+		ret[it->second].addresses.push_back( address);
+	};
+
+	// start over if an interface or address changed during a dump
+	uint32_t seq = 0;
+	for( unsigned attempt = 0; ; ++attempt)
+	{
+		if( attempt == MAX_DUMP_ATTEMPTS)
+			throw SocketException("Netlink request failed, the interfaces keep changing", false);
+
+		ret.clear();
+		indices.clear();
+		if( netlink_dump( sock, RTM_GETLINK, ++seq, links) && netlink_dump( sock, RTM_GETADDR, ++seq, addresses))
+			break;
 	}
+
+	std::sort( ret.begin(), ret.end(), []( const InterfaceInfo& a, const InterfaceInfo& b) { return a.index < b.index; });
+	return ret;
+}
+
+std::vector<std::string> NET::getNetworkInterfaces()
+{
+	std::vector<std::string> ret;
+	for( const InterfaceInfo& info : getInterfaceInfo())
+		ret.push_back( info.name);
 	return ret;
 }
 
@@ -3,9 +3,42 @@
 
 #include <vector>
 #include <string>
+#include <cstdint>
 
 namespace NET
 {
+	//! Configuration of a network interface as reported by getInterfaceInfo()
+	struct InterfaceInfo
+	{
+		//! An address assigned to the interface
+		struct Address
+		{
+			int family;                ///< AF_INET or AF_INET6
+			std::string address;       ///< local address, formatted by inet_ntop()
+			unsigned prefixLength;     ///< length of the network prefix in bits
+			std::string broadcast;     ///< IPv4 broadcast address, empty if none
+			std::string label;         ///< IPv4 label of the address (e.g. "eth0:avahi")
+		};
+
+		std::string name;              ///< name of the interface (e.g. "eth0")
+		unsigned index;                ///< interface index
+		unsigned flags;                ///< IFF_UP, IFF_LOOPBACK, ... (see netdevice(7))
+		unsigned mtu;                  ///< MTU in bytes
+		std::string hardwareAddress;   ///< hardware address as hex bytes separated by ':', empty if none
+		std::vector<Address> addresses; ///< all IPv4 and IPv6 addresses of the interface
+	};
+
+	/*!
+	 * Return the configuration of every network interface, including the
+	 * ones that are down or have no address. A single netlink socket
+	 * dumps all links (RTM_GETLINK) and all addresses (RTM_GETADDR), so
+	 * the cost does not grow with a system call per interface.
+	 *
+	 * \return interfaces ordered by index
+	 * \exception SocketException thrown if the netlink request fails
+	 */
+	std::vector<InterfaceInfo> getInterfaceInfo();
+
 	/*!
 	 * Resolve the specified hostname to a standard IPv4 address.
 	 * If the operating system doesn't know the hostname yet this means a DNS lookup.
@@ -26,7 +59,12 @@ namespace NET
 	 */
 	uint16_t resolveService( const std::string& service, const std::string& protocol = "tcp");
 
-	//! Return a list of available network interfaces
+	//! Return the names of all network interfaces ordered by index
+	/*!
+	 * Interfaces without an IPv4 address are listed as well, so calls
+	 * like getInterfaceAddress() may throw for some of them. Use
+	 * getInterfaceInfo() to get the addresses of all interfaces at once.
+	 */
 	std::vector<std::string> getNetworkInterfaces();
 
 	//! Return the IPv4 address of the given network interface
@@ -3,6 +3,7 @@
 
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <poll.h>
 
 using namespace NET;
@@ -28,8 +29,38 @@ int TCPSocket::sendAll( const void* buffer, size_t len)
 	return sent;
 }
 
-void TCPSocket::listen( int backlog /* = 5 */)
+int TCPSocket::connectAndSend( const std::string& foreignAddress, unsigned short foreignPort, const void* buffer, size_t len)
 {
+	sockaddr_in addr;
+	fillAddress( foreignAddress, foreignPort, addr);
+
+	int sent = TEMP_FAILURE_RETRY (::sendto( m_socket, (const raw_type*) buffer, len, MSG_FASTOPEN, (sockaddr*) &addr, sizeof(addr)));
+	if( sent < 0)
+		throw SocketException("Connect failed (sendto)");
+
+	m_peerDisconnected = false;
+	return sent;
+}
+
+bool TCPSocket::fastOpenAccepted() const
+{
+	struct tcp_info info;
+	socklen_t size = sizeof(info);
+
+	if( getsockopt( m_socket, IPPROTO_TCP, TCP_INFO, &info, &size) < 0)
+		throw SocketException("Fetch of connection info failed (getsockopt)");
+
+	return info.tcpi_options & TCPI_OPT_SYN_DATA;
+}
+
+void TCPSocket::listen( int backlog /* = 5 */, int fastOpenQueue /* = 0 */)
+{
+	if( fastOpenQueue > 0)
+	{
+		if( setsockopt( m_socket, IPPROTO_TCP, TCP_FASTOPEN, &fastOpenQueue, sizeof(fastOpenQueue)) < 0)
+			throw SocketException("Enabling Fast Open failed (setsockopt)");
+	}
+
 	int ret = ::listen( m_socket, backlog);
 	if( ret < 0)
 		throw SocketException("listen failed, most likely another socket is already listening on the same port");
@@ -45,6 +45,39 @@ namespace NET
 		 */
 		int sendAll( const void* buffer, size_t len);
 
+		//! establish a connection and send the first data within the SYN
+		/*!
+		 * connectAndSend() replaces a call to connect() followed by send()
+		 * and uses TCP Fast Open (MSG_FASTOPEN) to carry the data already
+		 * within the SYN segment. This saves one round trip for short lived
+		 * connections.
+		 *
+		 * If no Fast Open cookie for the server is cached yet, or the server
+		 * does not support Fast Open, the operating system silently falls
+		 * back to a regular handshake and sends the data afterwards. Use
+		 * fastOpenAccepted() to find out which of both happened.
+		 *
+		 * \param foreignAddress foreign address (IP address or name)
+		 * \param foreignPort foreign port
+		 * \param buffer data to be send
+		 * \param len length of the data to be sent
+		 * \return number of bytes sent
+		 * \exception SocketException thrown if unable to establish connection
+		 */
+		int connectAndSend( const std::string& foreignAddress, unsigned short foreignPort, const void* buffer, size_t len);
+
+		//! returns whether the data sent within the SYN was accepted
+		/*!
+		 * Can be used after connectAndSend() on the client, or on an accepted
+		 * socket on the server. Returns true if the peer acknowledged the
+		 * data carried within the SYN, which means a valid Fast Open cookie
+		 * was used for the connection.
+		 *
+		 * \return true if the SYN data was acknowledged
+		 * \exception SocketException thrown if unable to fetch connection info
+		 */
+		bool fastOpenAccepted() const;
+
 		//! listen for incoming connections
 		/*!
 		 * listen() can be called on a bound socket.
@@ -59,10 +92,18 @@ namespace NET
 		 *
 		 * After starting to listen, use accept to accept incoming connections.
 		 *
+		 * If fastOpenQueue is set to a value > 0, TCP Fast Open is enabled
+		 * on the socket. Clients owning a valid cookie may then send data
+		 * within the SYN (see connectAndSend()). The value limits the number
+		 * of pending Fast Open requests that have not completed the handshake
+		 * yet. Server side Fast Open must also be allowed by the operating
+		 * system (net.ipv4.tcp_fastopen).
+		 *
 		 * \param backlog upper limit of pending incoming connections
+		 * \param fastOpenQueue upper limit of pending Fast Open requests, 0 disables Fast Open
 		 * \exception SocketException
 		 */
-		void listen( int backlog = 5);
+		void listen( int backlog = 5, int fastOpenQueue = 0);
 
 		//! wait for another socket to connect
 		/*!
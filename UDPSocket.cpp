@@ -3,7 +3,10 @@
 
 #include <sys/socket.h>
 #include <arpa/inet.h>
+#include <netinet/udp.h>
 #include <poll.h>
+#include <cstring>
+#include <algorithm>
 
 using namespace NET;
 
@@ -21,11 +24,27 @@ void setBroadcast( int socket)
 		    sizeof(broadcastPermission));
 }
 
-int groupAction( int socket, const std::string& multicastGroup, int action)
+in_addr toAddress( const std::string& address)
+{
+	in_addr addr;
+
+	// no address means any interface
+	if( address.empty())
+	{
+		addr.s_addr = htonl(INADDR_ANY);
+		return addr;
+	}
+
+	if( !inet_aton( address.c_str(), &addr))
+		throw SocketException("Invalid IPv4 address: " + address, false);
+	return addr;
+}
+
+int groupAction( int socket, const in_addr& multicastGroup, const in_addr& interface, int action)
 {
 	struct ip_mreq multicastRequest;
-	multicastRequest.imr_multiaddr.s_addr = inet_addr( multicastGroup.c_str());
-	multicastRequest.imr_interface.s_addr = htonl(INADDR_ANY);
+	multicastRequest.imr_multiaddr = multicastGroup;
+	multicastRequest.imr_interface = interface;
 
 	return( setsockopt( socket,
 			    IPPROTO_IP,
@@ -34,8 +53,71 @@ int groupAction( int socket, const std::string& multicastGroup, int action)
 			    sizeof(multicastRequest)));
 }
 
+int sourceGroupAction( int socket, const std::string& multicastGroup, const std::string& sourceAddress,
+                       const std::string& interfaceAddress, int action)
+{
+	struct ip_mreq_source multicastRequest;
+	multicastRequest.imr_multiaddr = toAddress( multicastGroup);
+	multicastRequest.imr_sourceaddr = toAddress( sourceAddress);
+	multicastRequest.imr_interface = toAddress( interfaceAddress);
+
+	return( setsockopt( socket,
+			    IPPROTO_IP,
+			    action,
+			    (raw_type*)&multicastRequest,
+			    sizeof(multicastRequest)));
+}
+
+void sendSegmented( int socket, const void* buffer, size_t len, unsigned short segmentSize, sockaddr_in* destAddr)
+{
+	char control[CMSG_SPACE(sizeof(uint16_t))];
+	std::memset( control, 0, sizeof(control));
+
+	struct iovec iov;
+	iov.iov_base = const_cast<raw_type*>(buffer);
+	iov.iov_len = len;
+
+	struct msghdr msg;
+	std::memset( &msg, 0, sizeof(msg));
+	msg.msg_name = destAddr;
+	msg.msg_namelen = destAddr ? sizeof(*destAddr) : 0;
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_UDP;
+	cmsg->cmsg_type = UDP_SEGMENT;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+	uint16_t size = segmentSize;
+	std::memcpy( CMSG_DATA(cmsg), &size, sizeof(size));
+
+	int sent = TEMP_FAILURE_RETRY (::sendmsg( socket, &msg, 0));
+
+	// Write out the whole buffer as a single message
+	if( sent != (int)len)
+		throw SocketException("Send failed (sendmsg)");
+}
+
 } // namespace
 
+UDPSocket::SegmentIterator::SegmentIterator( const void* buffer, size_t len, size_t segmentSize)
+: m_pos( static_cast<const char*>(buffer))
+, m_end( static_cast<const char*>(buffer) + len)
+, m_segmentSize( segmentSize ? segmentSize : len)
+{}
+
+bool UDPSocket::SegmentIterator::next( const void*& data, size_t& len)
+{
+	if( m_pos >= m_end) return false;
+
+	data = m_pos;
+	len = std::min( m_segmentSize, static_cast<size_t>(m_end - m_pos));
+	m_pos += len;
+	return true;
+}
+
 UDPSocket::UDPSocket()
 : InternetSocket( DATAGRAM, IPPROTO_UDP)
 {
@@ -54,6 +136,66 @@ void UDPSocket::sendTo( const void* buffer, size_t len, const std::string& forei
 		throw SocketException("Send failed (sendto)");
 }
 
+void UDPSocket::sendSegments( const void* buffer, size_t len, unsigned short segmentSize)
+{
+	sendSegmented( m_socket, buffer, len, segmentSize, nullptr);
+}
+
+void UDPSocket::sendSegmentsTo( const void* buffer, size_t len, unsigned short segmentSize,
+                                const std::string& foreignAddress, unsigned short foreignPort)
+{
+	sockaddr_in destAddr;
+	fillAddress( foreignAddress, foreignPort, destAddr);
+
+	sendSegmented( m_socket, buffer, len, segmentSize, &destAddr);
+}
+
+void UDPSocket::setReceiveOffload( bool enable)
+{
+	int gro = enable;
+	if( setsockopt( m_socket,
+	                SOL_UDP,
+	                UDP_GRO,
+	                (raw_type*)&gro,
+	                sizeof(gro)) < 0)
+		throw SocketException("Set receive offload failed (setsockopt)");
+}
+
+int UDPSocket::receiveSegments( void* buffer, size_t len, unsigned short& segmentSize)
+{
+	char control[CMSG_SPACE(sizeof(int))];
+
+	struct iovec iov;
+	iov.iov_base = buffer;
+	iov.iov_len = len;
+
+	struct msghdr msg;
+	std::memset( &msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control;
+	msg.msg_controllen = sizeof(control);
+
+	int ret = TEMP_FAILURE_RETRY (::recvmsg( m_socket, &msg, 0));
+	if( ret < 0)
+		throw SocketException("Receive failed (recvmsg)");
+
+	// a single datagram carries no segment size
+	segmentSize = static_cast<unsigned short>(ret);
+
+	for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if( cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+		{
+			int size;
+			std::memcpy( &size, CMSG_DATA(cmsg), sizeof(size));
+			segmentSize = static_cast<unsigned short>(size);
+		}
+	}
+
+	return ret;
+}
+
 int UDPSocket::receiveFrom( void* buffer, size_t len, std::string& sourceAddress, unsigned short& sourcePort)
 {
 	sockaddr_in clientAddr;
@@ -114,12 +256,112 @@ void UDPSocket::setMulticastInterfaceAddr( const std::string& address)
 
 void UDPSocket::joinGroup( const std::string& multicastGroup)
 {
-	if( groupAction( m_socket, multicastGroup, IP_ADD_MEMBERSHIP) < 0)
+	joinGroup( multicastGroup, "");
+}
+
+void UDPSocket::joinGroup( const std::string& multicastGroup, const std::string& interfaceAddress)
+{
+	if( groupAction( m_socket, toAddress( multicastGroup), toAddress( interfaceAddress), IP_ADD_MEMBERSHIP) < 0)
 		throw SocketException("Multicast group join failed (setsockopt)");
 }
 
 void UDPSocket::leaveGroup( const std::string& multicastGroup)
 {
-	if( groupAction( m_socket, multicastGroup, IP_DROP_MEMBERSHIP) < 0)
+	leaveGroup( multicastGroup, "");
+}
+
+void UDPSocket::leaveGroup( const std::string& multicastGroup, const std::string& interfaceAddress)
+{
+	if( groupAction( m_socket, toAddress( multicastGroup), toAddress( interfaceAddress), IP_DROP_MEMBERSHIP) < 0)
+		throw SocketException("Multicast group leave failed (setsockopt)");
+}
+
+void UDPSocket::joinGroups( const std::vector<std::string>& multicastGroups, const std::string& interfaceAddress /* = "" */)
+{
+	// convert all addresses first, so no group is joined if one is invalid
+	in_addr interface = toAddress( interfaceAddress);
+	std::vector<in_addr> groups;
+	groups.reserve( multicastGroups.size());
+	for( const std::string& group : multicastGroups)
+		groups.push_back( toAddress( group));
+
+	for( size_t i = 0; i < groups.size(); ++i)
+	{
+		if( groupAction( m_socket, groups[i], interface, IP_ADD_MEMBERSHIP) < 0)
+		{
+			SocketException error("Multicast group join failed (setsockopt)");
+			while( i--)
+				groupAction( m_socket, groups[i], interface, IP_DROP_MEMBERSHIP);
+			throw error;
+		}
+	}
+}
+
+void UDPSocket::leaveGroups( const std::vector<std::string>& multicastGroups, const std::string& interfaceAddress /* = "" */)
+{
+	in_addr interface = toAddress( interfaceAddress);
+	std::vector<in_addr> groups;
+	groups.reserve( multicastGroups.size());
+	for( const std::string& group : multicastGroups)
+		groups.push_back( toAddress( group));
+
+	bool failed = false;
+	int error = 0;
+	for( const in_addr& group : groups)
+	{
+		if( groupAction( m_socket, group, interface, IP_DROP_MEMBERSHIP) < 0 && !failed)
+		{
+			failed = true;
+			error = errno;
+		}
+	}
+
+	if( failed)
+	{
+		errno = error;
 		throw SocketException("Multicast group leave failed (setsockopt)");
+	}
+}
+
+void UDPSocket::joinSourceGroup( const std::string& multicastGroup, const std::string& sourceAddress,
+                                 const std::string& interfaceAddress /* = "" */)
+{
+	if( sourceGroupAction( m_socket, multicastGroup, sourceAddress, interfaceAddress, IP_ADD_SOURCE_MEMBERSHIP) < 0)
+		throw SocketException("Multicast source group join failed (setsockopt)");
+}
+
+void UDPSocket::leaveSourceGroup( const std::string& multicastGroup, const std::string& sourceAddress,
+                                  const std::string& interfaceAddress /* = "" */)
+{
+	if( sourceGroupAction( m_socket, multicastGroup, sourceAddress, interfaceAddress, IP_DROP_SOURCE_MEMBERSHIP) < 0)
+		throw SocketException("Multicast source group leave failed (setsockopt)");
+}
+
+void UDPSocket::setSourceFilter( const std::string& multicastGroup, SourceFilterMode mode,
+                                 const std::vector<std::string>& sourceAddresses,
+                                 const std::string& interfaceAddress /* = "" */)
+{
+	std::vector<in_addr> sources;
+	sources.reserve( sourceAddresses.size());
+	for( const std::string& source : sourceAddresses)
+		sources.push_back( toAddress( source));
+
+	if( setipv4sourcefilter( m_socket,
+	                         toAddress( interfaceAddress),
+	                         toAddress( multicastGroup),
+	                         mode,
+	                         static_cast<uint32_t>(sources.size()),
+	                         sources.data()) < 0)
+		throw SocketException("Multicast set source filter failed (setipv4sourcefilter)");
+}
+
+void UDPSocket::setMulticastAll( bool enable)
+{
+	int all = enable;
+	if( setsockopt( m_socket,
+	                IPPROTO_IP,
+	                IP_MULTICAST_ALL,
+	                (raw_type*)&all,
+	                sizeof(all)) < 0)
+		throw SocketException("Multicast set receive all failed (setsockopt)");
 }
@@ -3,12 +3,61 @@
 
 #include "InternetSocket.h"
 
+#include <netinet/in.h>
+#include <vector>
+
 namespace NET
 {
 	//! UDP socket class
 	class UDPSocket : public InternetSocket
 	{
 	public:
+		enum SourceFilterMode
+		{
+			INCLUDE_SOURCES = MCAST_INCLUDE, ///< receive only from the listed sources
+			EXCLUDE_SOURCES = MCAST_EXCLUDE  ///< receive from all but the listed sources
+		};
+
+		//! Splits a buffer filled by receiveSegments() into single datagrams
+		/*!
+		 * All datagrams within the buffer have the same size, except the
+		 * last one which may be shorter.
+		 *
+		 * Usage example:
+		 * \code
+		 * unsigned short segmentSize;
+		 * int len = socket.receiveSegments( buffer, sizeof(buffer), segmentSize);
+		 * UDPSocket::SegmentIterator it( buffer, len, segmentSize);
+		 * const void* datagram;
+		 * size_t datagramLen;
+		 * while( it.next( datagram, datagramLen))
+		 *   process( datagram, datagramLen);
+		 * \endcode
+		 */
+		class SegmentIterator
+		{
+		public:
+			/*!
+			 * \param buffer buffer filled by receiveSegments()
+			 * \param len number of bytes received
+			 * \param segmentSize segment size returned by receiveSegments()
+			 */
+			SegmentIterator( const void* buffer, size_t len, size_t segmentSize);
+
+			/*!
+			 * Fetch the next datagram from the buffer.
+			 * \param data set to the start of the datagram
+			 * \param len set to the length of the datagram
+			 * \return false if there are no datagrams left
+			 */
+			bool next( const void*& data, size_t& len);
+
+		private:
+			const char* m_pos;
+			const char* m_end;
+			size_t m_segmentSize;
+		};
+
 		/*!
 		 * Construct a UDP socket and enable broadcast capabilities
 		 * \exception SocketException thrown if unable to create the socket
@@ -36,6 +85,66 @@ namespace NET
 		 */
 		void sendTo( const void* buffer, size_t len, const std::string& foreignAddress, unsigned short foreignPort);
 
+		/*!
+		 * Send the given buffer as a series of equally sized UDP datagrams
+		 * through a connected socket, using a single system call.
+		 *
+		 * The buffer is split by the operating system (UDP generic segmentation
+		 * offload) into datagrams of segmentSize bytes, the last datagram may be
+		 * shorter. This saves most of the per datagram overhead of send().
+		 *
+		 * The whole buffer must not exceed 64 KiB and may not contain more
+		 * than 64 segments. Each segment must fit into the path MTU.
+		 *
+		 * \param buffer data to be send
+		 * \param len number of bytes to write
+		 * \param segmentSize size of every single datagram
+		 * \exception SocketException thrown if unable to send the datagrams
+		 */
+		void sendSegments( const void* buffer, size_t len, unsigned short segmentSize);
+
+		/*!
+		 * Like sendSegments(), but sends the datagrams to the specified
+		 * address / port instead of the connected peer.
+		 *
+		 * \param buffer data to be send
+		 * \param len number of bytes to write
+		 * \param segmentSize size of every single datagram
+		 * \param foreignAddress address (IP address or name) to send to
+		 * \param foreignPort port number to send to
+		 * \exception SocketException thrown if unable to send the datagrams
+		 */
+		void sendSegmentsTo( const void* buffer, size_t len, unsigned short segmentSize,
+		                     const std::string& foreignAddress, unsigned short foreignPort);
+
+		/*!
+		 * Enable or disable coalescing of received datagrams (UDP generic
+		 * receive offload). If enabled, the operating system may merge
+		 * several datagrams of the same flow into one buffer. Use
+		 * receiveSegments() to read those buffers.
+		 *
+		 * \param enable true to enable receive offload
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setReceiveOffload( bool enable);
+
+		/*!
+		 * Read up to len bytes data from this socket. If receive offload
+		 * is enabled, the buffer may contain several datagrams, each of them
+		 * segmentSize bytes long, except the last one.
+		 *
+		 * Use SegmentIterator to split the buffer into the datagrams. The
+		 * buffer should be large enough to hold 64 KiB, otherwise data of
+		 * coalesced datagrams will be discarded.
+		 *
+		 * \param buffer buffer to receive data
+		 * \param len maximum number of bytes to receive
+		 * \param segmentSize size of the contained datagrams
+		 * \return number of bytes received
+		 * \exception SocketException thrown if unable to receive datagrams
+		 */
+		int receiveSegments( void* buffer, size_t len, unsigned short& segmentSize);
+
 		/*!
 		 * Read up to len bytes data from this socket. The given buffer
 		 * is where the data will be placed.
@@ -86,24 +195,121 @@ namespace NET
 		void setMulticastInterfaceAddr( const std::string& address);
 
 		/*!
-		 * Join the specified multicast group
+		 * Join the specified multicast group on any interface
 		 *
-		 * The multicast group has to be a valid multicast IP Address (224.0.0.0/24)
+		 * The multicast group has to be a valid multicast IP Address (224.0.0.0/4)
 		 *
 		 * \param multicastGroup multicast group address to join
 		 * \exception SocketException thrown if unable to join group
 		 */
 		void joinGroup( const std::string& multicastGroup);
 
+		/*!
+		 * \overload
+		 * Join the specified multicast group only on the interface
+		 * with the given address.
+		 *
+		 * \param multicastGroup multicast group address to join
+		 * \param interfaceAddress IP address of the interface to join on
+		 * \exception SocketException thrown if unable to join group
+		 */
+		void joinGroup( const std::string& multicastGroup, const std::string& interfaceAddress);
+
 		/*!
 		 * Leave the specified multicast group
 		 *
-		 * The multicast group has to be a valid multicast IP Address (224.0.0.0/24)
+		 * The multicast group has to be a valid multicast IP Address (224.0.0.0/4)
 		 *
 		 * \param multicastGroup multicast group address to leave
 		 * \exception SocketException thrown if unable to leave group
 		 */
 		void leaveGroup( const std::string& multicastGroup);
+
+		/*!
+		 * \overload
+		 * Leave the specified multicast group joined on the interface
+		 * with the given address.
+		 *
+		 * \param multicastGroup multicast group address to leave
+		 * \param interfaceAddress IP address of the interface the group was joined on
+		 * \exception SocketException thrown if unable to leave group
+		 */
+		void leaveGroup( const std::string& multicastGroup, const std::string& interfaceAddress);
+
+		/*!
+		 * Join all given multicast groups on the interface with the given
+		 * address. All addresses are checked before the first group is
+		 * joined. If a join fails, the groups joined so far are left again.
+		 *
+		 * \param multicastGroups multicast group addresses to join
+		 * \param interfaceAddress IP address of the interface, empty for any interface
+		 * \exception SocketException thrown if unable to join a group
+		 */
+		void joinGroups( const std::vector<std::string>& multicastGroups, const std::string& interfaceAddress = "");
+
+		/*!
+		 * Leave all given multicast groups on the interface with the given
+		 * address. All groups are tried, even if leaving one of them fails.
+		 *
+		 * \param multicastGroups multicast group addresses to leave
+		 * \param interfaceAddress IP address of the interface, empty for any interface
+		 * \exception SocketException thrown if unable to leave a group
+		 */
+		void leaveGroups( const std::vector<std::string>& multicastGroups, const std::string& interfaceAddress = "");
+
+		/*!
+		 * Join the specified multicast group, but only receive datagrams
+		 * sent by the given source (source specific multicast). Can be
+		 * called several times to add more sources to the same group.
+		 *
+		 * \param multicastGroup multicast group address to join
+		 * \param sourceAddress IP address of the accepted source
+		 * \param interfaceAddress IP address of the interface, empty for any interface
+		 * \exception SocketException thrown if unable to join group
+		 */
+		void joinSourceGroup( const std::string& multicastGroup, const std::string& sourceAddress,
+		                      const std::string& interfaceAddress = "");
+
+		/*!
+		 * Remove the given source of a source specific multicast group.
+		 * The group is left when the last source is removed.
+		 *
+		 * \param multicastGroup multicast group address
+		 * \param sourceAddress IP address of the source to remove
+		 * \param interfaceAddress IP address of the interface, empty for any interface
+		 * \exception SocketException thrown if unable to leave group
+		 */
+		void leaveSourceGroup( const std::string& multicastGroup, const std::string& sourceAddress,
+		                       const std::string& interfaceAddress = "");
+
+		/*!
+		 * Replace the complete source filter of a joined multicast group
+		 * with a single call. The group has to be joined before, e.g. by
+		 * joinGroups(). An include filter with an empty source list leaves
+		 * the group, an exclude filter with an empty list accepts any source.
+		 *
+		 * The number of sources is limited by the operating system
+		 * (net.ipv4.igmp_max_msf).
+		 *
+		 * \param multicastGroup multicast group address
+		 * \param mode whether the sources are included or excluded
+		 * \param sourceAddresses IP addresses of the sources
+		 * \param interfaceAddress IP address of the interface, empty for any interface
+		 * \exception SocketException thrown if unable to set the filter
+		 */
+		void setSourceFilter( const std::string& multicastGroup, SourceFilterMode mode,
+		                      const std::vector<std::string>& sourceAddresses,
+		                      const std::string& interfaceAddress = "");
+
+		/*!
+		 * Control whether the socket receives datagrams of all multicast
+		 * groups joined by any socket on the system (the Linux default), or
+		 * only datagrams of the groups joined by this socket.
+		 *
+		 * \param enable true to receive datagrams of all joined groups
+		 * \exception SocketException thrown if unable to set the option
+		 */
+		void setMulticastAll( bool enable);
 	};
 
 } // namespace NET
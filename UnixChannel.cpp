@@ -0,0 +1,109 @@
+#include "UnixChannel.h"
+
+#include <sys/socket.h>
+
+using namespace NET;
+
+void UnixChannel::create( Handle& first, Handle& second)
+{
+	int fds[2];
+	if( ::socketpair( AF_LOCAL, SOCK_SEQPACKET, 0, fds) < 0)
+		throw SocketException("Channel creation failed (socketpair)");
+
+	first = Handle(fds[0]);
+	second = Handle(fds[1]);
+}
+
+UnixChannel::UnixChannel( Handle handle, unsigned coalesce /* = 1 */)
+: UnixSeqPacketSocket( handle.release() )
+, m_coalesce( coalesce ? coalesce : 1)
+{
+	m_offsets.reserve( m_coalesce + 1);
+}
+
+UnixChannel::~UnixChannel()
+{
+	// a consumer that stopped reading must not block the destruction
+	try
+	{
+		flushMessages( MSG_DONTWAIT);
+	}
+	catch( SocketException&)
+	{
+		// the peer is gone or its queue is full, the rest is dropped
+	}
+}
+
+void UnixChannel::post( const void* buffer, size_t len)
+{
+	if( len == 0)
+		throw SocketException("Empty messages can not be posted", false);
+
+	// offsets holds the start of every message and the end of the last one
+	if( m_offsets.empty())
+		m_offsets.push_back(0);
+
+	const uint8_t* data = static_cast<const uint8_t*>(buffer);
+	m_pending.insert( m_pending.end(), data, data + len);
+	m_offsets.push_back( m_pending.size());
+
+	if( pending() >= m_coalesce)
+		flush();
+}
+
+void UnixChannel::flush()
+{
+	flushMessages(0);
+}
+
+void UnixChannel::flushMessages( int flags)
+{
+	unsigned count = pending();
+	if( count == 0)
+		return;
+
+	std::vector<const void*> buffers( count);
+	std::vector<size_t> lens( count);
+	for( unsigned i = 0; i < count; ++i)
+	{
+		buffers[i] = m_pending.data() + m_offsets[i];
+		lens[i] = m_offsets[i + 1] - m_offsets[i];
+	}
+
+	// the buffers stay valid until every message is sent, sendMessages() throws on failure
+	unsigned sent = 0;
+	try
+	{
+		while( sent < count)
+			sent += sendMessages( &buffers[sent], &lens[sent], count - sent, flags);
+	}
+	catch( SocketException&)
+	{
+		m_pending.erase( m_pending.begin(), m_pending.begin() + static_cast<std::ptrdiff_t>(m_offsets[sent]));
+		size_t base = m_offsets[sent];
+		m_offsets.erase( m_offsets.begin(), m_offsets.begin() + sent);
+		for( size_t& offset : m_offsets)
+			offset -= base;
+		throw;
+	}
+
+	m_pending.clear();
+	m_offsets.clear();
+}
+
+unsigned UnixChannel::pending() const
+{
+	return m_offsets.empty() ? 0 : static_cast<unsigned>(m_offsets.size() - 1);
+}
+
+unsigned UnixChannel::coalescing() const
+{
+	return m_coalesce;
+}
+
+void UnixChannel::setCoalescing( unsigned coalesce)
+{
+	m_coalesce = coalesce ? coalesce : 1;
+	if( pending() >= m_coalesce)
+		flush();
+}
@@ -0,0 +1,108 @@
+#ifndef NET_UnixChannel_h__
+#define NET_UnixChannel_h__
+
+#include "UnixSeqPacketSocket.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace NET
+{
+	//! One end of an unnamed message channel between threads
+	/*!
+	 * A channel is a connected pair of sequenced packet sockets created by
+	 * socketpair(), so no path in the filesystem is needed and nothing has
+	 * to be unlinked. Both ends can send and receive, message boundaries
+	 * are kept. Each end offers the sending and receiving functions of a
+	 * UnixSeqPacketSocket including the batched ones, and nativeHandle()
+	 * can be polled together with any other socket. The ends are
+	 * connected already, so binding, listening and connecting are not
+	 * available.
+	 *
+	 * With coalescing, post() collects messages and hands them to the
+	 * kernel in one sendmmsg() once the given number is reached or
+	 * flush() is called. The receiver is woken once per flush instead of
+	 * once per message and fetches the whole burst with receiveBatch().
+	 *
+	 * Usage example:
+	 * \code
+	 * UnixChannel::Handle first, second;
+	 * UnixChannel::create( first, second);
+	 * UnixChannel producer( first, 32);
+	 * UnixChannel consumer( second);
+	 * // producer thread
+	 * producer.post( &update, sizeof(update));
+	 * producer.flush();
+	 * // consumer thread
+	 * unsigned count = consumer.receiveBatch( buffers, maxLens, lens, 32);
+	 * \endcode
+	 */
+	class UnixChannel : private UnixSeqPacketSocket
+	{
+	public:
+		//! Handle for one end of a new channel
+		typedef SocketHandle<UnixChannel> Handle;
+
+		/*!
+		 * Create a channel, each handle becomes one of its ends.
+		 * \param first set to one end of the channel
+		 * \param second set to the other end of the channel
+		 * \exception SocketException thrown if unable to create the channel
+		 */
+		static void create( Handle& first, Handle& second);
+
+		/*!
+		 * Construct one end of a channel from a Handle returned by create()
+		 * \param handle end of the channel
+		 * \param coalesce number of messages post() collects before sending them, 1 to send at once
+		 * \exception SocketException thrown if handle is invalid
+		 */
+		UnixChannel( Handle handle, unsigned coalesce = 1);
+
+		//! sends messages still collected by post() without blocking, messages that do not fit are dropped
+		~UnixChannel();
+
+		using UnixSeqPacketSocket::nativeHandle;
+		using UnixSeqPacketSocket::send;
+		using UnixSeqPacketSocket::receive;
+		using UnixSeqPacketSocket::timedReceive;
+		using UnixSeqPacketSocket::sendBatch;
+		using UnixSeqPacketSocket::receiveBatch;
+		using UnixSeqPacketSocket::timedReceiveBatch;
+		using UnixSeqPacketSocket::peerDisconnected;
+
+		/*!
+		 * Queue a copy of the message, send all collected messages once
+		 * the coalescing limit is reached.
+		 * \param buffer message to send
+		 * \param len length of the message, an empty message reads like the end of the channel
+		 * \exception SocketException thrown if the message is empty or unable to send
+		 */
+		void post( const void* buffer, size_t len);
+
+		/*!
+		 * Send all messages collected by post().
+		 * \exception SocketException thrown if unable to send
+		 */
+		void flush();
+
+		//! return the number of messages collected by post() but not sent yet
+		unsigned pending() const;
+
+		//! return the number of messages post() collects before sending them
+		unsigned coalescing() const;
+
+		//! change the number of messages post() collects, pending messages are sent if the limit is reached
+		void setCoalescing( unsigned coalesce);
+
+	private:
+		void flushMessages( int flags);
+
+		std::vector<uint8_t> m_pending;
+		std::vector<size_t> m_offsets;
+		unsigned m_coalesce;
+	};
+
+} // namespace NET
+
+#endif // NET_UnixChannel_h__
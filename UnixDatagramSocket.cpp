@@ -4,9 +4,58 @@
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <poll.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 using namespace NET;
 
+namespace {
+
+// number of datagrams passed to one sendmmsg() call
+const unsigned BATCH_SIZE = 64;
+
+// errors concerning the datagram or the socket rather than a single destination
+bool isFatal( int error)
+{
+	return error == EMSGSIZE || error == EBADF || error == ENOTSOCK || error == EFAULT || error == EINVAL;
+}
+
+} // namespace
+
+void UnixDatagramSocket::SubscriberSet::add( const std::string& path)
+{
+	if( std::find( m_paths.begin(), m_paths.end(), path) != m_paths.end())
+		return;
+
+	sockaddr_un addr;
+	fillAddress( path, addr);
+
+	m_paths.push_back( path);
+	m_addresses.push_back( addr);
+	m_results.push_back( 0);
+}
+
+bool UnixDatagramSocket::SubscriberSet::remove( const std::string& path)
+{
+	std::vector<std::string>::iterator it = std::find( m_paths.begin(), m_paths.end(), path);
+	if( it == m_paths.end())
+		return false;
+
+	size_t index = static_cast<size_t>(it - m_paths.begin());
+	m_paths.erase( it);
+	m_addresses.erase( m_addresses.begin() + static_cast<std::ptrdiff_t>(index));
+	m_results.erase( m_results.begin() + static_cast<std::ptrdiff_t>(index));
+	return true;
+}
+
+void UnixDatagramSocket::SubscriberSet::clear()
+{
+	m_paths.clear();
+	m_addresses.clear();
+	m_results.clear();
+}
+
 UnixDatagramSocket::UnixDatagramSocket()
 : UnixSocket( DATAGRAM, 0)
 {}
@@ -23,6 +72,50 @@ void UnixDatagramSocket::sendTo( const void* buffer, size_t len, const std::stri
 		throw SocketException("Send failed (sendto)");
 }
 
+size_t UnixDatagramSocket::sendToAll( const void* buffer, size_t len, SubscriberSet& subscribers)
+{
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iov;
+	iov.iov_base = const_cast<void*>(buffer);
+	iov.iov_len = len;
+
+	const size_t count = subscribers.size();
+	size_t sent = 0;
+	size_t next = 0;
+	while( next < count)
+	{
+		unsigned batch = count - next < BATCH_SIZE ? static_cast<unsigned>(count - next) : BATCH_SIZE;
+
+		// all datagrams share the payload, only the destination differs
+		std::memset( msgs, 0, sizeof(mmsghdr) * batch);
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			msgs[i].msg_hdr.msg_name = &subscribers.m_addresses[next + i];
+			msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_un);
+			msgs[i].msg_hdr.msg_iov = &iov;
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int ret = TEMP_FAILURE_RETRY (::sendmmsg( m_socket, msgs, batch, MSG_DONTWAIT));
+		if( ret < 0)
+		{
+			// sendmmsg only reports the error of the first datagram of a call
+			int error = errno;
+			if( isFatal( error))
+				throw SocketException("Send failed (sendmmsg)");
+			subscribers.m_results[next++] = -error;
+			continue;
+		}
+
+		for( int i = 0; i < ret; ++i)
+			subscribers.m_results[next + static_cast<size_t>(i)] = static_cast<int>(msgs[i].msg_len);
+		sent += static_cast<size_t>(ret);
+		next += static_cast<size_t>(ret);
+	}
+
+	return sent;
+}
+
 int UnixDatagramSocket::receiveFrom( void* buffer, size_t len, std::string& sourcePath)
 {
 	sockaddr_un clientAddr;
@@ -3,12 +3,61 @@
 
 #include "UnixSocket.h"
 
+#include <sys/un.h>
+#include <string>
+#include <vector>
+
 namespace NET
 {
 	//! Unix datagram socket class
 	class UnixDatagramSocket : public UnixSocket
 	{
 	public:
+		//! Destinations a datagram is fanned out to by sendToAll()
+		/*!
+		 * The address of each path is validated and built once when it is
+		 * added, so sending to the set only copies pointers.
+		 */
+		class SubscriberSet
+		{
+		public:
+			/*!
+			 * Add a destination, a path already within the set is ignored.
+			 * \param path filename of the datagram socket of the subscriber
+			 * \exception SocketException thrown if path is not valid
+			 */
+			void add( const std::string& path);
+
+			/*!
+			 * Remove a destination.
+			 * \return false if path is not within the set
+			 */
+			bool remove( const std::string& path);
+
+			//! remove all destinations
+			void clear();
+
+			//! return the number of destinations
+			size_t size() const { return m_paths.size(); }
+
+			//! return the path of the destination at index
+			const std::string& path( size_t index) const { return m_paths.at(index); }
+
+			/*!
+			 * Return the outcome of the last sendToAll() for the destination
+			 * at index: the number of bytes sent or -errno, e.g. -EAGAIN
+			 * for a subscriber whose receive queue is full.
+			 */
+			int result( size_t index) const { return m_results.at(index); }
+
+		private:
+			friend class UnixDatagramSocket;
+
+			std::vector<std::string> m_paths;
+			std::vector<sockaddr_un> m_addresses;
+			std::vector<int> m_results;
+		};
+
 		/*!
 		 * Construct a Unix datagram socket
 		 * \exception SocketException thrown if unable to create the socket
@@ -26,6 +75,21 @@ namespace NET
 		 */
 		void sendTo( const void* buffer, size_t len, const std::string& foreignPath);
 
+		/*!
+		 * Send the given buffer as a datagram to every destination of the
+		 * set, up to 64 destinations per sendmmsg() call.
+		 * The call never blocks: a subscriber that does not keep up or has
+		 * gone away is reported by SubscriberSet::result() and the
+		 * remaining destinations are still served.
+		 *
+		 * \param buffer data to be send
+		 * \param len number of bytes to write
+		 * \param subscribers destinations of the datagram, receive the results
+		 * \return number of destinations the datagram was delivered to
+		 * \exception SocketException thrown if the datagram can not be sent to anyone (e.g. too large)
+		 */
+		size_t sendToAll( const void* buffer, size_t len, SubscriberSet& subscribers);
+
 		/*!
 		 * Read read up to len bytes data from this socket. The given
 		 * buffer is where the data will be placed.
@@ -0,0 +1,189 @@
+#include "UnixSeqPacketSocket.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+// number of messages passed to one sendmmsg() or recvmmsg() call
+const unsigned BATCH_SIZE = 64;
+
+} // namespace
+
+UnixSeqPacketSocket::UnixSeqPacketSocket()
+: UnixSocket( SEQPACKET, 0)
+{}
+
+UnixSeqPacketSocket::UnixSeqPacketSocket( Handle handle)
+: UnixSocket( handle.release() )
+{}
+
+UnixSeqPacketSocket::UnixSeqPacketSocket( int sockfd)
+: UnixSocket( sockfd)
+{}
+
+void UnixSeqPacketSocket::listen( int backlog /* = 5 */)
+{
+	if( ::listen( m_socket, backlog) < 0)
+		throw SocketException("UnixSeqPacketSocket::listen failed (listen)");
+}
+
+UnixSeqPacketSocket::Handle UnixSeqPacketSocket::accept() const
+{
+	int ret = ::accept( m_socket, nullptr, nullptr);
+	if( ret < 0)
+		throw SocketException("UnixSeqPacketSocket::accept failed (accept)");
+	return Handle(ret);
+}
+
+UnixSeqPacketSocket::Handle UnixSeqPacketSocket::timedAccept( int timeout) const
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return Handle();
+	if( ret < 0) throw SocketException("UnixSeqPacketSocket::timedAccept failed (poll)");
+
+	ret = ::accept( m_socket, nullptr, nullptr);
+	if( ret < 0)
+		throw SocketException("UnixSeqPacketSocket::timedAccept failed (accept)");
+	return Handle(ret);
+}
+
+unsigned UnixSeqPacketSocket::sendBatch( const void* const* buffers, const size_t* lens, unsigned count)
+{
+	return sendMessages( buffers, lens, count, 0);
+}
+
+unsigned UnixSeqPacketSocket::sendMessages( const void* const* buffers, const size_t* lens, unsigned count, int flags)
+{
+	// an empty message reads like the end of the connection
+	for( unsigned i = 0; i < count; ++i)
+		if( lens[i] == 0)
+			throw SocketException("Empty messages can not be sent in a batch", false);
+
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iovs[BATCH_SIZE];
+
+	unsigned sent = 0;
+	while( sent < count)
+	{
+		unsigned batch = count - sent < BATCH_SIZE ? count - sent : BATCH_SIZE;
+
+		std::memset( msgs, 0, sizeof(mmsghdr) * batch);
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			iovs[i].iov_base = const_cast<void*>( buffers[sent + i]);
+			iovs[i].iov_len = lens[sent + i];
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		int ret = TEMP_FAILURE_RETRY (::sendmmsg( m_socket, msgs, batch, MSG_NOSIGNAL | flags));
+		if( ret < 0)
+		{
+			if( errno == EPIPE || errno == ECONNRESET)
+				m_peerDisconnected = true;
+
+			// report the messages already sent, the error repeats with the next call
+			if( sent > 0) break;
+			throw SocketException("Send failed (sendmmsg)");
+		}
+
+		sent += static_cast<unsigned>(ret);
+		if( static_cast<unsigned>(ret) < batch) break;
+	}
+
+	return sent;
+}
+
+unsigned UnixSeqPacketSocket::receiveBatch( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count)
+{
+	return receiveMessages( buffers, maxLens, lens, count, MSG_WAITFORONE);
+}
+
+unsigned UnixSeqPacketSocket::timedReceiveBatch( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count,
+                                                 int timeout)
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN | POLLPRI | POLLRDHUP;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return 0;
+	if( ret < 0) throw SocketException("Receive failed (poll)");
+
+	if( poll.revents & POLLRDHUP)
+		m_peerDisconnected = true;
+
+	if( poll.revents & POLLIN || poll.revents & POLLPRI)
+		return receiveMessages( buffers, maxLens, lens, count, MSG_DONTWAIT);
+
+	return 0;
+}
+
+unsigned UnixSeqPacketSocket::receiveMessages( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count,
+                                               int flags)
+{
+	mmsghdr msgs[BATCH_SIZE];
+	iovec iovs[BATCH_SIZE];
+
+	unsigned received = 0;
+	while( received < count)
+	{
+		unsigned batch = count - received < BATCH_SIZE ? count - received : BATCH_SIZE;
+
+		std::memset( msgs, 0, sizeof(mmsghdr) * batch);
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			iovs[i].iov_base = buffers[received + i];
+			iovs[i].iov_len = maxLens[received + i];
+			msgs[i].msg_hdr.msg_iov = &iovs[i];
+			msgs[i].msg_hdr.msg_iovlen = 1;
+		}
+
+		// only the first call may block
+		int ret = TEMP_FAILURE_RETRY (::recvmmsg( m_socket, msgs, batch, received ? MSG_DONTWAIT : flags, nullptr));
+		if( ret < 0)
+		{
+			if( errno == EAGAIN && (received > 0 || flags == MSG_DONTWAIT)) break;
+			throw SocketException("Receive failed (recvmmsg)");
+		}
+
+		// once the peer closed the connection every further read returns an empty message,
+		// so recvmmsg fills the whole batch. A shorter batch ended at the empty queue.
+		unsigned n = static_cast<unsigned>(ret);
+		bool closed = n == batch && msgs[n - 1].msg_len == 0 && peerShutdown();
+		if( closed)
+		{
+			while( n > 1 && msgs[n - 2].msg_len == 0)
+				--n;
+			m_peerDisconnected = true;
+		}
+
+		for( unsigned i = 0; i < n; ++i)
+			lens[received + i] = msgs[i].msg_len;
+		received += n;
+
+		if( n < batch || closed) break;
+	}
+
+	return received;
+}
+
+bool UnixSeqPacketSocket::peerShutdown() const
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLRDHUP;
+
+	return TEMP_FAILURE_RETRY (::poll( &poll, 1, 0)) > 0 && (poll.revents & (POLLRDHUP | POLLHUP));
+}
@@ -0,0 +1,124 @@
+#ifndef NET_UnixSeqPacketSocket_h__
+#define NET_UnixSeqPacketSocket_h__
+
+#include "UnixSocket.h"
+
+namespace NET
+{
+	//! Unix sequenced packet socket class
+	/*!
+	 * A connection oriented local socket that keeps message boundaries
+	 * (SOCK_SEQPACKET). Messages are delivered reliably and in order like
+	 * on a UnixStreamSocket, and every receive returns exactly one message
+	 * like on a UnixDatagramSocket. A sender blocks while the receive
+	 * queue of the peer is full.
+	 *
+	 * Bytes of a message exceeding the receive buffer are discarded.
+	 *
+	 * An empty message can not be told apart from the end of the
+	 * connection, receive() returns 0 for both. sendBatch() therefore
+	 * refuses empty messages. Empty messages sent with send() right before
+	 * the peer shuts the connection down may be taken for its end.
+	 *
+	 * Usage example:
+	 * \code
+	 * UnixSeqPacketSocket client;
+	 * client.connect("/tmp/sidecar.sock");
+	 * const void* messages[] = { header, body };
+	 * size_t lens[] = { headerLen, bodyLen };
+	 * client.sendBatch( messages, lens, 2);
+	 * \endcode
+	 */
+	class UnixSeqPacketSocket : public UnixSocket
+	{
+	public:
+		//! Handle for a new socket returned by accept
+		typedef SocketHandle<UnixSeqPacketSocket> Handle;
+
+		/*!
+		 * Construct a Unix sequenced packet socket
+		 * \exception SocketException thrown if unable to create the socket
+		 */
+		UnixSeqPacketSocket();
+
+		/*!
+		 * Construct a Socket from a Handle returned by accept()
+		 * \exception SocketException thrown if handle is invalid
+		 */
+		UnixSeqPacketSocket( Handle handle);
+
+		//! listen for incoming connections on a bound socket
+		/*!
+		 * \param backlog upper limit of pending incoming connections
+		 * \exception SocketException
+		 */
+		void listen( int backlog = 5);
+
+		//! wait for another socket to connect
+		/*!
+		 * \return SocketHandle object to the new connection
+		 * \exception SocketException
+		 */
+		Handle accept() const;
+
+		//! wait for another socket to connect, return after the given timespan
+		/*!
+		 * \param timeout the timeout in ms after which accept will give up and return
+		 * \return Handle object to the new connection, invalid on timeout
+		 * \exception SocketException
+		 */
+		Handle timedAccept( int timeout) const;
+
+		/*!
+		 * Send a batch of messages with as few system calls as possible.
+		 * If sending fails after some messages were sent, the number of
+		 * sent messages is returned and the error is reported by the
+		 * next call.
+		 *
+		 * \param buffers pointers to the messages
+		 * \param lens lengths of the messages
+		 * \param count number of messages
+		 * \return number of messages sent
+		 * \exception SocketException thrown if a message is empty or unable to send the first message
+		 */
+		unsigned sendBatch( const void* const* buffers, const size_t* lens, unsigned count);
+
+		/*!
+		 * Receive a batch of messages. Blocks until at least one message
+		 * arrived, then fetches the messages already queued without
+		 * waiting any longer. The batch ends with an empty message if the
+		 * peer closed the connection, which also sets peerDisconnected().
+		 *
+		 * \param buffers buffers to receive the messages
+		 * \param maxLens sizes of the buffers
+		 * \param lens set to the lengths of the received messages
+		 * \param count maximum number of messages
+		 * \return number of messages received
+		 * \exception SocketException thrown if unable to receive
+		 */
+		unsigned receiveBatch( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count);
+
+		/*!
+		 * Receive a batch of messages like receiveBatch(), waiting at
+		 * most timeout milliseconds for the first message.
+		 *
+		 * \return number of messages received, 0 on timeout
+		 * \exception SocketException thrown if unable to receive
+		 */
+		unsigned timedReceiveBatch( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count, int timeout);
+
+	protected:
+		//! enables construction from one end of a socket pair
+		explicit UnixSeqPacketSocket( int sockfd);
+
+		//! sendBatch() with additional flags for sendmmsg(), e.g. MSG_DONTWAIT
+		unsigned sendMessages( const void* const* buffers, const size_t* lens, unsigned count, int flags);
+
+	private:
+		unsigned receiveMessages( void* const* buffers, const size_t* maxLens, size_t* lens, unsigned count, int flags);
+		bool peerShutdown() const;
+	};
+
+} // namespace NET
+
+#endif // NET_UnixSeqPacketSocket_h__
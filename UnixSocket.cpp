@@ -1,4 +1,5 @@
 #include "UnixSocket.h"
+#include "TempFailure.h"
 
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -11,6 +12,10 @@ UnixSocket::UnixSocket( int type, int protocol)
 : SimpleSocket( UNIX, type, protocol)
 {}
 
+UnixSocket::UnixSocket( int sockfd)
+: SimpleSocket( sockfd)
+{}
+
 void UnixSocket::connect( const std::string& foreignPath)
 {
 	sockaddr_un addr;
@@ -52,6 +57,90 @@ std::string UnixSocket::getForeignPath() const
 	return extractPath( addr, addr_len);
 }
 
+int UnixSocket::sendFds( const int* fds, size_t count, const void* buffer /* = nullptr */, size_t len /* = 0 */)
+{
+	if( count == 0 || count > MAX_FDS)
+		throw SocketException("Invalid number of file descriptors to send", false);
+
+	// a message without data does not carry the descriptors on stream sockets
+	char dummy = 0;
+	struct iovec iov;
+	iov.iov_base = len ? const_cast<void*>(buffer) : &dummy;
+	iov.iov_len = len ? len : 1;
+
+	std::vector<char> control( CMSG_SPACE(sizeof(int) * count));
+	struct msghdr msg;
+	std::memset( &msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.data();
+	msg.msg_controllen = control.size();
+
+	cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int) * count);
+	std::memcpy( CMSG_DATA(cmsg), fds, sizeof(int) * count);
+
+	int sent = TEMP_FAILURE_RETRY (::sendmsg( m_socket, &msg, MSG_NOSIGNAL));
+	if( sent < 0)
+	{
+		if( errno == EPIPE || errno == ECONNRESET)
+			m_peerDisconnected = true;
+		throw SocketException("Send of file descriptors failed (sendmsg)");
+	}
+	return sent;
+}
+
+int UnixSocket::receiveFds( void* buffer, size_t len, std::vector<int>& fds, size_t maxFds /* = MAX_FDS */)
+{
+	fds.clear();
+
+	struct iovec iov;
+	iov.iov_base = buffer;
+	iov.iov_len = len;
+
+	std::vector<char> control( CMSG_SPACE(sizeof(int) * (maxFds ? maxFds : 1)));
+	struct msghdr msg;
+	std::memset( &msg, 0, sizeof(msg));
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = control.data();
+	msg.msg_controllen = control.size();
+
+	int ret = TEMP_FAILURE_RETRY (::recvmsg( m_socket, &msg, MSG_CMSG_CLOEXEC));
+	if( ret < 0)
+		throw SocketException("Receive of file descriptors failed (recvmsg)");
+
+	for( cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+	{
+		if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS)
+		{
+			size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+			size_t first = fds.size();
+			fds.resize( first + count);
+			std::memcpy( &fds[first], CMSG_DATA(cmsg), sizeof(int) * count);
+		}
+	}
+
+	if( ret == 0 && len > 0)
+		m_peerDisconnected = true;
+	return ret;
+}
+
+int UnixSocket::receiveSingleFd()
+{
+	char dummy;
+	std::vector<int> fds;
+	receiveFds( &dummy, 1, fds);
+
+	// only the first descriptor is expected, do not leak the others
+	for( size_t i = 1; i < fds.size(); ++i)
+		TEMP_FAILURE_RETRY (::close( fds[i]));
+
+	return fds.empty() ? -1 : fds[0];
+}
+
 void UnixSocket::fillAddress( const std::string& path, sockaddr_un& addr)
 {
 	// needed space is size plus null character
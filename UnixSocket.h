@@ -2,6 +2,9 @@
 #define NET_UnixSocket_h__
 
 #include "SimpleSocket.h"
+#include "SocketHandle.h"
+
+#include <vector>
 
 struct sockaddr_un;
 
@@ -42,10 +45,81 @@ namespace NET
 		 */
 		std::string getForeignPath() const;
 
+		/*!
+		 * Pass open file descriptors to the connected peer (SCM_RIGHTS).
+		 * The peer receives duplicates, the descriptors stay open in this
+		 * process. At least one byte of data has to be sent along, a
+		 * single zero byte is sent if no data is given.
+		 *
+		 * \param fds file descriptors to pass, at most MAX_FDS
+		 * \param count number of file descriptors
+		 * \param buffer data sent along with the descriptors
+		 * \param len length of the data
+		 * \return number of bytes sent
+		 * \exception SocketException thrown if unable to send
+		 */
+		int sendFds( const int* fds, size_t count, const void* buffer = nullptr, size_t len = 0);
+
+		/*!
+		 * Receive data together with file descriptors passed by the peer.
+		 * The received descriptors are owned by the caller and are
+		 * created with close-on-exec set. Descriptors exceeding maxFds are
+		 * closed by the kernel.
+		 *
+		 * \param buffer buffer to receive data
+		 * \param len maximum number of bytes to receive
+		 * \param fds set to the received file descriptors
+		 * \param maxFds maximum number of file descriptors to receive
+		 * \return number of bytes received, 0 if the peer disconnected
+		 * \exception SocketException thrown if unable to receive
+		 */
+		int receiveFds( void* buffer, size_t len, std::vector<int>& fds, size_t maxFds = MAX_FDS);
+
+		/*!
+		 * Move an accepted connection to the process of the peer. The
+		 * handle is invalid afterwards, the connection only lives on in
+		 * the peer.
+		 *
+		 * Usage example:
+		 * \code
+		 * TCPSocket::Handle handle = listener.accept();
+		 * worker.sendHandle( handle);
+		 * // in the worker process
+		 * TCPSocket connection( front.receiveHandle<TCPSocket>());
+		 * \endcode
+		 *
+		 * \param handle valid handle returned by accept()
+		 * \exception SocketException thrown if unable to send
+		 */
+		template<class Socket>
+		void sendHandle( SocketHandle<Socket>& handle)
+		{
+			int fd = handle.m_sockfd;
+			sendFds( &fd, 1);
+			handle.reset();
+		}
+
+		/*!
+		 * Receive a connection passed by sendHandle().
+		 * \return handle to construct the socket from, invalid if the peer disconnected
+		 * \exception SocketException thrown if unable to receive
+		 */
+		template<class Socket>
+		SocketHandle<Socket> receiveHandle()
+		{
+			return SocketHandle<Socket>( receiveSingleFd());
+		}
+
+		//! maximum number of file descriptors passed by one message
+		static const size_t MAX_FDS = 253;
+
 	protected:
 		//! allows a subclass to create new socket
 		UnixSocket( int type, int protocol);
 
+		//! enables return of an accepted socket
+		explicit UnixSocket( int sockfd);
+
 		/*!
 		 * Fill an address structure with the given path.
 		 * If the given path is not valid addr will be unchanged.
@@ -58,6 +132,9 @@ namespace NET
 
 		//! extracts a path string from the socket address structure
 		static std::string extractPath( const sockaddr_un& addr, socklen_t len);
+
+	private:
+		int receiveSingleFd();
 	};
 
 } // namespace NET
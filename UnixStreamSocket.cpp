@@ -0,0 +1,59 @@
+#include "UnixStreamSocket.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <poll.h>
+
+using namespace NET;
+
+UnixStreamSocket::UnixStreamSocket()
+: UnixSocket( STREAM, 0)
+{}
+
+UnixStreamSocket::UnixStreamSocket( Handle handle)
+: UnixSocket( handle.release() )
+{}
+
+int UnixStreamSocket::sendAll( const void* buffer, size_t len)
+{
+	size_t sent = 0;
+	while( sent != len)
+	{
+		const char* buf = static_cast<const char*>(buffer) + sent;
+		int ret = send( buf, len - sent);
+		if( ret < 0) return ret;
+		sent += static_cast<unsigned>(ret);
+	}
+	return static_cast<int>(sent);
+}
+
+void UnixStreamSocket::listen( int backlog /* = 5 */)
+{
+	if( ::listen( m_socket, backlog) < 0)
+		throw SocketException("UnixStreamSocket::listen failed (listen)");
+}
+
+UnixStreamSocket::Handle UnixStreamSocket::accept() const
+{
+	int ret = ::accept( m_socket, nullptr, nullptr);
+	if( ret < 0)
+		throw SocketException("UnixStreamSocket::accept failed (accept)");
+	return Handle(ret);
+}
+
+UnixStreamSocket::Handle UnixStreamSocket::timedAccept( int timeout) const
+{
+	struct pollfd poll;
+	poll.fd = m_socket;
+	poll.events = POLLIN;
+
+	int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+	if( ret == 0) return Handle();
+	if( ret < 0) throw SocketException("UnixStreamSocket::timedAccept failed (poll)");
+
+	ret = ::accept( m_socket, nullptr, nullptr);
+	if( ret < 0)
+		throw SocketException("UnixStreamSocket::timedAccept failed (accept)");
+	return Handle(ret);
+}
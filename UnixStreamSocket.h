@@ -0,0 +1,78 @@
+#ifndef NET_UnixStreamSocket_h__
+#define NET_UnixStreamSocket_h__
+
+#include "UnixSocket.h"
+
+namespace NET
+{
+	//! Unix stream socket class
+	/*!
+	 * A connection oriented local socket, used like a TCPSocket but
+	 * addressed by a path in the filesystem. Besides data it can pass open
+	 * file descriptors, e.g. accepted connections, to the peer process
+	 * (see UnixSocket::sendHandle()).
+	 *
+	 * Usage example:
+	 * \code
+	 * UnixStreamSocket server;
+	 * server.bind("/tmp/front.sock");
+	 * server.listen();
+	 * UnixStreamSocket worker( server.accept());
+	 * TCPSocket::Handle connection = tcpServer.accept();
+	 * worker.sendHandle( connection);
+	 * \endcode
+	 */
+	class UnixStreamSocket : public UnixSocket
+	{
+	public:
+		//! Handle for a new socket returned by accept
+		typedef SocketHandle<UnixStreamSocket> Handle;
+
+		/*!
+		 * Construct a Unix stream socket
+		 * \exception SocketException thrown if unable to create the socket
+		 */
+		UnixStreamSocket();
+
+		/*!
+		 * Construct a Socket from a Handle returned by accept()
+		 * \exception SocketException thrown if handle is invalid
+		 */
+		UnixStreamSocket( Handle handle);
+
+		//! send all data through a connected socket
+		/*!
+		 * Resends as long as needed, see TCPSocket::sendAll().
+		 * \param buffer data to be send
+		 * \param len length of the data to be sent
+		 * \return number of bytes sent
+		 * \exception SocketException
+		 */
+		int sendAll( const void* buffer, size_t len);
+
+		//! listen for incoming connections on a bound socket
+		/*!
+		 * \param backlog upper limit of pending incoming connections
+		 * \exception SocketException
+		 */
+		void listen( int backlog = 5);
+
+		//! wait for another socket to connect
+		/*!
+		 * \return SocketHandle object to the new connection
+		 * \exception SocketException
+		 */
+		Handle accept() const;
+
+		//! wait for another socket to connect, return after the given timespan
+		/*!
+		 * \param timeout the timeout in ms after which accept will give up and return
+		 * \return Handle object to the new connection, invalid on timeout
+		 * \exception SocketException
+		 */
+		Handle timedAccept( int timeout) const;
+	};
+
+} // namespace NET
+
+#endif // NET_UnixStreamSocket_h__
@@ -0,0 +1,382 @@
+#include "XDPSocket.h"
+#include "TempFailure.h"
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/if_xdp.h>
+#include <linux/if_link.h>
+#include <linux/bpf.h>
+#include <net/if.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+using namespace NET;
+
+namespace {
+
+// the kernel changes the ring indices concurrently
+uint32_t loadIndex( const uint32_t* index)
+{
+	return __atomic_load_n( index, __ATOMIC_ACQUIRE);
+}
+
+void storeIndex( uint32_t* index, uint32_t value)
+{
+	__atomic_store_n( index, value, __ATOMIC_RELEASE);
+}
+
+// transmit attempts without progress before send() leaves the rest to the next call
+const unsigned MAX_TX_STALLS = 4;
+
+// time to wait for room in the device queue after a stalled attempt, in milliseconds
+const int TX_STALL_TIMEOUT = 1;
+
+bool isPowerOfTwo( unsigned value)
+{
+	return value && !(value & (value - 1));
+}
+
+void setXDPOption( int socket, int option, const void* value, socklen_t len, const char* message)
+{
+	if( setsockopt( socket, SOL_XDP, option, value, len) < 0)
+		throw SocketException(message);
+}
+
+int bpf( int cmd, bpf_attr& attr)
+{
+	return static_cast<int>( ::syscall( __NR_bpf, cmd, &attr, sizeof(attr)));
+}
+
+bpf_insn instruction( uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+{
+	bpf_insn insn;
+	insn.code = code;
+	insn.dst_reg = dst & 0xf;
+	insn.src_reg = src & 0xf;
+	insn.off = off;
+	insn.imm = imm;
+	return insn;
+}
+
+} // namespace
+
+XDPSocket::XDPSocket( const std::string& interface, unsigned queue /* = 0 */,
+                      unsigned frameCount /* = 4096 */, unsigned frameSize /* = 2048 */)
+: SimpleSocket( XDP, RAW, 0)
+, m_umem(nullptr)
+, m_umemSize(0)
+, m_frameSize(frameSize)
+, m_mapFd(-1)
+, m_progFd(-1)
+, m_linkFd(-1)
+{
+	std::memset( &m_fill, 0, sizeof(m_fill));
+	std::memset( &m_completion, 0, sizeof(m_completion));
+	std::memset( &m_rx, 0, sizeof(m_rx));
+	std::memset( &m_tx, 0, sizeof(m_tx));
+
+	if( frameCount < 2 || !isPowerOfTwo(frameCount) || frameSize < 2048 || !isPowerOfTwo(frameSize))
+		throw SocketException("Frame count and frame size have to be powers of two", false);
+
+	unsigned ifindex = if_nametoindex( interface.c_str());
+	if( ifindex == 0)
+		throw SocketException("Unknown interface (if_nametoindex)");
+
+	try
+	{
+		m_umemSize = static_cast<size_t>(frameCount) * frameSize;
+		void* umem = ::mmap( nullptr, m_umemSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if( umem == MAP_FAILED)
+		{
+			m_umemSize = 0;
+			throw SocketException("Allocation of UMEM failed (mmap)");
+		}
+		m_umem = static_cast<uint8_t*>(umem);
+
+		xdp_umem_reg reg;
+		std::memset( &reg, 0, sizeof(reg));
+		reg.addr = reinterpret_cast<uintptr_t>(m_umem);
+		reg.len = m_umemSize;
+		reg.chunk_size = frameSize;
+		setXDPOption( m_socket, XDP_UMEM_REG, &reg, sizeof(reg), "Registration of UMEM failed (setsockopt)");
+
+		// one half of the frames for each direction, every ring can hold all of them
+		unsigned ringSize = frameCount / 2;
+		setXDPOption( m_socket, XDP_UMEM_FILL_RING, &ringSize, sizeof(ringSize), "Set up of fill ring failed (setsockopt)");
+		setXDPOption( m_socket, XDP_UMEM_COMPLETION_RING, &ringSize, sizeof(ringSize), "Set up of completion ring failed (setsockopt)");
+		setXDPOption( m_socket, XDP_RX_RING, &ringSize, sizeof(ringSize), "Set up of receive ring failed (setsockopt)");
+		setXDPOption( m_socket, XDP_TX_RING, &ringSize, sizeof(ringSize), "Set up of transmit ring failed (setsockopt)");
+
+		xdp_mmap_offsets off;
+		socklen_t size = sizeof(off);
+		if( getsockopt( m_socket, SOL_XDP, XDP_MMAP_OFFSETS, &off, &size) < 0)
+			throw SocketException("Fetch of ring offsets failed (getsockopt)");
+
+		mapRing( m_fill, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_FILL_RING, off.fr.producer, off.fr.consumer, off.fr.desc);
+		mapRing( m_completion, ringSize, sizeof(uint64_t), XDP_UMEM_PGOFF_COMPLETION_RING, off.cr.producer, off.cr.consumer, off.cr.desc);
+		mapRing( m_rx, ringSize, sizeof(xdp_desc), XDP_PGOFF_RX_RING, off.rx.producer, off.rx.consumer, off.rx.desc);
+		mapRing( m_tx, ringSize, sizeof(xdp_desc), XDP_PGOFF_TX_RING, off.tx.producer, off.tx.consumer, off.tx.desc);
+
+		// hand the receive frames to the kernel, keep the transmit frames
+		uint64_t* fill = static_cast<uint64_t*>(m_fill.descs);
+		for( unsigned i = 0; i < ringSize; ++i)
+			fill[i] = static_cast<uint64_t>(i) * frameSize;
+		storeIndex( m_fill.producer, ringSize);
+
+		m_freeTx.reserve(ringSize);
+		for( unsigned i = ringSize; i < frameCount; ++i)
+			m_freeTx.push_back( static_cast<uint64_t>(i) * frameSize);
+
+		sockaddr_xdp addr;
+		std::memset( &addr, 0, sizeof(addr));
+		addr.sxdp_family = AF_XDP;
+		addr.sxdp_flags = XDP_COPY;
+		addr.sxdp_ifindex = ifindex;
+		addr.sxdp_queue_id = queue;
+
+		if( ::bind( m_socket, (sockaddr*) &addr, sizeof(addr)) < 0)
+			throw SocketException("Set of interface failed (bind)");
+
+		attachProgram( ifindex, queue);
+	}
+	catch(...)
+	{
+		cleanup();
+		throw;
+	}
+}
+
+XDPSocket::~XDPSocket()
+{
+	cleanup();
+}
+
+void XDPSocket::mapRing( Ring& ring, uint32_t size, size_t descSize, uint64_t offset,
+                         uint64_t producer, uint64_t consumer, uint64_t descs)
+{
+	size_t mapSize = descs + size * descSize;
+	void* map = ::mmap( nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+	                    m_socket, static_cast<off_t>(offset));
+	if( map == MAP_FAILED)
+		throw SocketException("Mapping of ring failed (mmap)");
+
+	uint8_t* base = static_cast<uint8_t*>(map);
+	ring.producer = reinterpret_cast<uint32_t*>(base + producer);
+	ring.consumer = reinterpret_cast<uint32_t*>(base + consumer);
+	ring.descs = base + descs;
+	ring.size = size;
+	ring.map = map;
+	ring.mapSize = mapSize;
+}
+
+void XDPSocket::attachProgram( unsigned ifindex, unsigned queue)
+{
+	bpf_attr attr;
+	std::memset( &attr, 0, sizeof(attr));
+	attr.map_type = BPF_MAP_TYPE_XSKMAP;
+	attr.key_size = sizeof(uint32_t);
+	attr.value_size = sizeof(int);
+	attr.max_entries = queue + 1;
+	m_mapFd = bpf( BPF_MAP_CREATE, attr);
+	if( m_mapFd < 0)
+		throw SocketException("Creation of socket map failed (bpf)");
+
+	// return bpf_redirect_map( &map, ctx->rx_queue_index, XDP_PASS);
+	// frames of queues without a socket in the map take the normal path
+	bpf_insn program[] = {
+		instruction( BPF_LDX | BPF_W | BPF_MEM, BPF_REG_2, BPF_REG_1, offsetof(xdp_md, rx_queue_index), 0),
+		instruction( BPF_LD | BPF_DW | BPF_IMM, BPF_REG_1, BPF_PSEUDO_MAP_FD, 0, m_mapFd),
+		instruction( 0, 0, 0, 0, 0),
+		instruction( BPF_ALU64 | BPF_MOV | BPF_K, BPF_REG_3, 0, 0, XDP_PASS),
+		instruction( BPF_JMP | BPF_CALL, 0, 0, 0, BPF_FUNC_redirect_map),
+		instruction( BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+	};
+	const char license[] = "Dual MIT/GPL";
+
+	std::memset( &attr, 0, sizeof(attr));
+	attr.prog_type = BPF_PROG_TYPE_XDP;
+	attr.expected_attach_type = BPF_XDP;
+	attr.insns = reinterpret_cast<uintptr_t>(program);
+	attr.insn_cnt = sizeof(program) / sizeof(program[0]);
+	attr.license = reinterpret_cast<uintptr_t>(license);
+	m_progFd = bpf( BPF_PROG_LOAD, attr);
+	if( m_progFd < 0)
+		throw SocketException("Load of XDP program failed (bpf)");
+
+	uint32_t key = queue;
+	int value = m_socket;
+	std::memset( &attr, 0, sizeof(attr));
+	attr.map_fd = static_cast<uint32_t>(m_mapFd);
+	attr.key = reinterpret_cast<uintptr_t>(&key);
+	attr.value = reinterpret_cast<uintptr_t>(&value);
+	if( bpf( BPF_MAP_UPDATE_ELEM, attr) < 0)
+		throw SocketException("Insertion into socket map failed (bpf)");
+
+	// the program stays attached as long as the link exists
+	std::memset( &attr, 0, sizeof(attr));
+	attr.link_create.prog_fd = static_cast<uint32_t>(m_progFd);
+	attr.link_create.target_ifindex = ifindex;
+	attr.link_create.attach_type = BPF_XDP;
+	attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+	m_linkFd = bpf( BPF_LINK_CREATE, attr);
+	if( m_linkFd < 0)
+		throw SocketException("Attach of XDP program failed (bpf)");
+}
+
+void XDPSocket::cleanup()
+{
+	if( m_linkFd >= 0) ::close(m_linkFd);
+	if( m_progFd >= 0) ::close(m_progFd);
+	if( m_mapFd >= 0) ::close(m_mapFd);
+
+	const Ring* rings[] = { &m_fill, &m_completion, &m_rx, &m_tx };
+	for( const Ring* ring : rings)
+		if( ring->map) ::munmap( ring->map, ring->mapSize);
+
+	if( m_umem) ::munmap( m_umem, m_umemSize);
+}
+
+unsigned XDPSocket::receive( Frame* frames, unsigned maxFrames, int timeout)
+{
+	uint32_t consumer = *m_rx.consumer;
+	uint32_t available = loadIndex( m_rx.producer) - consumer;
+
+	if( available == 0)
+	{
+		struct pollfd poll;
+		poll.fd = m_socket;
+		poll.events = POLLIN;
+
+		int ret = TEMP_FAILURE_RETRY (::poll( &poll, 1, timeout));
+
+		if( ret == 0) return 0;
+		if( ret < 0)  throw SocketException("Receive failed (poll)");
+
+		available = loadIndex( m_rx.producer) - consumer;
+	}
+
+	unsigned count = available < maxFrames ? available : maxFrames;
+	const xdp_desc* descs = static_cast<const xdp_desc*>(m_rx.descs);
+
+	for( unsigned i = 0; i < count; ++i)
+	{
+		const xdp_desc& desc = descs[(consumer + i) & (m_rx.size - 1)];
+		frames[i].data = m_umem + desc.addr;
+		frames[i].len = desc.len;
+		frames[i].addr = desc.addr;
+	}
+
+	storeIndex( m_rx.consumer, consumer + count);
+	return count;
+}
+
+void XDPSocket::release( const Frame* frames, unsigned count)
+{
+	// the fill ring can hold every receive frame, so there is always room
+	uint32_t producer = *m_fill.producer;
+	uint64_t* fill = static_cast<uint64_t*>(m_fill.descs);
+
+	for( unsigned i = 0; i < count; ++i)
+		fill[(producer + i) & (m_fill.size - 1)] = frames[i].addr & ~static_cast<uint64_t>(m_frameSize - 1);
+
+	storeIndex( m_fill.producer, producer + count);
+}
+
+void XDPSocket::reclaimCompleted()
+{
+	uint32_t consumer = *m_completion.consumer;
+	uint32_t available = loadIndex( m_completion.producer) - consumer;
+	const uint64_t* completed = static_cast<const uint64_t*>(m_completion.descs);
+
+	for( uint32_t i = 0; i < available; ++i)
+		m_freeTx.push_back( completed[(consumer + i) & (m_completion.size - 1)]);
+
+	storeIndex( m_completion.consumer, consumer + available);
+}
+
+unsigned XDPSocket::send( const void* const* frames, const size_t* lens, unsigned count)
+{
+	for( unsigned i = 0; i < count; ++i)
+		if( lens[i] > m_frameSize)
+			throw SocketException("Frame is too large for the UMEM", false);
+
+	reclaimCompleted();
+
+	// the transmit ring can hold every transmit frame, so only free frames limit the batch
+	unsigned queued = count < m_freeTx.size() ? count : static_cast<unsigned>(m_freeTx.size());
+	uint32_t producer = *m_tx.producer;
+	xdp_desc* descs = static_cast<xdp_desc*>(m_tx.descs);
+
+	for( unsigned i = 0; i < queued; ++i)
+	{
+		uint64_t addr = m_freeTx.back();
+		m_freeTx.pop_back();
+		std::memcpy( m_umem + addr, frames[i], lens[i]);
+
+		xdp_desc& desc = descs[(producer + i) & (m_tx.size - 1)];
+		desc.addr = addr;
+		desc.len = static_cast<uint32_t>(lens[i]);
+		desc.options = 0;
+	}
+
+	storeIndex( m_tx.producer, producer + queued);
+
+	// in copy mode the kernel transmits within sendto(), a limited number
+	// of frames per call. If the device is busy, the remaining frames are
+	// sent with the next call.
+	unsigned stalls = 0;
+	while( pending() > 0)
+	{
+		uint32_t consumer = loadIndex( m_tx.consumer);
+		if( TEMP_FAILURE_RETRY (::sendto( m_socket, nullptr, 0, MSG_DONTWAIT, nullptr, 0)) < 0)
+		{
+			if( errno == EBUSY || errno == ENOBUFS)
+				break;
+			if( errno != EAGAIN)
+				throw SocketException("Send failed (sendto)");
+		}
+
+		if( loadIndex( m_tx.consumer) != consumer)
+		{
+			stalls = 0;
+			continue;
+		}
+		if( ++stalls == MAX_TX_STALLS)
+			break;
+
+		struct pollfd poll;
+		poll.fd = m_socket;
+		poll.events = POLLOUT;
+		if( TEMP_FAILURE_RETRY (::poll( &poll, 1, TX_STALL_TIMEOUT)) < 0)
+			throw SocketException("Send failed (poll)");
+	}
+
+	return queued;
+}
+
+unsigned XDPSocket::pending() const
+{
+	return *m_tx.producer - loadIndex( m_tx.consumer);
+}
+
+XDPSocket::Statistics XDPSocket::statistics() const
+{
+	xdp_statistics stats;
+	std::memset( &stats, 0, sizeof(stats));
+	socklen_t size = sizeof(stats);
+
+	if( getsockopt( m_socket, SOL_XDP, XDP_STATISTICS, &stats, &size) < 0)
+		throw SocketException("Fetch of statistics failed (getsockopt)");
+
+	Statistics ret;
+	ret.rxDropped = stats.rx_dropped;
+	ret.rxRingFull = stats.rx_ring_full;
+	ret.rxFillRingEmpty = stats.rx_fill_ring_empty_descs;
+	ret.rxInvalid = stats.rx_invalid_descs;
+	ret.txInvalid = stats.tx_invalid_descs;
+	return ret;
+}
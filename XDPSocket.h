@@ -0,0 +1,162 @@
+#ifndef NET_XDPSocket_h__
+#define NET_XDPSocket_h__
+
+#include "SimpleSocket.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace NET
+{
+	//! AF_XDP socket class
+	/*!
+	 * XDPSocket receives and transmits link layer frames through an XDP
+	 * program, bypassing most of the network stack. Frames are stored in
+	 * a memory area shared with the kernel (UMEM) and exchanged through
+	 * four rings: fill and receive for incoming frames, transmit and
+	 * completion for outgoing ones.
+	 *
+	 * The socket is bound to one receive queue of an interface. It loads
+	 * and attaches a small XDP program in generic (SKB) mode, which
+	 * redirects all frames of that queue to the socket. Generic mode
+	 * works with every driver, including veth, but copies every frame.
+	 * Only one XDPSocket can be attached to an interface at a time. The
+	 * program is detached when the socket is destroyed.
+	 *
+	 * Creating the socket needs the CAP_NET_ADMIN, CAP_NET_RAW and
+	 * CAP_BPF capabilities.
+	 *
+	 * Usage example:
+	 * \code
+	 * XDPSocket socket("veth1");
+	 * XDPSocket::Frame frames[64];
+	 * unsigned count = socket.receive( frames, 64, 1000);
+	 * for( unsigned i = 0; i < count; ++i)
+	 *   process( frames[i].data, frames[i].len);
+	 * socket.release( frames, count);
+	 * \endcode
+	 */
+	class XDPSocket : public SimpleSocket
+	{
+	public:
+		//! A received frame, pointing into the UMEM
+		struct Frame
+		{
+			const uint8_t* data; ///< start of the link layer header
+			size_t len;          ///< length of the frame
+			uint64_t addr;       ///< offset of the frame within the UMEM
+		};
+
+		//! Counters of the kernel
+		struct Statistics
+		{
+			uint64_t rxDropped;        ///< frames dropped for other reasons
+			uint64_t rxRingFull;       ///< frames dropped because the receive ring was full
+			uint64_t rxFillRingEmpty;  ///< times no free frame was available for reception
+			uint64_t rxInvalid;        ///< frames dropped due to invalid descriptors
+			uint64_t txInvalid;        ///< frames not sent due to invalid descriptors
+		};
+
+		/*!
+		 * Construct an XDP socket bound to the given queue of an interface.
+		 *
+		 * The UMEM is split into frameCount frames of frameSize bytes. One
+		 * half is used for reception, the other half for transmission.
+		 * Both values have to be powers of two, frameSize at least 2048.
+		 *
+		 * \param interface network interface to bind to
+		 * \param queue receive queue of the interface
+		 * \param frameCount number of frames within the UMEM
+		 * \param frameSize size of a single frame in bytes
+		 * \exception SocketException thrown if unable to create the socket or to attach the program
+		 */
+		explicit XDPSocket( const std::string& interface, unsigned queue = 0,
+		                    unsigned frameCount = 4096, unsigned frameSize = 2048);
+
+		//! detaches the XDP program and releases the UMEM
+		~XDPSocket();
+
+		/*!
+		 * Fetch a batch of received frames from the receive ring.
+		 *
+		 * The frames remain owned by the caller until they are handed
+		 * back with release(). No more frames can be received once all
+		 * frames for reception are held by the caller.
+		 *
+		 * \param frames array to store the received frames
+		 * \param maxFrames size of the array
+		 * \param timeout timeout in milliseconds, -1 to wait forever
+		 * \return number of received frames, 0 on timeout
+		 * \exception SocketException thrown if waiting failed
+		 */
+		unsigned receive( Frame* frames, unsigned maxFrames, int timeout);
+
+		/*!
+		 * Hand frames returned by receive() back to the kernel.
+		 * \param frames frames to release
+		 * \param count number of frames
+		 */
+		void release( const Frame* frames, unsigned count);
+
+		/*!
+		 * Copy a batch of link layer frames into the UMEM and send them
+		 * with one system call. Frames that do not fit into the transmit
+		 * ring are not sent, the return value has to be checked.
+		 *
+		 * If the kernel makes no progress for a few attempts, send()
+		 * returns and leaves the frames in the transmit ring. They are
+		 * sent by the next call, pending() tells how many are left.
+		 *
+		 * \param frames pointers to the frames to send
+		 * \param lens lengths of the frames
+		 * \param count number of frames
+		 * \return number of frames queued for transmission
+		 * \exception SocketException thrown if a frame is too large or sending failed
+		 */
+		unsigned send( const void* const* frames, const size_t* lens, unsigned count);
+
+		//! return the number of frames in the transmit ring not yet taken by the kernel
+		unsigned pending() const;
+
+		//! return the kernel counters
+		/*!
+		 * \exception SocketException thrown if unable to fetch the counters
+		 */
+		Statistics statistics() const;
+
+	private:
+		//! one of the four rings shared with the kernel
+		struct Ring
+		{
+			uint32_t* producer;
+			uint32_t* consumer;
+			void* descs;
+			uint32_t size;
+			void* map;
+			size_t mapSize;
+		};
+
+		void mapRing( Ring& ring, uint32_t size, size_t descSize, uint64_t offset,
+		              uint64_t producer, uint64_t consumer, uint64_t descs);
+		void attachProgram( unsigned ifindex, unsigned queue);
+		void reclaimCompleted();
+		void cleanup();
+
+		uint8_t* m_umem;
+		size_t m_umemSize;
+		unsigned m_frameSize;
+
+		Ring m_fill;
+		Ring m_completion;
+		Ring m_rx;
+		Ring m_tx;
+		std::vector<uint64_t> m_freeTx;
+
+		int m_mapFd;
+		int m_progFd;
+		int m_linkFd;
+	};
+
+} // namespace NET
+
+#endif // NET_XDPSocket_h__
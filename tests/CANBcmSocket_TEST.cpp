@@ -0,0 +1,101 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../CANBcmSocket.h"
+#include "../CANRawSocket.h"
+
+#include <cstring>
+
+class CANBcmSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CANBcmSocket_TEST );
+	CPPUNIT_TEST( testCyclic );
+	CPPUNIT_TEST( testChanges );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::can_frame frame;
+
+public:
+	void setUp()
+	{
+		std::memset( &frame, 0, sizeof(frame));
+		frame.id.value = 0x123;
+		frame.dlc = 2;
+		frame[0] = 0x01;
+		frame[1] = 0x02;
+	}
+
+	void tearDown() {}
+
+	void testCyclic()
+	{
+		NET::CANBcmSocket bcm_socket;
+		NET::CANRawSocket recv_socket;
+		bcm_socket.connect("vcan0");
+		recv_socket.bind("vcan0");
+
+		bcm_socket.startCyclic( frame, 10000);
+
+		NET::can_frame received[4];
+		unsigned count = 0;
+		while( count < 4)
+		{
+			unsigned n = recv_socket.timedReadFrames( received + count, nullptr, 4 - count, 100);
+			CPPUNIT_ASSERT( n > 0 );
+			count += n;
+		}
+		CPPUNIT_ASSERT( std::memcmp( &frame, &received[3], sizeof(frame)) == 0 );
+
+		frame[0] = 0x42;
+		bcm_socket.updateCyclic( &frame, 1, true);
+		CPPUNIT_ASSERT_EQUAL( 1u, recv_socket.timedReadFrames( received, nullptr, 1, 100) );
+		CPPUNIT_ASSERT_EQUAL( static_cast<uint8_t>(0x42), received[0][0] );
+
+		bcm_socket.stopCyclic( frame.id);
+		while( recv_socket.timedReadFrames( received, nullptr, 4, 20) > 0) ;
+		CPPUNIT_ASSERT_THROW( bcm_socket.stopCyclic( frame.id), NET::SocketException );
+
+		// an update without a job sets up one without a timer
+		bcm_socket.updateCyclic( &frame, 1, true);
+		CPPUNIT_ASSERT_EQUAL( 1u, recv_socket.timedReadFrames( received, nullptr, 4, 100) );
+		CPPUNIT_ASSERT_EQUAL( 0u, recv_socket.timedReadFrames( received, nullptr, 4, 50) );
+		bcm_socket.stopCyclic( frame.id);
+	}
+
+	void testChanges()
+	{
+		NET::CANBcmSocket send_socket;
+		NET::CANBcmSocket recv_socket;
+		send_socket.connect("vcan0");
+		recv_socket.connect("vcan0");
+
+		// watch the first byte only
+		NET::can_frame mask = frame;
+		std::memset( mask.data, 0, sizeof(mask.data));
+		mask[0] = 0xff;
+		recv_socket.subscribeChanges( mask, 50000);
+
+		NET::CANBcmSocket::Notification notification;
+		send_socket.sendOnce( frame);
+		CPPUNIT_ASSERT( recv_socket.receiveNotification( notification, 100) );
+		CPPUNIT_ASSERT( notification.type == NET::CANBcmSocket::Notification::RX_CHANGED );
+		CPPUNIT_ASSERT_EQUAL( static_cast<uint8_t>(0x01), notification.frame[0] );
+
+		// the second byte is not watched
+		frame[1] = 0x03;
+		send_socket.sendOnce( frame);
+		frame[0] = 0x04;
+		send_socket.sendOnce( frame);
+		CPPUNIT_ASSERT( recv_socket.receiveNotification( notification, 100) );
+		CPPUNIT_ASSERT( notification.type == NET::CANBcmSocket::Notification::RX_CHANGED );
+		CPPUNIT_ASSERT_EQUAL( static_cast<uint8_t>(0x04), notification.frame[0] );
+
+		// no frames within the timeout
+		CPPUNIT_ASSERT( recv_socket.receiveNotification( notification, 100) );
+		CPPUNIT_ASSERT( notification.type == NET::CANBcmSocket::Notification::RX_TIMEOUT );
+		CPPUNIT_ASSERT_EQUAL( 0x123u, static_cast<unsigned>( notification.id.value) );
+
+		recv_socket.unsubscribe( mask.id);
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CANBcmSocket_TEST );
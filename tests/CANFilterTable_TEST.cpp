@@ -0,0 +1,116 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../CANFilterTable.h"
+
+#include <cstdlib>
+#include <vector>
+
+class CANFilterTable_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CANFilterTable_TEST );
+	CPPUNIT_TEST( testBuilders );
+	CPPUNIT_TEST( testExact );
+	CPPUNIT_TEST( testMasked );
+	CPPUNIT_TEST( testAgainstKernelRule );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	// the rule of the kernel for one filter
+	static bool kernelMatch( const NET::can_filter& filter, const NET::can_id& id)
+	{
+		uint32_t mask = NET::raw_id(filter.mask) & ~0x20000000U;
+		bool match = (NET::raw_id(id) & mask) == (NET::raw_id(filter.id) & mask);
+		return filter.id.error_flag ? !match : match;
+	}
+
+public:
+	void setUp() {}
+
+	void tearDown() {}
+
+	void testBuilders()
+	{
+		static_assert( NET::raw_id( NET::extended_id(0x12345678)) == 0x92345678U, "extended id");
+		static_assert( NET::raw_id( NET::standard_id(0x123)) == 0x123U, "standard id");
+		static_assert( NET::raw_id( NET::exact_filter( NET::standard_id(0x123)).mask) == 0x800007ffU, "exact mask");
+		static_assert( NET::inverted_filter( NET::exact_filter( NET::standard_id(1))).id.error_flag, "inverted");
+	}
+
+	void testExact()
+	{
+		NET::can_filter filters[] = {
+			NET::exact_filter( NET::standard_id(0x100)),
+			NET::exact_filter( NET::extended_id(0x100))
+		};
+		NET::CANFilterTable table;
+		CPPUNIT_ASSERT( table.empty() );
+		table.assign( filters, 2);
+		CPPUNIT_ASSERT_EQUAL( size_t(2), table.size() );
+
+		NET::can_id remote = NET::standard_id(0x100);
+		remote.rtr_flag = 1;
+		CPPUNIT_ASSERT( table.matches( NET::standard_id(0x100)) );
+		CPPUNIT_ASSERT( table.matches( NET::extended_id(0x100)) );
+		CPPUNIT_ASSERT( table.matches(remote) );
+		CPPUNIT_ASSERT( !table.matches( NET::standard_id(0x101)) );
+		CPPUNIT_ASSERT( !table.matches( NET::extended_id(0x101)) );
+	}
+
+	void testMasked()
+	{
+		NET::can_filter filters[] = {
+			NET::mask_filter( NET::standard_id(0x100), 0x700),
+			NET::inverted_filter( NET::mask_filter( NET::standard_id(0x200), 0x700))
+		};
+		NET::CANFilterTable table;
+		table.assign( filters, 2);
+
+		CPPUNIT_ASSERT( table.matches( NET::standard_id(0x1ab)) );
+		CPPUNIT_ASSERT( !table.matches( NET::standard_id(0x2ab)) );
+		CPPUNIT_ASSERT( table.matches( NET::standard_id(0x3ab)) );
+		CPPUNIT_ASSERT( table.matches( NET::extended_id(0x2ab)) );
+	}
+
+	void testAgainstKernelRule()
+	{
+		std::srand(4711);
+		std::vector<NET::can_filter> filters;
+		for( int i = 0; i < 300; ++i)
+		{
+			NET::can_id id = (i % 2) ? NET::extended_id( static_cast<uint32_t>(std::rand())) : NET::standard_id( static_cast<uint32_t>(std::rand()));
+			switch( i % 5)
+			{
+			case 0:
+				filters.push_back( NET::mask_filter( id, static_cast<uint32_t>(std::rand())));
+				break;
+			case 1:
+				filters.push_back( NET::inverted_filter( NET::mask_filter( id, 0x7ff)));
+				break;
+			default:
+				filters.push_back( NET::exact_filter(id));
+				// use the id of the filter for one test frame
+				break;
+			}
+		}
+
+		NET::CANFilterTable table;
+		table.assign( filters.data(), filters.size());
+
+		for( int i = 0; i < 20000; ++i)
+		{
+			NET::can_id id;
+			if( i < 300)
+				id = filters[static_cast<size_t>(i)].id;
+			else
+				id = (i % 2) ? NET::extended_id( static_cast<uint32_t>(std::rand())) : NET::standard_id( static_cast<uint32_t>(std::rand()) & 0x10f);
+			id.error_flag = 0;
+			id.rtr_flag = (i % 7 == 0);
+
+			bool expected = false;
+			for( size_t f = 0; f < filters.size(); ++f)
+				expected = expected || kernelMatch( filters[f], id);
+			CPPUNIT_ASSERT_EQUAL( expected, table.matches(id) );
+		}
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CANFilterTable_TEST );
@@ -0,0 +1,53 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../CANIsoTpSocket.h"
+
+#include <cstring>
+
+class CANIsoTpSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CANIsoTpSocket_TEST );
+	CPPUNIT_TEST( testTransfer );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::can_id tester_id;
+	NET::can_id ecu_id;
+
+public:
+	void setUp()
+	{
+		std::memset( &tester_id, 0, sizeof(tester_id));
+		std::memset( &ecu_id, 0, sizeof(ecu_id));
+		tester_id.value = 0x7e0;
+		ecu_id.value = 0x7e8;
+	}
+
+	void tearDown() {}
+
+	void testTransfer()
+	{
+		NET::CANIsoTpSocket tester;
+		NET::CANIsoTpSocket ecu;
+		tester.setPadding(true);
+		tester.setFlowControl( 8, 0);
+		tester.bind( "vcan0", tester_id, ecu_id);
+		ecu.bind( "vcan0", ecu_id, tester_id);
+
+		// single frame
+		uint8_t request[] = { 0x22, 0xf1, 0x90 };
+		uint8_t buffer[4095];
+		tester.send( request, sizeof(request));
+		CPPUNIT_ASSERT_EQUAL( static_cast<int>(sizeof(request)), ecu.timedReceive( buffer, sizeof(buffer), 100) );
+		CPPUNIT_ASSERT( std::memcmp( request, buffer, sizeof(request)) == 0 );
+
+		// segmented with flow control every 8 frames
+		uint8_t response[4095];
+		for( size_t i = 0; i < sizeof(response); ++i)
+			response[i] = static_cast<uint8_t>(i);
+		ecu.send( response, sizeof(response));
+		CPPUNIT_ASSERT_EQUAL( static_cast<int>(sizeof(response)), tester.timedReceive( buffer, sizeof(buffer), 1000) );
+		CPPUNIT_ASSERT( std::memcmp( response, buffer, sizeof(response)) == 0 );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CANIsoTpSocket_TEST );
@@ -2,6 +2,8 @@
 #include "../CANRawSocket.h"
 #include "../CANFrame.h"
 
+#include <net/if.h>
+#include <chrono>
 #include <stdexcept>
 #include <cstring>
 
@@ -13,7 +15,11 @@ class CANSocket_TEST : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE( CANSocket_TEST );
 	CPPUNIT_TEST( testFilter );
+	CPPUNIT_TEST( testUserSpaceFilter );
 	CPPUNIT_TEST( testSendTo );
+	CPPUNIT_TEST( testBatchTransfer );
+	CPPUNIT_TEST( testBatchThroughput );
+	CPPUNIT_TEST( testFDFrames );
 	CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -54,6 +60,53 @@ public:
 		recv_socket->setReceiveFilter( filter, 2);
 	}
 
+	void testUserSpaceFilter()
+	{
+		send_socket->bind("vcan0");
+		recv_socket->bind("vcan0");
+
+		// more filters than the kernel checks, receive() must apply them
+		const unsigned count = NET::CANRawSocket::MAX_KERNEL_FILTERS + 8;
+		NET::can_filter filters[count];
+		std::memset( filters, 0, sizeof(filters));
+		for( unsigned i = 0; i < count; ++i)
+		{
+			filters[i].id.value = i;
+			filters[i].mask.value = 0x7ff;
+		}
+		recv_socket->setReceiveFilter( filters, count);
+
+		NET::can_frame frame;
+		std::memset( &frame, 0, sizeof(frame));
+		frame.id.value = 0x100;
+		send_socket->sendTo( &frame, len, "vcan0");
+		frame.id.value = count - 1;
+		send_socket->sendTo( &frame, len, "vcan0");
+
+		NET::can_frame received;
+		CPPUNIT_ASSERT_EQUAL( len, recv_socket->receive( &received, len) );
+		CPPUNIT_ASSERT_EQUAL( count - 1, static_cast<unsigned>( received.id.value) );
+
+		send_socket->sendTo( &frame, len, "vcan0");
+		CPPUNIT_ASSERT_EQUAL( len, recv_socket->timedReceive( &received, len, 100) );
+		frame.id.value = 0x100;
+		send_socket->sendTo( &frame, len, "vcan0");
+		CPPUNIT_ASSERT_EQUAL( 0, recv_socket->timedReceive( &received, len, 10) );
+
+		// passes the covering filter of the kernel, but no filter of the set
+		frame.id.value = count + 1;
+		send_socket->sendTo( &frame, len, "vcan0");
+		CPPUNIT_ASSERT_EQUAL( 0, recv_socket->timedReceive( &received, len, 10) );
+
+		// exact ids stay in the kernel next to the masked filters
+		filters[0] = NET::exact_filter( NET::extended_id( 0x1234567));
+		recv_socket->setReceiveFilter( filters, count);
+		frame.id = NET::extended_id( 0x1234567);
+		send_socket->sendTo( &frame, len, "vcan0");
+		CPPUNIT_ASSERT_EQUAL( len, recv_socket->timedReceive( &received, len, 100) );
+		CPPUNIT_ASSERT_EQUAL( uint32_t(0x1234567), static_cast<uint32_t>( received.id.value) );
+	}
+
 	void testSendTo()
 	{
 		int ret;
@@ -71,6 +124,177 @@ public:
 		CPPUNIT_ASSERT_EQUAL( std::string("vcan0"), source );
 		CPPUNIT_ASSERT( std::memcmp(send_msg, recv_msg, len) == 0 );
 	}
+
+	void testBatchTransfer()
+	{
+		send_socket->bind("vcan0");
+		recv_socket->bind("vcan0");
+
+		const unsigned batch = 128;
+		const unsigned rounds = 200;
+		NET::can_frame frames[batch];
+		NET::can_frame received[batch];
+		NET::CANRawSocket::FrameInfo info[batch];
+
+		int ifindex = static_cast<int>( if_nametoindex("vcan0"));
+		std::memset( frames, 0, sizeof(frames));
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			frames[i].id.value = i;
+			frames[i].dlc = 8;
+			info[i].ifindex = ifindex;
+		}
+
+		// stay below the size of the receive buffer
+		for( unsigned round = 0; round < rounds; ++round)
+		{
+			CPPUNIT_ASSERT_EQUAL( batch, send_socket->writeFrames( frames, info, batch) );
+
+			unsigned count = 0;
+			while( count < batch)
+			{
+				unsigned n = recv_socket->timedReadFrames( received + count, info + count, batch - count, 100);
+				CPPUNIT_ASSERT( n > 0 );
+				count += n;
+			}
+
+			for( unsigned i = 0; i < batch; ++i)
+			{
+				CPPUNIT_ASSERT_EQUAL( i, static_cast<unsigned>( received[i].id.value) );
+				CPPUNIT_ASSERT_EQUAL( ifindex, info[i].ifindex );
+				CPPUNIT_ASSERT( info[i].sec != 0 );
+			}
+		}
+
+		CPPUNIT_ASSERT_EQUAL( 0u, recv_socket->timedReadFrames( received, info, batch, 10) );
+	}
+
+	void testBatchThroughput()
+	{
+		send_socket->bind("vcan0");
+		recv_socket->bind("vcan0");
+
+		const unsigned batch = 128;
+		const unsigned rounds = 100;
+		NET::can_frame frames[batch];
+		NET::can_frame received[batch];
+		NET::CANRawSocket::FrameInfo info[batch];
+
+		int ifindex = static_cast<int>( if_nametoindex("vcan0"));
+		std::memset( frames, 0, sizeof(frames));
+		for( unsigned i = 0; i < batch; ++i)
+		{
+			frames[i].id.value = i;
+			frames[i].dlc = 8;
+			info[i].ifindex = ifindex;
+		}
+
+		typedef std::chrono::steady_clock Clock;
+
+		// the same frames one by one, a round stays below the size of the receive buffer
+		Clock::time_point start = Clock::now();
+		for( unsigned round = 0; round < rounds; ++round)
+		{
+			for( unsigned i = 0; i < batch; ++i)
+				send_socket->sendTo( &frames[i], len, "vcan0");
+
+			std::string interface;
+			for( unsigned i = 0; i < batch; ++i)
+				CPPUNIT_ASSERT_EQUAL( len, recv_socket->timedReceiveFrom( &received[i], len, interface, 100) );
+		}
+		Clock::duration single = Clock::now() - start;
+
+		// and in batches
+		start = Clock::now();
+		for( unsigned round = 0; round < rounds; ++round)
+		{
+			CPPUNIT_ASSERT_EQUAL( batch, send_socket->writeFrames( frames, info, batch) );
+
+			unsigned count = 0;
+			while( count < batch)
+			{
+				unsigned n = recv_socket->timedReadFrames( received + count, info + count, batch - count, 100);
+				CPPUNIT_ASSERT( n > 0 );
+				count += n;
+			}
+		}
+		Clock::duration batched = Clock::now() - start;
+
+		// frames per second of both paths
+		double total = double(batch) * rounds;
+		double singleRate = total / std::chrono::duration<double>(single).count();
+		double batchedRate = total / std::chrono::duration<double>(batched).count();
+		CPPUNIT_ASSERT( batchedRate >= singleRate );
+	}
+
+	// needs an interface with CAN FD MTU: ip link set vcan0 mtu 72
+	void testFDFrames()
+	{
+		send_socket->bind("vcan0");
+		recv_socket->bind("vcan0");
+		send_socket->setFDFrames(true);
+		recv_socket->setFDFrames(true);
+
+		// alternating classic and CAN FD frames
+		const unsigned count = 16;
+		NET::canfd_frame frames[count];
+		NET::canfd_frame received[count];
+		NET::CANRawSocket::FrameInfo info[count];
+
+		int ifindex = static_cast<int>( if_nametoindex("vcan0"));
+		std::memset( frames, 0, sizeof(frames));
+		for( unsigned i = 0; i < count; ++i)
+		{
+			info[i].ifindex = ifindex;
+			info[i].fd = i % 2;
+			frames[i].id.value = i;
+			frames[i].len = info[i].fd ? 64 : 8;
+			frames[i].flags = info[i].fd ? NET::canfd_frame::BIT_RATE_SWITCH : 0;
+			std::memset( frames[i].data, static_cast<int>(i), frames[i].len);
+		}
+
+		CPPUNIT_ASSERT_EQUAL( count, send_socket->writeFrames( frames, info, count) );
+
+		unsigned n = 0;
+		while( n < count)
+		{
+			unsigned ret = recv_socket->timedReadFrames( received + n, info + n, count - n, 100);
+			CPPUNIT_ASSERT( ret > 0 );
+			n += ret;
+		}
+
+		for( unsigned i = 0; i < count; ++i)
+		{
+			CPPUNIT_ASSERT_EQUAL( i % 2 == 1, info[i].fd );
+			CPPUNIT_ASSERT_EQUAL( frames[i].len, received[i].len );
+			CPPUNIT_ASSERT( std::memcmp( frames[i].data, received[i].data, frames[i].len) == 0 );
+		}
+
+		// classic frames of a CAN FD socket read into can_frame, the CAN FD frames are skipped
+		CPPUNIT_ASSERT_EQUAL( count, send_socket->writeFrames( frames, info, count) );
+		NET::can_frame classic[count];
+		NET::CANRawSocket::FrameInfo classicInfo[count];
+		n = 0;
+		while( n < count / 2)
+		{
+			unsigned ret = recv_socket->timedReadFrames( classic + n, classicInfo + n, count - n, 100);
+			CPPUNIT_ASSERT( ret > 0 );
+			n += ret;
+		}
+		CPPUNIT_ASSERT_EQUAL( count / 2, n );
+		for( unsigned i = 0; i < n; ++i)
+		{
+			CPPUNIT_ASSERT_EQUAL( 2 * i, static_cast<unsigned>( classic[i].id.value) );
+			CPPUNIT_ASSERT( !classicInfo[i].fd );
+		}
+
+		// a classic receiver does not see CAN FD frames
+		NET::CANRawSocket classic_socket;
+		classic_socket.bind("vcan0");
+		CPPUNIT_ASSERT_EQUAL( 1u, send_socket->writeFrames( frames + 1, info + 1, 1) );
+		NET::can_frame frame;
+		CPPUNIT_ASSERT_EQUAL( 0u, classic_socket.timedReadFrames( &frame, nullptr, 1, 10) );
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( CANSocket_TEST );
@@ -0,0 +1,109 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../CANStats.h"
+#include "../CANBcmSocket.h"
+
+#include <net/if.h>
+#include <cstring>
+
+class CANStats_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( CANStats_TEST );
+	CPPUNIT_TEST( testRecord );
+	CPPUNIT_TEST( testCyclicOnVcan );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::can_frame frames[10];
+	NET::CANRawSocket::FrameInfo info[10];
+
+public:
+	void setUp()
+	{
+		std::memset( frames, 0, sizeof(frames));
+		std::memset( info, 0, sizeof(info));
+	}
+
+	void tearDown() {}
+
+	void testRecord()
+	{
+		// one id every 10 ms with a deviation of 3 ms in the middle
+		for( unsigned i = 0; i < 10; ++i)
+		{
+			frames[i].id = NET::standard_id(0x100);
+			frames[i].dlc = 8;
+			info[i].ifindex = 3;
+			info[i].sec = 1000;
+			info[i].nsec = i * 10000000 + (i == 5 ? 3000000 : 0);
+		}
+		info[0].sec = 0;
+		info[0].nsec = 0;
+
+		NET::CANStats stats(500000);
+		stats.record( frames, info, 10);
+
+		NET::CANStats::Snapshot snapshot = stats.snapshot();
+		CPPUNIT_ASSERT_EQUAL( size_t(1), snapshot.interfaces.size() );
+		CPPUNIT_ASSERT_EQUAL( size_t(1), snapshot.ids.size() );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), snapshot.untracked );
+
+		// the frame without timestamp is ignored
+		const NET::CANStats::IdStatistics& id = snapshot.ids[0];
+		CPPUNIT_ASSERT_EQUAL( 3, id.ifindex );
+		CPPUNIT_ASSERT_EQUAL( 0x100u, static_cast<unsigned>(id.id.value) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(9), id.frames );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(7000000), id.minPeriod );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(13000000), id.maxPeriod );
+		CPPUNIT_ASSERT( id.rate() > 99.9 && id.rate() < 100.1 );
+
+		// 7 periods compared to the average: 2 exact, 2 about 3 ms off,
+		// 3 about 10 us off as the average settles again
+		uint32_t compared = 0;
+		for( unsigned b = 0; b < NET::CANStats::JITTER_BUCKETS; ++b)
+			compared += id.jitter[b];
+		CPPUNIT_ASSERT_EQUAL( 7u, compared );
+		CPPUNIT_ASSERT_EQUAL( 2u, id.jitter[0] );
+		CPPUNIT_ASSERT_EQUAL( 3u, id.jitter[4] );
+		CPPUNIT_ASSERT_EQUAL( 2u, id.jitter[12] );
+
+		// 8 data bytes on a standard frame take at most 135 bits
+		const NET::CANStats::InterfaceStatistics& interface = snapshot.interfaces[0];
+		CPPUNIT_ASSERT_EQUAL( uint64_t(9 * 135), interface.bits );
+		CPPUNIT_ASSERT( interface.load() > 0.030 && interface.load() < 0.031 );
+
+		stats.reset();
+		CPPUNIT_ASSERT( stats.snapshot().ids.empty() );
+	}
+
+	void testCyclicOnVcan()
+	{
+		NET::CANBcmSocket bcm_socket;
+		NET::CANRawSocket recv_socket;
+		bcm_socket.connect("vcan0");
+		recv_socket.bind("vcan0");
+
+		NET::can_frame frame;
+		std::memset( &frame, 0, sizeof(frame));
+		frame.id = NET::extended_id(0x1234);
+		frame.dlc = 4;
+		bcm_socket.startCyclic( frame, 5000);
+
+		NET::CANStats stats(500000);
+		unsigned count = 0;
+		while( count < 50)
+		{
+			unsigned n = recv_socket.timedReadFrames( frames, info, 10, 100);
+			CPPUNIT_ASSERT( n > 0 );
+			stats.record( frames, info, n);
+			count += n;
+		}
+		bcm_socket.stopCyclic( frame.id);
+
+		NET::CANStats::Snapshot snapshot = stats.snapshot();
+		CPPUNIT_ASSERT_EQUAL( size_t(1), snapshot.ids.size() );
+		CPPUNIT_ASSERT_EQUAL( static_cast<int>( if_nametoindex("vcan0")), snapshot.ids[0].ifindex );
+		CPPUNIT_ASSERT( snapshot.ids[0].rate() > 150 && snapshot.ids[0].rate() < 250 );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CANStats_TEST );
@@ -0,0 +1,156 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../LossMonitor.h"
+
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <cstring>
+
+static char recv_msg[64];
+
+class LossMonitor_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( LossMonitor_TEST );
+	CPPUNIT_TEST( testSequenceGaps );
+	CPPUNIT_TEST( testKernelDrops );
+	CPPUNIT_TEST( testResetWithQueuedDatagrams );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::UDPSocket* send_socket;
+	NET::UDPSocket* recv_socket;
+
+	void sendSequence( uint32_t sequence)
+	{
+		// sequence number behind a 4 byte header
+		char msg[16] = "seq:";
+		uint32_t value = htonl(sequence);
+		std::memcpy( msg + 4, &value, sizeof(value));
+		send_socket->send( msg, sizeof(msg));
+	}
+
+	void receiveSequence( NET::LossMonitor& monitor, uint32_t sequence)
+	{
+		sendSequence( sequence);
+		CPPUNIT_ASSERT_EQUAL( 16, monitor.timedReceive( recv_msg, sizeof(recv_msg), 100) );
+	}
+
+public:
+	void setUp()
+	{
+		send_socket = new NET::UDPSocket();
+		recv_socket = new NET::UDPSocket();
+		recv_socket->bind( "127.0.0.1", 47777);
+		send_socket->connect( "127.0.0.1", 47777);
+	}
+
+	void tearDown()
+	{
+		delete send_socket;
+		delete recv_socket;
+	}
+
+	void testSequenceGaps()
+	{
+		NET::LossMonitor monitor(*recv_socket);
+		monitor.setSequenceField( 4, 4);
+
+		// 3 and 4 go missing, 4 arrives late and twice, which leaves a gap of 1
+		const uint32_t sequence[] = { 0xfffffffe, 0xffffffff, 0, 1, 2, 5, 4, 4, 6 };
+		const int count = sizeof(sequence) / sizeof(sequence[0]);
+		for( int i = 0; i < count; ++i)
+			sendSequence( sequence[i]);
+
+		for( int i = 0; i < count; ++i)
+			CPPUNIT_ASSERT_EQUAL( 16, monitor.timedReceive( recv_msg, sizeof(recv_msg), 100) );
+
+		NET::LossMonitor::Statistics stats = monitor.statistics();
+		CPPUNIT_ASSERT_EQUAL( uint64_t(count), stats.received );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.lost );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.bursts );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.maxBurst );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.reordered );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.maxReorderDepth );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.duplicates );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), stats.kernelDrops );
+		CPPUNIT_ASSERT( stats.lossRate() > 0.11 && stats.lossRate() < 0.12 );
+
+		monitor.reset();
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), monitor.statistics().received );
+		CPPUNIT_ASSERT_THROW( monitor.setSequenceField( 0, 3), NET::SocketException );
+
+		// pure reordering is no burst
+		receiveSequence( monitor, 10);
+		receiveSequence( monitor, 12);
+		receiveSequence( monitor, 11);
+		stats = monitor.statistics();
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), stats.lost );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), stats.bursts );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), stats.maxBurst );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.reordered );
+
+		// filling the middle of a gap splits it
+		receiveSequence( monitor, 16);
+		CPPUNIT_ASSERT_EQUAL( uint64_t(3), monitor.statistics().maxBurst );
+		receiveSequence( monitor, 14);
+		stats = monitor.statistics();
+		CPPUNIT_ASSERT_EQUAL( uint64_t(2), stats.lost );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(2), stats.bursts );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(1), stats.maxBurst );
+
+		// a gap leaving the window keeps its length
+		receiveSequence( monitor, 100);
+		receiveSequence( monitor, 15);
+		stats = monitor.statistics();
+		CPPUNIT_ASSERT_EQUAL( uint64_t(83), stats.maxBurst );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(3), stats.bursts );
+	}
+
+	void testKernelDrops()
+	{
+		// the kernel rounds this up to its minimum buffer size
+		int size = 1;
+		setsockopt( recv_socket->nativeHandle(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+		NET::LossMonitor monitor(*recv_socket);
+
+		const int count = 100;
+		for( int i = 0; i < count; ++i)
+			sendSequence( static_cast<uint32_t>(i));
+
+		while( monitor.timedReceive( recv_msg, sizeof(recv_msg), 10) > 0);
+
+		// the drop counter arrives with the next queued datagram
+		sendSequence( count);
+		CPPUNIT_ASSERT_EQUAL( 16, monitor.timedReceive( recv_msg, sizeof(recv_msg), 100) );
+
+		NET::LossMonitor::Statistics stats = monitor.statistics();
+		CPPUNIT_ASSERT( stats.received < uint64_t(count) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(count + 1), stats.received + stats.kernelDrops );
+	}
+
+	void testResetWithQueuedDatagrams()
+	{
+		int size = 1;
+		setsockopt( recv_socket->nativeHandle(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+		NET::LossMonitor monitor(*recv_socket);
+
+		// the counter is only passed along once the kernel dropped datagrams
+		const int count = 100;
+		for( int i = 0; i < count; ++i)
+			sendSequence( static_cast<uint32_t>(i));
+		while( monitor.timedReceive( recv_msg, sizeof(recv_msg), 10) > 0);
+
+		for( int i = 0; i < count; ++i)
+			sendSequence( static_cast<uint32_t>(i));
+
+		// the queued datagrams carry drop counters from before the reset
+		monitor.reset();
+		int received = 0;
+		while( monitor.timedReceive( recv_msg, sizeof(recv_msg), 10) > 0)
+			++received;
+
+		CPPUNIT_ASSERT( received > 0 && received < count );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), monitor.statistics().kernelDrops );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LossMonitor_TEST );
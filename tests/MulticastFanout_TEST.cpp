@@ -0,0 +1,134 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../MulticastFanout.h"
+
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
+static const int len = sizeof(send_msg);
+
+class MulticastFanout_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( MulticastFanout_TEST );
+	CPPUNIT_TEST( testFanout );
+	CPPUNIT_TEST( testManySenders );
+	CPPUNIT_TEST( testDrops );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::UDPSocket* send_socket;
+
+public:
+	void setUp()
+	{
+		send_socket = new NET::UDPSocket();
+	}
+
+	void tearDown()
+	{
+		delete send_socket;
+	}
+
+	void testFanout()
+	{
+		const int datagrams = 20;
+		std::atomic<int> received(0);
+		std::atomic<int> corrupted(0);
+
+		NET::MulticastFanout fanout( "224.40.0.1", 47777, 2);
+		CPPUNIT_ASSERT_EQUAL( 2u, fanout.shards() );
+		fanout.start( [&]( unsigned, const void* data, size_t size) {
+			if( size != len || std::memcmp( send_msg, data, size) != 0)
+				++corrupted;
+			++received;
+		});
+
+		send_socket->setMulticastTTL(0);
+		send_socket->connect( "224.40.0.1", 47777);
+		for( int i = 0; i < datagrams; ++i)
+			send_socket->send( send_msg, len);
+
+		// every datagram must be received by exactly one shard
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while( received < datagrams && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for( std::chrono::milliseconds(1));
+		std::this_thread::sleep_for( std::chrono::milliseconds(50));
+		fanout.stop();
+
+		CPPUNIT_ASSERT_EQUAL( datagrams, received.load() );
+		CPPUNIT_ASSERT_EQUAL( 0, corrupted.load() );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(datagrams), fanout.received(0) + fanout.received(1) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), fanout.drops(0) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), fanout.drops(1) );
+		CPPUNIT_ASSERT_EQUAL( 0, fanout.error(0) );
+		CPPUNIT_ASSERT_EQUAL( 0, fanout.error(1) );
+	}
+
+	void testManySenders()
+	{
+		// flows of many senders hash to both shards, rejecting a foreign datagram is no loss
+		const int senders = 20;
+		const int datagrams = 10;
+		std::atomic<int> received(0);
+
+		NET::MulticastFanout fanout( "224.40.0.1", 47777, 2, NET::MulticastFanout::BY_HASH);
+		fanout.start( [&]( unsigned, const void*, size_t) { ++received; });
+
+		for( int s = 0; s < senders; ++s)
+		{
+			NET::UDPSocket sender;
+			sender.setMulticastTTL(0);
+			sender.connect( "224.40.0.1", 47777);
+			for( int i = 0; i < datagrams; ++i)
+				sender.send( send_msg, len);
+		}
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+		while( received < senders * datagrams && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for( std::chrono::milliseconds(1));
+		fanout.stop();
+
+		CPPUNIT_ASSERT_EQUAL( senders * datagrams, received.load() );
+		CPPUNIT_ASSERT( fanout.received(0) > 0 );
+		CPPUNIT_ASSERT( fanout.received(1) > 0 );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), fanout.drops(0) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(0), fanout.drops(1) );
+	}
+
+	void testDrops()
+	{
+		const int datagrams = 200;
+		std::vector<char> large( 8192);
+
+		// nobody reads and the receive buffers are small, so most datagrams are lost
+		NET::MulticastFanout fanout( "224.40.0.1", 47777, 2, NET::MulticastFanout::BY_HASH);
+		for( unsigned i = 0; i < fanout.shards(); ++i)
+		{
+			int size = 1;
+			setsockopt( fanout.socket(i).nativeHandle(), SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+		}
+
+		for( int s = 0; s < datagrams; ++s)
+		{
+			NET::UDPSocket sender;
+			sender.setMulticastTTL(0);
+			sender.connect( "224.40.0.1", 47777);
+			sender.send( large.data(), large.size());
+		}
+
+		std::atomic<int> received(0);
+		fanout.start( [&]( unsigned, const void*, size_t) { ++received; });
+		std::this_thread::sleep_for( std::chrono::milliseconds(200));
+		fanout.stop();
+
+		// both shards overflow, and every datagram is either received or lost by its shard
+		CPPUNIT_ASSERT( fanout.drops(0) > 0 );
+		CPPUNIT_ASSERT( fanout.drops(1) > 0 );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(received.load()), fanout.received(0) + fanout.received(1) );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(datagrams), fanout.drops(0) + fanout.drops(1) + uint64_t(received.load()) );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( MulticastFanout_TEST );
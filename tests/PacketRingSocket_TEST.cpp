@@ -0,0 +1,93 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../PacketRingSocket.h"
+
+#include <cstring>
+
+static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
+static const int len = sizeof(send_msg);
+
+// IEEE 802 local experimental ethertype
+static const uint8_t ether_type[] = { 0x88, 0xb5 };
+
+class PacketRingSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( PacketRingSocket_TEST );
+	CPPUNIT_TEST( testTransmitReceive );
+	CPPUNIT_TEST( testFanout );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	uint8_t test_frame[14 + sizeof(send_msg)];
+
+	// count the test frames, other traffic on the interface is skipped
+	int receiveTestFrames( NET::PacketRingSocket& socket, int expected)
+	{
+		int received = 0;
+		NET::PacketRingSocket::FrameIterator frames;
+		NET::PacketRingSocket::Frame frame;
+		while( received < expected && socket.receiveBlock( frames, 100))
+		{
+			while( frames.next(frame))
+			{
+				if( frame.len != sizeof(test_frame) || std::memcmp( frame.data + 12, ether_type, 2) != 0)
+					continue;
+				if( frame.type == PACKET_OUTGOING)
+					continue;
+				CPPUNIT_ASSERT( std::memcmp( frame.data + 14, send_msg, len) == 0 );
+				CPPUNIT_ASSERT_EQUAL( frame.len, frame.wireLen );
+				++received;
+			}
+		}
+		return received;
+	}
+
+public:
+	void setUp()
+	{
+		std::memset( test_frame, 0, 12);
+		std::memcpy( test_frame + 12, ether_type, 2);
+		std::memcpy( test_frame + 14, send_msg, len);
+	}
+
+	void tearDown() {}
+
+	void testTransmitReceive()
+	{
+		NET::PacketRingSocket send_socket( "lo", 1 << 16, 4, 2048, 16);
+		NET::PacketRingSocket recv_socket( "lo", 1 << 16, 4, 2048, 0);
+		recv_socket.setIgnoreOutgoing(true);
+		CPPUNIT_ASSERT_THROW( recv_socket.queueFrame( test_frame, sizeof(test_frame)), NET::SocketException );
+
+		const int count = 10;
+		for( int i = 0; i < count; ++i)
+			CPPUNIT_ASSERT( send_socket.queueFrame( test_frame, sizeof(test_frame)) );
+		CPPUNIT_ASSERT_EQUAL( count * static_cast<int>(sizeof(test_frame)), send_socket.flush() );
+
+		int received = receiveTestFrames( recv_socket, count);
+		CPPUNIT_ASSERT_EQUAL( count, received );
+		CPPUNIT_ASSERT_EQUAL( 0u, recv_socket.statistics().drops );
+	}
+
+	void testFanout()
+	{
+		NET::PacketRingSocket send_socket( "lo", 1 << 16, 1, 2048, 16);
+		NET::PacketRingSocket recv_socket1( "lo", 1 << 16, 4, 2048, 0);
+		NET::PacketRingSocket recv_socket2( "lo", 1 << 16, 4, 2048, 0);
+		recv_socket1.setFanout( 4711, NET::PacketRingSocket::FANOUT_LB);
+		recv_socket2.setFanout( 4711, NET::PacketRingSocket::FANOUT_LB);
+
+		const int count = 10;
+		for( int i = 0; i < count; ++i)
+			CPPUNIT_ASSERT( send_socket.queueFrame( test_frame, sizeof(test_frame)) );
+		send_socket.flush();
+
+		// every frame is delivered to only one socket of the group
+		int received = receiveTestFrames( recv_socket1, count / 2);
+		received += receiveTestFrames( recv_socket2, count - received);
+		CPPUNIT_ASSERT_EQUAL( count, received );
+		received = receiveTestFrames( recv_socket1, 1) + receiveTestFrames( recv_socket2, 1);
+		CPPUNIT_ASSERT_EQUAL( 0, received );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( PacketRingSocket_TEST );
@@ -0,0 +1,68 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../SCTPMessageReader.h"
+
+#include <vector>
+
+class SCTPMessageReader_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( SCTPMessageReader_TEST );
+	CPPUNIT_TEST( testReassembly );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::SCTPSocket* server_socket;
+	NET::SCTPSocket* client_socket;
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::SCTPSocket();
+		client_socket = new NET::SCTPSocket();
+	}
+
+	void tearDown()
+	{
+		delete server_socket;
+		delete client_socket;
+	}
+
+	void testReassembly()
+	{
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		NET::SCTPMessageReader reader( session_socket, 256);
+		CPPUNIT_ASSERT_EQUAL( size_t(256), reader.bufferSize() );
+
+		std::vector<uint8_t> large(100000);
+		for( size_t i = 0; i < large.size(); ++i)
+			large[i] = static_cast<uint8_t>(i * 7);
+		client_socket->send( large.data(), large.size(), 3, 0, 0, 42);
+
+		NET::SCTPMessageReader::Message message;
+		CPPUNIT_ASSERT( reader.receive( message, 1000) );
+		CPPUNIT_ASSERT_EQUAL( large.size(), message.size() );
+		CPPUNIT_ASSERT( std::equal( large.begin(), large.end(), message.data()) );
+		CPPUNIT_ASSERT_EQUAL( uint16_t(3), message.stream() );
+		CPPUNIT_ASSERT_EQUAL( 42u, message.ppid() );
+		CPPUNIT_ASSERT( reader.bufferSize() >= large.size() );
+
+		// after two windows of small messages the buffers shrink again
+		const char small[] = "small";
+		for( int i = 0; i < 128; ++i)
+		{
+			client_socket->send( small, sizeof(small), 1);
+			CPPUNIT_ASSERT( reader.receive( message, 1000) );
+			CPPUNIT_ASSERT_EQUAL( sizeof(small), message.size() );
+		}
+		message.release();
+		CPPUNIT_ASSERT_EQUAL( size_t(256), reader.bufferSize() );
+		CPPUNIT_ASSERT_EQUAL( size_t(1), reader.pooled() );
+
+		CPPUNIT_ASSERT( !reader.receive( message, 10) );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCTPMessageReader_TEST );
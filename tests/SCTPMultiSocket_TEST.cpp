@@ -0,0 +1,128 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../SCTPMultiSocket.h"
+
+#include <cstring>
+#include <string>
+
+class SCTPMultiSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( SCTPMultiSocket_TEST );
+	CPPUNIT_TEST( testAssociations );
+	CPPUNIT_TEST( testIncomplete );
+	CPPUNIT_TEST( testPeelOff );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::SCTPMultiSocket* server_socket;
+	NET::SCTPSocket* client1_socket;
+	NET::SCTPSocket* client2_socket;
+
+	// receive one message on the server, with the association it came from
+	std::string receive( NET::SCTPMultiSocket::AssociationId& assoc, uint16_t& stream)
+	{
+		char buffer[256];
+		int ret = server_socket->timedReceive( buffer, sizeof(buffer), assoc, stream, 1000);
+		CPPUNIT_ASSERT( ret > 0 );
+		return std::string( buffer, static_cast<size_t>(ret));
+	}
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::SCTPMultiSocket();
+		client1_socket = new NET::SCTPSocket();
+		client2_socket = new NET::SCTPSocket();
+
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client1_socket->connect( "127.0.0.1", 47777);
+		client2_socket->connect( "127.0.0.1", 47777);
+	}
+
+	void tearDown()
+	{
+		delete client1_socket;
+		delete client2_socket;
+		delete server_socket;
+	}
+
+	void testAssociations()
+	{
+		client1_socket->send( "one", 3, 1);
+		client2_socket->send( "two", 3, 2);
+
+		NET::SCTPMultiSocket::AssociationId assocs[2];
+		uint16_t stream;
+		for( int i = 0; i < 2; ++i)
+		{
+			NET::SCTPMultiSocket::AssociationId assoc;
+			std::string message = receive( assoc, stream);
+			int client = message == "one" ? 0 : 1;
+			CPPUNIT_ASSERT_EQUAL( std::string(client ? "two" : "one"), message );
+			CPPUNIT_ASSERT_EQUAL( uint16_t(client + 1), stream );
+			assocs[client] = assoc;
+		}
+		CPPUNIT_ASSERT( assocs[0] != assocs[1] );
+		CPPUNIT_ASSERT_EQUAL( size_t(2), server_socket->associations().size() );
+
+		// replies reach only the addressed peer
+		CPPUNIT_ASSERT_EQUAL( 5, server_socket->send( "reply", 5, assocs[1], 3) );
+		char buffer[16];
+		CPPUNIT_ASSERT_EQUAL( 5, client2_socket->timedReceive( buffer, sizeof(buffer), stream, 1000) );
+		CPPUNIT_ASSERT_EQUAL( uint16_t(3), stream );
+		CPPUNIT_ASSERT( std::memcmp( buffer, "reply", 5) == 0 );
+		CPPUNIT_ASSERT_EQUAL( 0, client1_socket->timedReceive( buffer, sizeof(buffer), stream, 10) );
+	}
+
+	void testIncomplete()
+	{
+		char message[100];
+		for( size_t i = 0; i < sizeof(message); ++i)
+			message[i] = static_cast<char>(i);
+		client1_socket->send( message, sizeof(message), 0);
+
+		// a small buffer receives the message in parts
+		char buffer[60];
+		NET::SCTPMultiSocket::AssociationId assoc, rest;
+		uint16_t stream;
+		NET::SCTPSocket::receiveFlag flag;
+		CPPUNIT_ASSERT_EQUAL( 60, server_socket->timedReceive( buffer, sizeof(buffer), assoc, stream, flag, 1000) );
+		CPPUNIT_ASSERT( flag == NET::SCTPSocket::INCOMPLETE );
+		CPPUNIT_ASSERT( std::memcmp( buffer, message, 60) == 0 );
+
+		CPPUNIT_ASSERT_EQUAL( 40, server_socket->receive( buffer, sizeof(buffer), rest, stream, flag) );
+		CPPUNIT_ASSERT( flag == NET::SCTPSocket::NO_FLAGS );
+		CPPUNIT_ASSERT_EQUAL( assoc, rest );
+		CPPUNIT_ASSERT( std::memcmp( buffer, message + 60, 40) == 0 );
+	}
+
+	void testPeelOff()
+	{
+		client1_socket->send( "one", 3, 0);
+		client2_socket->send( "two", 3, 0);
+
+		NET::SCTPMultiSocket::AssociationId assoc, other;
+		uint16_t stream;
+		std::string first = receive( assoc, stream);
+		receive( other, stream);
+
+		// the peeled off association is served by its own socket
+		NET::SCTPSocket peeled( server_socket->peelOff( assoc));
+		CPPUNIT_ASSERT_EQUAL( size_t(1), server_socket->associations().size() );
+		CPPUNIT_ASSERT_EQUAL( other, server_socket->associations()[0] );
+
+		NET::SCTPSocket& client = first == "one" ? *client1_socket : *client2_socket;
+		client.send( "again", 5, 0);
+
+		char buffer[16];
+		CPPUNIT_ASSERT_EQUAL( 5, peeled.timedReceive( buffer, sizeof(buffer), stream, 1000) );
+		CPPUNIT_ASSERT( std::memcmp( buffer, "again", 5) == 0 );
+		CPPUNIT_ASSERT_EQUAL( 0, server_socket->timedReceive( buffer, sizeof(buffer), other, stream, 10) );
+
+		CPPUNIT_ASSERT_EQUAL( 3, peeled.send( "bye", 3, 0) );
+		CPPUNIT_ASSERT_EQUAL( 3, client.timedReceive( buffer, sizeof(buffer), stream, 1000) );
+		CPPUNIT_ASSERT_THROW( server_socket->peelOff( assoc), NET::SocketException );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCTPMultiSocket_TEST );
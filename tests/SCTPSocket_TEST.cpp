@@ -0,0 +1,194 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../SCTPSocket.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+class SCTPSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( SCTPSocket_TEST );
+	CPPUNIT_TEST( testStreamScheduler );
+	CPPUNIT_TEST( testControlLatency );
+	CPPUNIT_TEST( testSendBatch );
+	CPPUNIT_TEST( testNotification );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::SCTPSocket* server_socket;
+	NET::SCTPSocket* client_socket;
+
+	typedef std::chrono::steady_clock Clock;
+
+	// median latency of control messages on stream 0 while stream 1 is saturated
+	Clock::duration controlLatency( NET::SCTPSocket& sender, NET::SCTPSocket& receiver)
+	{
+		const int controls = 50;
+		std::atomic<bool> running(true);
+
+		std::thread bulk( [&]() {
+			std::vector<char> chunk(8192);
+			while( running)
+				sender.send( chunk.data(), chunk.size(), 1);
+		});
+
+		std::vector<Clock::duration> latencies;
+		std::thread control( [&]() {
+			for( int i = 0; i < controls; ++i)
+			{
+				std::this_thread::sleep_for( std::chrono::milliseconds(5));
+				Clock::rep sent = Clock::now().time_since_epoch().count();
+				sender.send( &sent, sizeof(sent), 0);
+			}
+		});
+
+		std::vector<char> buffer(8192);
+		uint16_t stream;
+		while( latencies.size() < static_cast<size_t>(controls))
+		{
+			int ret = receiver.timedReceive( buffer.data(), buffer.size(), stream, 1000);
+			if( ret <= 0) break;
+			if( stream != 0) continue;
+
+			Clock::rep sent;
+			std::copy( buffer.data(), buffer.data() + sizeof(sent), reinterpret_cast<char*>(&sent));
+			latencies.push_back( Clock::now().time_since_epoch() - Clock::duration(sent));
+		}
+
+		running = false;
+		control.join();
+		// drain the bulk stream so the sender does not block forever
+		while( receiver.timedReceive( buffer.data(), buffer.size(), stream, 100) > 0) ;
+		bulk.join();
+
+		CPPUNIT_ASSERT_EQUAL( static_cast<size_t>(controls), latencies.size() );
+		std::sort( latencies.begin(), latencies.end());
+		return latencies[latencies.size() / 2];
+	}
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::SCTPSocket();
+		client_socket = new NET::SCTPSocket();
+	}
+
+	void tearDown()
+	{
+		delete server_socket;
+		delete client_socket;
+	}
+
+	void testStreamScheduler()
+	{
+		client_socket->setStreamScheduler( NET::SCTPSocket::SCHEDULER_PRIORITY);
+		CPPUNIT_ASSERT( NET::SCTPSocket::SCHEDULER_PRIORITY == client_socket->getStreamScheduler() );
+
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		CPPUNIT_ASSERT( NET::SCTPSocket::SCHEDULER_PRIORITY == client_socket->getStreamScheduler() );
+		client_socket->setStreamPriority( 1, 7);
+		CPPUNIT_ASSERT_EQUAL( uint16_t(7), client_socket->getStreamPriority(1) );
+
+		client_socket->setStreamScheduler( NET::SCTPSocket::SCHEDULER_ROUND_ROBIN);
+		CPPUNIT_ASSERT( NET::SCTPSocket::SCHEDULER_ROUND_ROBIN == client_socket->getStreamScheduler() );
+	}
+
+	void testControlLatency()
+	{
+		client_socket->setStreamScheduler( NET::SCTPSocket::SCHEDULER_PRIORITY);
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		client_socket->setStreamPriority( 0, 0);
+		client_socket->setStreamPriority( 1, 1);
+		Clock::duration prioritized = controlLatency( *client_socket, session_socket);
+
+		client_socket->setStreamScheduler( NET::SCTPSocket::SCHEDULER_FCFS);
+		Clock::duration fcfs = controlLatency( *client_socket, session_socket);
+
+		// the control stream must not queue up behind the bulk stream
+		CPPUNIT_ASSERT( prioritized < std::chrono::milliseconds(20) );
+		CPPUNIT_ASSERT( prioritized <= fcfs );
+	}
+
+	void testSendBatch()
+	{
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		const size_t count = 200;
+		const size_t invalid = 100;
+		std::vector<uint32_t> payload(count);
+		std::vector<NET::SCTPSocket::BatchMessage> messages(count);
+		for( size_t i = 0; i < count; ++i)
+		{
+			payload[i] = static_cast<uint32_t>(i);
+			NET::SCTPSocket::BatchMessage& message = messages[i];
+			message.data = &payload[i];
+			message.length = sizeof(uint32_t);
+			message.stream = static_cast<uint16_t>(i % 4);
+			message.ppid = 0;
+			message.context = 0;
+			message.flags = (i % 2) ? NET::SCTPSocket::UNORDERED : 0;
+			message.result = 0;
+		}
+		// the association has only 10 outgoing streams
+		messages[invalid].stream = 50;
+
+		CPPUNIT_ASSERT_EQUAL( count - 1, client_socket->sendBatch( messages.data(), count) );
+		for( size_t i = 0; i < count; ++i)
+		{
+			if( i == invalid)
+				CPPUNIT_ASSERT( messages[i].result < 0 );
+			else
+				CPPUNIT_ASSERT_EQUAL( int(sizeof(uint32_t)), messages[i].result );
+		}
+
+		uint32_t value;
+		uint16_t stream;
+		size_t received = 0;
+		while( session_socket.timedReceive( &value, sizeof(value), stream, 100) > 0)
+		{
+			CPPUNIT_ASSERT( value != invalid );
+			CPPUNIT_ASSERT_EQUAL( uint16_t(value % 4), stream );
+			++received;
+		}
+		CPPUNIT_ASSERT_EQUAL( count - 1, received );
+	}
+
+	void testNotification()
+	{
+		client_socket->subscribe( NET::SCTPSocket::EVENT_ASSOCIATION_CHANGE);
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		// the buffer is smaller than the notification, which must be read completely
+		char buffer[4];
+		uint16_t stream;
+		NET::SCTPSocket::Notification notification;
+		CPPUNIT_ASSERT_EQUAL( 0, client_socket->timedReceive( buffer, sizeof(buffer), stream, notification, 100) );
+		CPPUNIT_ASSERT( notification.type == NET::SCTPSocket::Notification::ASSOCIATION_CHANGE );
+		CPPUNIT_ASSERT( notification.state == SCTP_COMM_UP );
+
+		// the next read is not a left over of the notification
+		session_socket.send( "data", 4, 0);
+		CPPUNIT_ASSERT_EQUAL( 4, client_socket->timedReceive( buffer, sizeof(buffer), stream, notification, 100) );
+		CPPUNIT_ASSERT( notification.type == NET::SCTPSocket::Notification::NONE );
+
+		CPPUNIT_ASSERT_EQUAL( std::string("127.0.0.1"), client_socket->status().primary.address );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCTPSocket_TEST );
@@ -0,0 +1,118 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../SCTPStreamDispatcher.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+class SCTPStreamDispatcher_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( SCTPStreamDispatcher_TEST );
+	CPPUNIT_TEST( testOrderPerStream );
+	CPPUNIT_TEST( testLargeMessages );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::SCTPSocket* server_socket;
+	NET::SCTPSocket* client_socket;
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::SCTPSocket();
+		client_socket = new NET::SCTPSocket();
+	}
+
+	void tearDown()
+	{
+		delete server_socket;
+		delete client_socket;
+	}
+
+	void testOrderPerStream()
+	{
+		const unsigned streams = 4;
+		const uint32_t messages = 500;
+
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		std::mutex mutex;
+		std::vector<uint32_t> next( streams, 0);
+		std::atomic<unsigned> received(0);
+		std::atomic<unsigned> misordered(0);
+
+		// a tiny queue forces the receiver to wait for the workers
+		NET::SCTPStreamDispatcher dispatcher( session_socket, 2, 4, 1024, streams);
+		dispatcher.start( [&]( uint16_t stream, const void* data, size_t len) {
+			uint32_t seq;
+			if( len != sizeof(seq) || stream >= streams)
+			{
+				++misordered;
+				return;
+			}
+			std::memcpy( &seq, data, sizeof(seq));
+			std::lock_guard<std::mutex> lock(mutex);
+			if( seq != next[stream]++)
+				++misordered;
+			++received;
+		});
+
+		for( uint32_t i = 0; i < messages; ++i)
+			for( uint16_t stream = 0; stream < streams; ++stream)
+				client_socket->send( &i, sizeof(i), stream);
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while( received < messages * streams && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for( std::chrono::milliseconds(1));
+		dispatcher.stop();
+
+		CPPUNIT_ASSERT_EQUAL( messages * streams, received.load() );
+		CPPUNIT_ASSERT_EQUAL( 0u, misordered.load() );
+		CPPUNIT_ASSERT_EQUAL( 0, dispatcher.error() );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(messages * streams), dispatcher.received() );
+		for( uint16_t stream = 0; stream < streams; ++stream)
+			CPPUNIT_ASSERT_EQUAL( uint64_t(messages), dispatcher.received(stream) );
+	}
+
+	void testLargeMessages()
+	{
+		const unsigned messages = 10;
+
+		server_socket->bind( "127.0.0.1", 47777);
+		server_socket->listen();
+		client_socket->connect( "127.0.0.1", 47777);
+		NET::SCTPSocket session_socket( server_socket->accept());
+
+		std::vector<uint8_t> message( 3000);
+		for( size_t i = 0; i < message.size(); ++i)
+			message[i] = static_cast<uint8_t>(i);
+
+		// every message takes three receive buffers, but is handed over in one piece
+		std::atomic<unsigned> received(0);
+		std::atomic<unsigned> corrupted(0);
+		NET::SCTPStreamDispatcher dispatcher( session_socket, 1, 4, 1024, 1);
+		dispatcher.start( [&]( uint16_t, const void* data, size_t len) {
+			if( len != message.size() || std::memcmp( data, message.data(), len) != 0)
+				++corrupted;
+			++received;
+		});
+
+		for( unsigned i = 0; i < messages; ++i)
+			client_socket->send( message.data(), message.size(), 0);
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while( received < messages && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for( std::chrono::milliseconds(1));
+		dispatcher.stop();
+
+		CPPUNIT_ASSERT_EQUAL( messages, received.load() );
+		CPPUNIT_ASSERT_EQUAL( 0u, corrupted.load() );
+		CPPUNIT_ASSERT_EQUAL( uint64_t(messages), dispatcher.received() );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SCTPStreamDispatcher_TEST );
@@ -0,0 +1,250 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../ShmChannel.h"
+#include "../UnixStreamSocket.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static const char sock_file[] = "/tmp/simple-socket_shm_test.sock";
+static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
+static char recv_msg[sizeof(send_msg)];
+static const int len = sizeof(send_msg);
+
+class ShmChannel_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( ShmChannel_TEST );
+	CPPUNIT_TEST( testSendReceive );
+	CPPUNIT_TEST( testWrapAround );
+	CPPUNIT_TEST( testMultipleSenders );
+	CPPUNIT_TEST( testClose );
+	CPPUNIT_TEST( testPeerCrash );
+	CPPUNIT_TEST( testCorrupted );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::UnixStreamSocket* server_socket;
+	NET::UnixStreamSocket* client_socket;
+	NET::UnixStreamSocket* session_socket;
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::UnixStreamSocket();
+		client_socket = new NET::UnixStreamSocket();
+		server_socket->bind(sock_file);
+		server_socket->listen();
+		client_socket->connect(sock_file);
+		session_socket = new NET::UnixStreamSocket( server_socket->accept());
+	}
+
+	void tearDown()
+	{
+		delete session_socket;
+		delete server_socket;
+		delete client_socket;
+		::unlink(sock_file);
+	}
+
+	void testSendReceive()
+	{
+		NET::ShmChannel creator( *session_socket, 1000);
+		NET::ShmChannel joiner( *client_socket);
+		CPPUNIT_ASSERT_EQUAL( size_t(4096 / 2 - 8), creator.maxMessageSize() );
+		CPPUNIT_ASSERT_EQUAL( creator.maxMessageSize(), joiner.maxMessageSize() );
+
+		CPPUNIT_ASSERT_EQUAL( 0, joiner.timedReceive( recv_msg, len, 10) );
+
+		CPPUNIT_ASSERT_EQUAL( len, creator.send( send_msg, len) );
+		CPPUNIT_ASSERT_EQUAL( len, joiner.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+
+		CPPUNIT_ASSERT_EQUAL( len, joiner.send( send_msg, len) );
+		std::memset( recv_msg, 0, len);
+		CPPUNIT_ASSERT_EQUAL( len, creator.timedReceive( recv_msg, len, 100) );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+
+		std::vector<char> large( creator.maxMessageSize() + 1);
+		CPPUNIT_ASSERT_THROW( creator.send( large.data(), large.size()), NET::SocketException );
+	}
+
+	void testWrapAround()
+	{
+		NET::ShmChannel creator( *session_socket, 4096);
+		NET::ShmChannel joiner( *client_socket);
+
+		// sizes not dividing the ring force padding at its end, the receiver is slower than the sender
+		const unsigned count = 20000;
+		unsigned received = 0;
+		unsigned corrupted = 0;
+
+		// assertions must not fail on this thread, the results are checked after joining it
+		std::thread receiver( [&]()
+		{
+			std::vector<uint8_t> buffer( joiner.maxMessageSize());
+			for( ; received < count; ++received)
+			{
+				int ret = joiner.timedReceive( buffer.data(), buffer.size(), 1000);
+				if( ret == 0)
+					break;
+				if( ret != int(received % 700 + 5) || std::memcmp( buffer.data(), &received, sizeof(received)) != 0 ||
+				    buffer[size_t(ret) - 1] != uint8_t(received))
+					++corrupted;
+			}
+		});
+
+		std::vector<uint8_t> buffer( 704);
+		unsigned sent = 0;
+		for( unsigned i = 0; i < count; ++i)
+		{
+			size_t size = i % 700 + 5;
+			std::memcpy( buffer.data(), &i, sizeof(i));
+			buffer[size - 1] = uint8_t(i);
+			if( creator.send( buffer.data(), size) == int(size))
+				++sent;
+		}
+		receiver.join();
+
+		CPPUNIT_ASSERT_EQUAL( count, sent );
+		CPPUNIT_ASSERT_EQUAL( count, received );
+		CPPUNIT_ASSERT_EQUAL( 0u, corrupted );
+	}
+
+	void testMultipleSenders()
+	{
+		NET::ShmChannel creator( *session_socket, 8192);
+		NET::ShmChannel joiner( *client_socket);
+
+		const unsigned senders = 4;
+		const unsigned count = 10000;
+		std::vector<std::thread> threads;
+		for( unsigned s = 0; s < senders; ++s)
+		{
+			threads.push_back( std::thread( [&creator, s]()
+			{
+				unsigned msg[2] = { s, 0 };
+				for( ; msg[1] < count; ++msg[1])
+					creator.send( msg, sizeof(msg));
+			}));
+		}
+
+		// the messages of each sender arrive in order
+		std::vector<unsigned> next( senders, 0);
+		for( unsigned i = 0; i < senders * count; ++i)
+		{
+			unsigned msg[2];
+			CPPUNIT_ASSERT_EQUAL( int(sizeof(msg)), joiner.timedReceive( msg, sizeof(msg), 1000) );
+			CPPUNIT_ASSERT( msg[0] < senders );
+			CPPUNIT_ASSERT_EQUAL( next[msg[0]], msg[1] );
+			++next[msg[0]];
+		}
+
+		for( auto& thread : threads)
+			thread.join();
+	}
+
+	void testClose()
+	{
+		std::unique_ptr<NET::ShmChannel> creator( new NET::ShmChannel( *session_socket, 4096));
+		NET::ShmChannel joiner( *client_socket);
+
+		// a receiver sleeping on the doorbell wakes up when the peer closes
+		std::thread closer( [&creator]()
+		{
+			creator->send( send_msg, len);
+			std::this_thread::sleep_for( std::chrono::milliseconds(50));
+			creator.reset();
+		});
+
+		CPPUNIT_ASSERT_EQUAL( len, joiner.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( !joiner.peerDisconnected() );
+		CPPUNIT_ASSERT_EQUAL( 0, joiner.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( joiner.peerDisconnected() );
+		closer.join();
+
+		CPPUNIT_ASSERT_EQUAL( -1, joiner.send( send_msg, len) );
+
+		// nothing was passed
+		client_socket->shutdown( NET::SimpleSocket::STOP_SEND);
+		CPPUNIT_ASSERT_THROW( NET::ShmChannel failed( *session_socket), NET::SocketException );
+	}
+
+	void testPeerCrash()
+	{
+		NET::ShmChannel creator( *session_socket, 4096);
+
+		// the peer process dies without closing the channel
+		pid_t pid = ::fork();
+		CPPUNIT_ASSERT( pid >= 0 );
+		if( pid == 0)
+		{
+			NET::ShmChannel joiner( *client_socket);
+			joiner.send( send_msg, len);
+			::_exit(0);
+		}
+		delete client_socket;
+		client_socket = nullptr;
+
+		// messages sent before are still delivered, then neither side blocks
+		CPPUNIT_ASSERT_EQUAL( len, creator.receive( recv_msg, len) );
+		CPPUNIT_ASSERT_EQUAL( 0, creator.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( creator.peerDisconnected() );
+
+		int ret = 0;
+		for( int i = 0; i < 1000 && ret >= 0; ++i)
+			ret = creator.send( send_msg, len);
+		CPPUNIT_ASSERT_EQUAL( -1, ret );
+
+		int status;
+		CPPUNIT_ASSERT_EQUAL( pid, ::waitpid( pid, &status, 0) );
+	}
+
+	void testCorrupted()
+	{
+		NET::ShmChannel creator( *session_socket, 4096);
+		NET::ShmChannel joiner( *client_socket);
+
+		CPPUNIT_ASSERT_EQUAL( len, creator.send( send_msg, len) );
+
+		// the peer shares the memory, a broken length must not let the receiver read beyond the ring
+		uint8_t* record = findRecord();
+		CPPUNIT_ASSERT( record != nullptr );
+		uint64_t size = 1 << 20;
+		std::memcpy( record, &size, sizeof(size));
+
+		CPPUNIT_ASSERT_THROW( joiner.receive( recv_msg, len), NET::SocketException );
+		CPPUNIT_ASSERT_THROW( joiner.timedReceive( recv_msg, len, 10), NET::SocketException );
+	}
+
+private:
+	// both sides live in this process, find the record of send_msg in a mapping of the channel
+	static uint8_t* findRecord()
+	{
+		std::ifstream maps("/proc/self/maps");
+		std::string line;
+		while( std::getline( maps, line))
+		{
+			if( line.find("memfd:ShmChannel") == std::string::npos)
+				continue;
+
+			uintptr_t start, end;
+			if( std::sscanf( line.c_str(), "%" SCNxPTR "-%" SCNxPTR, &start, &end) != 2)
+				continue;
+			for( uintptr_t pos = start + 8; pos + len <= end; pos += 8)
+			{
+				if( std::memcmp( reinterpret_cast<const void*>(pos), send_msg, len) == 0)
+					return reinterpret_cast<uint8_t*>(pos - 8);
+			}
+		}
+		return nullptr;
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ShmChannel_TEST );
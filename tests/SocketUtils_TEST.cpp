@@ -2,12 +2,16 @@
 #include "../SocketUtils.h"
 #include <iostream>
 
+#include <net/if.h>
+#include <sys/socket.h>
+
 class SocketUtils_TEST : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE( SocketUtils_TEST);
 	CPPUNIT_TEST( resolveHostname );
 	CPPUNIT_TEST( resolveService );
 	CPPUNIT_TEST( getNetworkInterfaces );
+	CPPUNIT_TEST( getInterfaceInfo );
 	CPPUNIT_TEST( getInterfaceAddress );
 	CPPUNIT_TEST( getBroadcastAddress );
 	CPPUNIT_TEST( getNetmask );
@@ -54,6 +58,31 @@ public:
 			list[0]);
 	}
 
+	void getInterfaceInfo() {
+		auto list = NET::getInterfaceInfo();
+		CPPUNIT_ASSERT( list.size() >= 1 );
+		CPPUNIT_ASSERT_EQUAL( NET::getNetworkInterfaces().size(), list.size() );
+
+		const NET::InterfaceInfo& lo = list[0];
+		CPPUNIT_ASSERT_EQUAL( std::string("lo"), lo.name );
+		CPPUNIT_ASSERT_EQUAL( if_nametoindex("lo"), lo.index );
+		CPPUNIT_ASSERT( lo.flags & IFF_LOOPBACK );
+		CPPUNIT_ASSERT_EQUAL( static_cast<unsigned>(NET::getMTU("lo")), lo.mtu );
+		CPPUNIT_ASSERT_EQUAL( std::string("00:00:00:00:00:00"), lo.hardwareAddress );
+
+		bool found = false;
+		for( const auto& address : lo.addresses)
+		{
+			if( address.family == AF_INET && address.address == "127.0.0.1")
+			{
+				CPPUNIT_ASSERT_EQUAL( 8u, address.prefixLength );
+				CPPUNIT_ASSERT_EQUAL( std::string("lo"), address.label );
+				found = true;
+			}
+		}
+		CPPUNIT_ASSERT( found );
+	}
+
 	void getInterfaceAddress() {
 		CPPUNIT_ASSERT_EQUAL(
 			std::string("127.0.0.1"),
@@ -2,6 +2,8 @@
 #include "../TCPSocket.h"
 
 #include <cstring>
+#include <fstream>
+#include <iostream>
 
 static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
 static char recv_msg[sizeof(send_msg)];
@@ -12,6 +14,7 @@ class TCPSocket_TEST : public CppUnit::TestFixture
 	CPPUNIT_TEST_SUITE( TCPSocket_TEST );
 	CPPUNIT_TEST( testSocketHandle );
 	CPPUNIT_TEST( testPeerStatus );
+	CPPUNIT_TEST( testFastOpen );
 	CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -77,6 +80,53 @@ public:
 		CPPUNIT_ASSERT_EQUAL( -1, ret );
 		CPPUNIT_ASSERT( session_socket.peerDisconnected() );
 	}
+
+	void testFastOpen()
+	{
+		// client and server support have to be enabled by net.ipv4.tcp_fastopen
+		int mode = 0;
+		std::ifstream sysctl("/proc/sys/net/ipv4/tcp_fastopen");
+		sysctl >> mode;
+		if( !(mode & 1))
+		{
+			std::cerr << "\nNote: testFastOpen skipped, client Fast Open is disabled (net.ipv4.tcp_fastopen = "
+			          << mode << ")" << std::endl;
+			return;
+		}
+		bool server = mode & 2;
+		if( !server)
+			std::cerr << "\nNote: testFastOpen checks the fallback only, server Fast Open is disabled (net.ipv4.tcp_fastopen = "
+			          << mode << ")" << std::endl;
+
+		int ret;
+		server_socket->bind( "127.0.0.1", 47778);
+		server_socket->listen( 5, 16);
+
+		// the first connection fetches a cookie unless one is cached already, the second one uses it.
+		// Without server support, the data follows the handshake and Fast Open is never accepted
+		for( int i = 0; i < 2; ++i)
+		{
+			NET::TCPSocket client;
+			ret = client.connectAndSend( "127.0.0.1", 47778, send_msg, len);
+			CPPUNIT_ASSERT_EQUAL( len, ret );
+			CPPUNIT_ASSERT( !client.peerDisconnected() );
+
+			NET::TCPSocket::Handle handle = server_socket->accept();
+			CPPUNIT_ASSERT( handle );
+			NET::TCPSocket session_socket(handle);
+
+			ret = session_socket.receive( recv_msg, len);
+			CPPUNIT_ASSERT_EQUAL( len, ret );
+			CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+
+			if( i == 1 || !server)
+			{
+				CPPUNIT_ASSERT_EQUAL( server, client.fastOpenAccepted() );
+				CPPUNIT_ASSERT_EQUAL( server, session_socket.fastOpenAccepted() );
+			}
+			client.disconnect();
+		}
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( TCPSocket_TEST );
@@ -12,7 +12,9 @@ class UDPSocket_TEST : public CppUnit::TestFixture
 	CPPUNIT_TEST_SUITE( UDPSocket_TEST );
 	CPPUNIT_TEST( testPeerStatus );
 	CPPUNIT_TEST( testMulticast );
+	CPPUNIT_TEST( testSourceMulticast );
 	CPPUNIT_TEST( testSendTo );
+	CPPUNIT_TEST( testSegmentation );
 	CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -63,6 +65,46 @@ public:
 		CPPUNIT_ASSERT_EQUAL( 0, ret );
 	}
 
+	void testSourceMulticast()
+	{
+		int ret;
+		send_socket->setMulticastTTL(0);
+		send_socket->setMulticastInterfaceAddr("127.0.0.1");
+		recv_socket->bind(47777);
+		recv_socket->setMulticastAll(false);
+
+		recv_socket->joinSourceGroup( "232.40.0.1", "127.0.0.1", "127.0.0.1");
+		send_socket->sendTo( send_msg, len, "232.40.0.1", 47777);
+		ret = recv_socket->timedReceive( recv_msg, len, 100);
+		CPPUNIT_ASSERT_EQUAL( len, ret );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+
+		recv_socket->leaveSourceGroup( "232.40.0.1", "127.0.0.1", "127.0.0.1");
+		send_socket->sendTo( send_msg, len, "232.40.0.1", 47777);
+		ret = recv_socket->timedReceive( recv_msg, len, 1);
+		CPPUNIT_ASSERT_EQUAL( 0, ret );
+
+		std::vector<std::string> groups;
+		groups.push_back("224.40.0.1");
+		groups.push_back("224.40.0.2");
+		recv_socket->joinGroups( groups, "127.0.0.1");
+
+		// block the only source of the second group
+		std::vector<std::string> sources(1, "127.0.0.1");
+		recv_socket->setSourceFilter( "224.40.0.2", NET::UDPSocket::EXCLUDE_SOURCES, sources, "127.0.0.1");
+
+		send_socket->sendTo( send_msg, len, "224.40.0.2", 47777);
+		send_socket->sendTo( send_msg, len, "224.40.0.1", 47777);
+		ret = recv_socket->timedReceive( recv_msg, len, 100);
+		CPPUNIT_ASSERT_EQUAL( len, ret );
+		ret = recv_socket->timedReceive( recv_msg, len, 1);
+		CPPUNIT_ASSERT_EQUAL( 0, ret );
+
+		recv_socket->leaveGroups( groups, "127.0.0.1");
+		CPPUNIT_ASSERT_THROW( recv_socket->leaveGroups( groups, "127.0.0.1"), NET::SocketException );
+		CPPUNIT_ASSERT_THROW( recv_socket->joinGroup( "224.40.0.x"), NET::SocketException );
+	}
+
 	void testSendTo()
 	{
 		int ret;
@@ -83,6 +125,40 @@ public:
 		CPPUNIT_ASSERT_EQUAL( std::string("127.0.0.1"), source );
 		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
 	}
+
+	void testSegmentation()
+	{
+		// the last segment is shorter than the others
+		const unsigned short segmentSize = 10;
+		const int segments = (len + segmentSize - 1) / segmentSize;
+		recv_socket->bind(47777);
+		recv_socket->setReceiveOffload(true);
+		send_socket->sendSegmentsTo( send_msg, len, segmentSize, "127.0.0.1", 47777);
+
+		// datagrams may or may not be coalesced again on receive
+		char buffer[65536];
+		int received = 0;
+		int datagrams = 0;
+		while( received < len)
+		{
+			unsigned short size = 0;
+			int ret = recv_socket->receiveSegments( buffer, sizeof(buffer), size);
+			CPPUNIT_ASSERT( ret > 0 );
+
+			NET::UDPSocket::SegmentIterator it( buffer, static_cast<size_t>(ret), size);
+			const void* data;
+			size_t dataLen;
+			while( it.next( data, dataLen))
+			{
+				CPPUNIT_ASSERT( dataLen <= segmentSize );
+				CPPUNIT_ASSERT( std::memcmp( send_msg + received, data, dataLen) == 0 );
+				received += static_cast<int>(dataLen);
+				++datagrams;
+			}
+		}
+		CPPUNIT_ASSERT_EQUAL( len, received );
+		CPPUNIT_ASSERT_EQUAL( segments, datagrams );
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( UDPSocket_TEST );
@@ -0,0 +1,186 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../UnixChannel.h"
+
+#include <poll.h>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+class UnixChannel_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( UnixChannel_TEST );
+	CPPUNIT_TEST( testSendReceive );
+	CPPUNIT_TEST( testCoalescing );
+	CPPUNIT_TEST( testThreads );
+	CPPUNIT_TEST( testStalledConsumer );
+	CPPUNIT_TEST_SUITE_END();
+
+public:
+	void testSendReceive()
+	{
+		NET::UnixChannel::Handle first, second;
+		NET::UnixChannel::create( first, second);
+		CPPUNIT_ASSERT( first );
+		CPPUNIT_ASSERT( second );
+
+		NET::UnixChannel a(first);
+		NET::UnixChannel b(second);
+		CPPUNIT_ASSERT( !first );
+		CPPUNIT_ASSERT_EQUAL( 1u, a.coalescing() );
+
+		char buffer[64];
+		CPPUNIT_ASSERT_EQUAL( 0, b.timedReceive( buffer, sizeof(buffer), 10) );
+
+		a.post( "ping", 4);
+		CPPUNIT_ASSERT_EQUAL( 0u, a.pending() );
+		CPPUNIT_ASSERT_EQUAL( 4, b.timedReceive( buffer, sizeof(buffer), 100) );
+		CPPUNIT_ASSERT( std::memcmp( buffer, "ping", 4) == 0 );
+
+		b.send( "pong", 4);
+		CPPUNIT_ASSERT_EQUAL( 4, a.receive( buffer, sizeof(buffer)) );
+		CPPUNIT_ASSERT( std::memcmp( buffer, "pong", 4) == 0 );
+
+		// an empty message would read like the end of the channel
+		CPPUNIT_ASSERT_THROW( a.post( "", 0), NET::SocketException );
+		CPPUNIT_ASSERT_EQUAL( 0u, a.pending() );
+	}
+
+	void testCoalescing()
+	{
+		NET::UnixChannel::Handle first, second;
+		NET::UnixChannel::create( first, second);
+		NET::UnixChannel producer( first, 4);
+		NET::UnixChannel consumer( second);
+
+		struct pollfd poll;
+		poll.fd = consumer.nativeHandle();
+		poll.events = POLLIN;
+
+		// nothing reaches the consumer before the limit
+		const char* messages[] = { "a", "bb", "ccc", "dddd", "eeeee" };
+		for( unsigned i = 0; i < 3; ++i)
+			producer.post( messages[i], i + 1);
+		CPPUNIT_ASSERT_EQUAL( 3u, producer.pending() );
+		CPPUNIT_ASSERT_EQUAL( 0, ::poll( &poll, 1, 10) );
+
+		producer.post( messages[3], 4);
+		CPPUNIT_ASSERT_EQUAL( 0u, producer.pending() );
+		CPPUNIT_ASSERT_EQUAL( 1, ::poll( &poll, 1, 100) );
+
+		char storage[8][8];
+		void* buffers[8];
+		size_t maxLens[8];
+		size_t lens[8];
+		for( unsigned i = 0; i < 8; ++i)
+		{
+			buffers[i] = storage[i];
+			maxLens[i] = sizeof(storage[i]);
+		}
+
+		CPPUNIT_ASSERT_EQUAL( 4u, consumer.receiveBatch( buffers, maxLens, lens, 8) );
+		for( unsigned i = 0; i < 4; ++i)
+		{
+			CPPUNIT_ASSERT_EQUAL( size_t(i + 1), lens[i] );
+			CPPUNIT_ASSERT( std::memcmp( storage[i], messages[i], i + 1) == 0 );
+		}
+
+		producer.post( messages[4], 5);
+		CPPUNIT_ASSERT_EQUAL( 0u, consumer.timedReceiveBatch( buffers, maxLens, lens, 8, 10) );
+		producer.flush();
+		CPPUNIT_ASSERT_EQUAL( 1u, consumer.timedReceiveBatch( buffers, maxLens, lens, 8, 100) );
+		CPPUNIT_ASSERT_EQUAL( size_t(5), lens[0] );
+
+		// lowering the limit sends what is collected already
+		producer.post( messages[0], 1);
+		producer.post( messages[1], 2);
+		producer.setCoalescing(2);
+		CPPUNIT_ASSERT_EQUAL( 0u, producer.pending() );
+		CPPUNIT_ASSERT_EQUAL( 2u, consumer.timedReceiveBatch( buffers, maxLens, lens, 8, 100) );
+	}
+
+	void testThreads()
+	{
+		NET::UnixChannel::Handle first, second;
+		NET::UnixChannel::create( first, second);
+		NET::UnixChannel consumer( second);
+
+		// the producer blocks while the queue is full, its destructor would drop messages instead
+		const unsigned count = 1000;
+		std::thread thread( [&first]()
+		{
+			NET::UnixChannel producer( first, 16);
+			for( unsigned i = 0; i < count; ++i)
+				producer.post( &i, sizeof(i));
+			producer.flush();
+		});
+
+		unsigned values[64];
+		void* buffers[64];
+		size_t maxLens[64];
+		size_t lens[64];
+		for( unsigned i = 0; i < 64; ++i)
+		{
+			buffers[i] = &values[i];
+			maxLens[i] = sizeof(values[i]);
+		}
+
+		unsigned expected = 0;
+		while( expected < count)
+		{
+			unsigned received = consumer.timedReceiveBatch( buffers, maxLens, lens, 64, 1000);
+			CPPUNIT_ASSERT( received > 0 );
+			// the batch ends with an empty message once the producer is gone
+			for( unsigned i = 0; i < received && lens[i] > 0; ++i)
+				CPPUNIT_ASSERT_EQUAL( expected++, values[i] );
+		}
+		thread.join();
+
+		char buffer[4];
+		CPPUNIT_ASSERT_EQUAL( 0, consumer.receive( buffer, sizeof(buffer)) );
+	}
+
+	void testStalledConsumer()
+	{
+		NET::UnixChannel::Handle first, second;
+		NET::UnixChannel::create( first, second);
+		NET::UnixChannel consumer( second);
+
+		// more than the socket buffer holds, destroying the producer must not block
+		const unsigned count = 10000;
+		char message[256] = {};
+		{
+			NET::UnixChannel producer( first, count + 1);
+			for( unsigned i = 0; i < count; ++i)
+				producer.post( message, sizeof(message));
+		}
+
+		char storage[64][sizeof(message)];
+		void* buffers[64];
+		size_t maxLens[64];
+		size_t lens[64];
+		for( unsigned i = 0; i < 64; ++i)
+		{
+			buffers[i] = storage[i];
+			maxLens[i] = sizeof(storage[i]);
+		}
+
+		unsigned received = 0;
+		bool closed = false;
+		while( !closed)
+		{
+			unsigned n = consumer.timedReceiveBatch( buffers, maxLens, lens, 64, 100);
+			CPPUNIT_ASSERT( n > 0 );
+			for( unsigned i = 0; i < n; ++i)
+			{
+				if( lens[i] == 0)
+					closed = true;
+				else
+					++received;
+			}
+		}
+		CPPUNIT_ASSERT( received > 0 );
+		CPPUNIT_ASSERT( received < count );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( UnixChannel_TEST );
@@ -2,6 +2,7 @@
 #include "../UnixDatagramSocket.h"
 
 #include <unistd.h>
+#include <cerrno>
 #include <cstring>
 
 static const char sock_file[] = "/tmp/simple-socket_test.sock";
@@ -13,6 +14,7 @@ class UnixDatagramSocket_TEST : public CppUnit::TestFixture
 {
 	CPPUNIT_TEST_SUITE( UnixDatagramSocket_TEST );
 	CPPUNIT_TEST( testSendTo );
+	CPPUNIT_TEST( testSendToAll );
 	CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -52,6 +54,56 @@ public:
 		CPPUNIT_ASSERT_EQUAL( std::string(sock_file), source );
 		CPPUNIT_ASSERT( std::memcmp(send_msg, recv_msg, len) == 0 );
 	}
+
+	void testSendToAll()
+	{
+		static const char slow_file[] = "/tmp/simple-socket_test_slow.sock";
+		static const char missing_file[] = "/tmp/simple-socket_test_missing.sock";
+		static const char send_file[] = "/tmp/simple-socket_test_send.sock";
+		::unlink(missing_file);
+
+		send_socket->bind(send_file);
+		recv_socket->bind(sock_file);
+		NET::UnixDatagramSocket slow_socket;
+		slow_socket.bind(slow_file);
+
+		NET::UnixDatagramSocket::SubscriberSet subscribers;
+		subscribers.add(sock_file);
+		subscribers.add(missing_file);
+		subscribers.add(slow_file);
+		subscribers.add(sock_file);
+		CPPUNIT_ASSERT_EQUAL( size_t(3), subscribers.size() );
+		CPPUNIT_ASSERT_THROW( subscribers.add( std::string(200, 'x')), NET::SocketException );
+
+		// a missing subscriber does not keep the others from receiving
+		CPPUNIT_ASSERT_EQUAL( size_t(2), send_socket->sendToAll( send_msg, len, subscribers) );
+		CPPUNIT_ASSERT_EQUAL( len, subscribers.result(0) );
+		CPPUNIT_ASSERT( subscribers.result(1) < 0 );
+		CPPUNIT_ASSERT_EQUAL( len, subscribers.result(2) );
+
+		std::string source;
+		CPPUNIT_ASSERT_EQUAL( len, recv_socket->timedReceiveFrom( recv_msg, len, source, 10) );
+		CPPUNIT_ASSERT( std::memcmp(send_msg, recv_msg, len) == 0 );
+
+		// the slow subscriber never reads, its queue runs full
+		CPPUNIT_ASSERT( subscribers.remove(missing_file) );
+		CPPUNIT_ASSERT( !subscribers.remove(missing_file) );
+		bool blocked = false;
+		for( int i = 0; i < 10000 && !blocked; ++i)
+		{
+			send_socket->sendToAll( send_msg, len, subscribers);
+			CPPUNIT_ASSERT_EQUAL( len, subscribers.result(0) );
+			CPPUNIT_ASSERT_EQUAL( len, recv_socket->receiveFrom( recv_msg, len, source) );
+			blocked = subscribers.result(1) == -EAGAIN;
+		}
+		CPPUNIT_ASSERT( blocked );
+		CPPUNIT_ASSERT_EQUAL( std::string(slow_file), subscribers.path(1) );
+
+		subscribers.clear();
+		CPPUNIT_ASSERT_EQUAL( size_t(0), send_socket->sendToAll( send_msg, len, subscribers) );
+		::unlink(slow_file);
+		::unlink(send_file);
+	}
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( UnixDatagramSocket_TEST );
@@ -0,0 +1,147 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../UnixSeqPacketSocket.h"
+
+#include <unistd.h>
+#include <cstring>
+#include <vector>
+
+static const char sock_file[] = "/tmp/simple-socket_seqpacket_test.sock";
+
+class UnixSeqPacketSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( UnixSeqPacketSocket_TEST );
+	CPPUNIT_TEST( testBoundaries );
+	CPPUNIT_TEST( testBatch );
+	CPPUNIT_TEST( testEmptyMessages );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::UnixSeqPacketSocket* server_socket;
+	NET::UnixSeqPacketSocket* client_socket;
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::UnixSeqPacketSocket();
+		client_socket = new NET::UnixSeqPacketSocket();
+		server_socket->bind(sock_file);
+		server_socket->listen();
+	}
+
+	void tearDown()
+	{
+		delete server_socket;
+		delete client_socket;
+		::unlink(sock_file);
+	}
+
+	void testBoundaries()
+	{
+		CPPUNIT_ASSERT( !server_socket->timedAccept(10) );
+		client_socket->connect(sock_file);
+		NET::UnixSeqPacketSocket session_socket( server_socket->accept());
+
+		client_socket->send( "first", 5);
+		client_socket->send( "second", 6);
+
+		char buffer[64];
+		CPPUNIT_ASSERT_EQUAL( 5, session_socket.receive( buffer, sizeof(buffer)) );
+		CPPUNIT_ASSERT_EQUAL( 6, session_socket.receive( buffer, sizeof(buffer)) );
+		CPPUNIT_ASSERT( std::memcmp( buffer, "second", 6) == 0 );
+		CPPUNIT_ASSERT_EQUAL( 0, session_socket.timedReceive( buffer, sizeof(buffer), 10) );
+	}
+
+	void testBatch()
+	{
+		client_socket->connect(sock_file);
+		NET::UnixSeqPacketSocket session_socket( server_socket->accept());
+
+		// more messages than fit into a single system call
+		const unsigned count = 150;
+		std::vector<std::vector<char>> messages(count);
+		std::vector<const void*> buffers(count);
+		std::vector<size_t> lens(count);
+		for( unsigned i = 0; i < count; ++i)
+		{
+			messages[i].assign( 1 + i % 50, static_cast<char>(i));
+			buffers[i] = messages[i].data();
+			lens[i] = messages[i].size();
+		}
+		CPPUNIT_ASSERT_EQUAL( count, client_socket->sendBatch( buffers.data(), lens.data(), count) );
+
+		std::vector<std::vector<char>> received( count, std::vector<char>(64));
+		std::vector<void*> recvBuffers(count);
+		std::vector<size_t> maxLens( count, 64);
+		std::vector<size_t> recvLens(count);
+		for( unsigned i = 0; i < count; ++i)
+			recvBuffers[i] = received[i].data();
+
+		unsigned got = 0;
+		while( got < count)
+		{
+			unsigned ret = session_socket.timedReceiveBatch( &recvBuffers[got], &maxLens[got], &recvLens[got], count - got, 100);
+			CPPUNIT_ASSERT( ret > 0 );
+			got += ret;
+		}
+		for( unsigned i = 0; i < count; ++i)
+		{
+			CPPUNIT_ASSERT_EQUAL( lens[i], recvLens[i] );
+			CPPUNIT_ASSERT( std::memcmp( messages[i].data(), received[i].data(), lens[i]) == 0 );
+		}
+
+		CPPUNIT_ASSERT_EQUAL( 0u, session_socket.timedReceiveBatch( recvBuffers.data(), maxLens.data(), recvLens.data(), 4, 10) );
+
+		// the end of the connection is reported by a single empty message
+		client_socket->shutdown( NET::SimpleSocket::STOP_SEND);
+		CPPUNIT_ASSERT_EQUAL( 1u, session_socket.receiveBatch( recvBuffers.data(), maxLens.data(), recvLens.data(), 4) );
+		CPPUNIT_ASSERT_EQUAL( size_t(0), recvLens[0] );
+		CPPUNIT_ASSERT( session_socket.peerDisconnected() );
+	}
+
+	void testEmptyMessages()
+	{
+		client_socket->connect(sock_file);
+		NET::UnixSeqPacketSocket session_socket( server_socket->accept());
+
+		// empty messages within a batch would read like the end of the connection
+		const void* buffers[] = { "a", "", "", "" };
+		size_t lens[] = { 1, 0, 0, 0 };
+		CPPUNIT_ASSERT_THROW( client_socket->sendBatch( buffers, lens, 4), NET::SocketException );
+
+		char storage[8][8];
+		void* recvBuffers[8];
+		size_t maxLens[8];
+		size_t recvLens[8];
+		for( unsigned i = 0; i < 8; ++i)
+		{
+			recvBuffers[i] = storage[i];
+			maxLens[i] = sizeof(storage[i]);
+		}
+		CPPUNIT_ASSERT_EQUAL( 0u, session_socket.timedReceiveBatch( recvBuffers, maxLens, recvLens, 8, 10) );
+
+		// empty messages sent one by one arrive, the connection stays open
+		client_socket->send( "a", 1);
+		client_socket->send( "", 0);
+		client_socket->send( "", 0);
+		client_socket->send( "", 0);
+		CPPUNIT_ASSERT_EQUAL( 4u, session_socket.timedReceiveBatch( recvBuffers, maxLens, recvLens, 8, 100) );
+		CPPUNIT_ASSERT_EQUAL( size_t(1), recvLens[0] );
+		CPPUNIT_ASSERT_EQUAL( size_t(0), recvLens[3] );
+		CPPUNIT_ASSERT( !session_socket.peerDisconnected() );
+
+		// a full batch of empty messages is not taken for the end either
+		client_socket->send( "", 0);
+		client_socket->send( "", 0);
+		CPPUNIT_ASSERT_EQUAL( 2u, session_socket.timedReceiveBatch( recvBuffers, maxLens, recvLens, 2, 100) );
+		CPPUNIT_ASSERT( !session_socket.peerDisconnected() );
+
+		client_socket->send( "b", 1);
+		client_socket->shutdown( NET::SimpleSocket::STOP_SEND);
+		CPPUNIT_ASSERT_EQUAL( 2u, session_socket.receiveBatch( recvBuffers, maxLens, recvLens, 8) );
+		CPPUNIT_ASSERT_EQUAL( size_t(1), recvLens[0] );
+		CPPUNIT_ASSERT_EQUAL( size_t(0), recvLens[1] );
+		CPPUNIT_ASSERT( session_socket.peerDisconnected() );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( UnixSeqPacketSocket_TEST );
@@ -0,0 +1,117 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../UnixStreamSocket.h"
+#include "../TCPSocket.h"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+
+static const char sock_file[] = "/tmp/simple-socket_stream_test.sock";
+static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
+static char recv_msg[sizeof(send_msg)];
+static const int len = sizeof(send_msg);
+
+class UnixStreamSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( UnixStreamSocket_TEST );
+	CPPUNIT_TEST( testAccept );
+	CPPUNIT_TEST( testSendFds );
+	CPPUNIT_TEST( testSendHandle );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	NET::UnixStreamSocket* server_socket;
+	NET::UnixStreamSocket* client_socket;
+
+public:
+	void setUp()
+	{
+		server_socket = new NET::UnixStreamSocket();
+		client_socket = new NET::UnixStreamSocket();
+		server_socket->bind(sock_file);
+		server_socket->listen();
+	}
+
+	void tearDown()
+	{
+		delete server_socket;
+		delete client_socket;
+		::unlink(sock_file);
+	}
+
+	void testAccept()
+	{
+		CPPUNIT_ASSERT( !server_socket->timedAccept(10) );
+
+		client_socket->connect(sock_file);
+		NET::UnixStreamSocket::Handle handle = server_socket->timedAccept(100);
+		CPPUNIT_ASSERT( handle );
+		NET::UnixStreamSocket session_socket(handle);
+		CPPUNIT_ASSERT( !handle );
+		CPPUNIT_ASSERT_EQUAL( std::string(sock_file), client_socket->getForeignPath() );
+
+		CPPUNIT_ASSERT_EQUAL( len, client_socket->sendAll( send_msg, len) );
+		CPPUNIT_ASSERT_EQUAL( len, session_socket.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+
+		client_socket->shutdown( NET::SimpleSocket::STOP_SEND);
+		CPPUNIT_ASSERT_EQUAL( 0, session_socket.receive( recv_msg, len) );
+	}
+
+	void testSendFds()
+	{
+		client_socket->connect(sock_file);
+		NET::UnixStreamSocket session_socket( server_socket->accept());
+
+		int pipefd[2];
+		CPPUNIT_ASSERT( ::pipe(pipefd) == 0 );
+		CPPUNIT_ASSERT_EQUAL( len, client_socket->sendFds( pipefd, 2, send_msg, len) );
+		::close( pipefd[0]);
+		::close( pipefd[1]);
+
+		std::vector<int> fds;
+		CPPUNIT_ASSERT_EQUAL( len, session_socket.receiveFds( recv_msg, len, fds) );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+		CPPUNIT_ASSERT_EQUAL( size_t(2), fds.size() );
+		CPPUNIT_ASSERT( ::fcntl( fds[0], F_GETFD) & FD_CLOEXEC );
+
+		// the received descriptors refer to the same pipe
+		CPPUNIT_ASSERT_EQUAL( ssize_t(len), ::write( fds[1], send_msg, len) );
+		CPPUNIT_ASSERT_EQUAL( ssize_t(len), ::read( fds[0], recv_msg, len) );
+		::close( fds[0]);
+		::close( fds[1]);
+
+		int fd = 0;
+		CPPUNIT_ASSERT_THROW( client_socket->sendFds( &fd, 0), NET::SocketException );
+	}
+
+	void testSendHandle()
+	{
+		client_socket->connect(sock_file);
+		NET::UnixStreamSocket session_socket( server_socket->accept());
+
+		NET::TCPSocket tcp_server;
+		NET::TCPSocket tcp_client;
+		tcp_server.bind( "127.0.0.1", 47777);
+		tcp_server.listen();
+		tcp_client.connect( "127.0.0.1", 47777);
+
+		NET::TCPSocket::Handle accepted = tcp_server.accept();
+		client_socket->sendHandle( accepted);
+		CPPUNIT_ASSERT( !accepted );
+
+		NET::TCPSocket::Handle received = session_socket.receiveHandle<NET::TCPSocket>();
+		CPPUNIT_ASSERT( received );
+		NET::TCPSocket connection( received);
+
+		tcp_client.send( send_msg, len);
+		CPPUNIT_ASSERT_EQUAL( len, connection.receive( recv_msg, len) );
+		CPPUNIT_ASSERT( std::memcmp( send_msg, recv_msg, len) == 0 );
+		tcp_client.disconnect();
+
+		client_socket->shutdown( NET::SimpleSocket::STOP_SEND);
+		CPPUNIT_ASSERT( !session_socket.receiveHandle<NET::TCPSocket>() );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( UnixStreamSocket_TEST );
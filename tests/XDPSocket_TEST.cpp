@@ -0,0 +1,80 @@
+#include <cppunit/extensions/HelperMacros.h>
+#include "../XDPSocket.h"
+
+#include <cstring>
+
+// The test expects a pair of virtual ethernet interfaces:
+//   ip link add xdp0 type veth peer name xdp1
+//   ip link set xdp0 up
+//   ip link set xdp1 up
+
+static const char send_msg[] = "The quick brown fox jumps over the lazy dog";
+static const int len = sizeof(send_msg);
+
+// IEEE 802 local experimental ethertype
+static const uint8_t ether_type[] = { 0x88, 0xb5 };
+
+class XDPSocket_TEST : public CppUnit::TestFixture
+{
+	CPPUNIT_TEST_SUITE( XDPSocket_TEST );
+	CPPUNIT_TEST( testTransmitReceive );
+	CPPUNIT_TEST_SUITE_END();
+
+private:
+	uint8_t test_frame[14 + sizeof(send_msg)];
+
+public:
+	void setUp()
+	{
+		// broadcast, so the peer does not filter the frames
+		std::memset( test_frame, 0xff, 6);
+		std::memset( test_frame + 6, 0x02, 6);
+		std::memcpy( test_frame + 12, ether_type, 2);
+		std::memcpy( test_frame + 14, send_msg, len);
+	}
+
+	void tearDown() {}
+
+	void testTransmitReceive()
+	{
+		CPPUNIT_ASSERT_THROW( NET::XDPSocket( "xdp1", 0, 64, 1000), NET::SocketException );
+
+		NET::XDPSocket send_socket( "xdp0", 0, 64);
+		NET::XDPSocket recv_socket( "xdp1", 0, 64);
+
+		// more frames than transmit frames are available
+		const unsigned count = 48;
+		const void* frames[count];
+		size_t lens[count];
+		for( unsigned i = 0; i < count; ++i)
+		{
+			frames[i] = test_frame;
+			lens[i] = sizeof(test_frame);
+		}
+		CPPUNIT_ASSERT_EQUAL( 32u, send_socket.send( frames, lens, count) );
+
+		unsigned received = 0;
+		NET::XDPSocket::Frame batch[16];
+		unsigned n;
+		while( (n = recv_socket.receive( batch, 16, 100)) > 0)
+		{
+			for( unsigned i = 0; i < n; ++i)
+			{
+				// other traffic on the interface is skipped
+				if( batch[i].len != sizeof(test_frame) || std::memcmp( batch[i].data + 12, ether_type, 2) != 0)
+					continue;
+				CPPUNIT_ASSERT( std::memcmp( batch[i].data + 14, send_msg, len) == 0 );
+				++received;
+			}
+			recv_socket.release( batch, n);
+		}
+		CPPUNIT_ASSERT_EQUAL( 32u, received );
+		CPPUNIT_ASSERT_EQUAL( 0u, send_socket.pending() );
+
+		// completed frames are reused
+		CPPUNIT_ASSERT_EQUAL( 16u, send_socket.send( frames, lens, 16) );
+		CPPUNIT_ASSERT_EQUAL( 0ull, static_cast<unsigned long long>( recv_socket.statistics().rxInvalid) );
+	}
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( XDPSocket_TEST );